@@ -0,0 +1,162 @@
+﻿#include "BallStore.h"
+#include "SnapshotProtocol.h"
+
+void BallPath::assign(const std::vector<std::pair<int, int>>& newSteps, size_t skip) {
+    steps.clear();
+    next = 0;
+    waypoints.clear();
+    nextWaypoint = 0;
+    if (skip < newSteps.size()) steps.insert(steps.end(), newSteps.begin() + skip, newSteps.end());
+}
+
+void BallPath::assignRoute(const std::vector<std::pair<int, int>>& route) {
+    steps.clear();
+    next = 0;
+    waypoints.clear();
+    nextWaypoint = 0;
+    if (route.size() > 1) waypoints.insert(waypoints.end(), route.begin() + 1, route.end());
+}
+
+void BallPath::appendSteps(const std::vector<std::pair<int, int>>& newSteps, size_t skip) {
+    // Drop the steps already taken so the vector does not grow over a long trip
+    steps.erase(steps.begin(), steps.begin() + next);
+    next = 0;
+    if (skip < newSteps.size()) steps.insert(steps.end(), newSteps.begin() + skip, newSteps.end());
+}
+
+BallStore::BallStore() : nextId(1) {}
+
+void BallStore::clear() {
+    ids.clear();
+    xs.clear();
+    ys.clear();
+    hps.clear();
+    cooldowns.clear();
+    teams.clear();
+    dirtyMasks.clear();
+    paths.clear();
+    // Handles into the old battle must not resolve to balls of the next one
+    for (BallHandle handle : handles) retireHandle(handle);
+    handles.clear();
+    nextId = 1;
+}
+
+void BallStore::reserve(size_t count) {
+    ids.reserve(count);
+    xs.reserve(count);
+    ys.reserve(count);
+    hps.reserve(count);
+    cooldowns.reserve(count);
+    teams.reserve(count);
+    dirtyMasks.reserve(count);
+    paths.reserve(count);
+    handles.reserve(count);
+}
+
+size_t BallStore::add(int x, int y, int hp, bool isRed) {
+    ids.push_back(nextId++);
+    xs.push_back(x);
+    ys.push_back(y);
+    hps.push_back(hp);
+    cooldowns.push_back(0);
+    teams.push_back(isRed ? 1 : 0);
+    dirtyMasks.push_back(SnapshotProtocol::FIELD_ALL);  // New balls are sent in full
+    paths.emplace_back();
+    handles.push_back(issueHandle(ids.size() - 1));
+    return ids.size() - 1;
+}
+
+void BallStore::removeDead(std::vector<uint32_t>& removedIds) {
+    size_t count = ids.size();
+    size_t write = 0;
+
+    for (size_t read = 0; read < count; ++read) {
+        if (hps[read] <= 0) {
+            removedIds.push_back(ids[read]);
+            retireHandle(handles[read]);
+            continue;
+        }
+
+        if (write != read) {
+            ids[write] = ids[read];
+            xs[write] = xs[read];
+            ys[write] = ys[read];
+            hps[write] = hps[read];
+            cooldowns[write] = cooldowns[read];
+            teams[write] = teams[read];
+            dirtyMasks[write] = dirtyMasks[read];
+            std::swap(paths[write], paths[read]);  // Keeps both step buffers alive for reuse
+            handles[write] = handles[read];
+            if (!handles[write].isNull()) handleSlots[handles[write].index()] = static_cast<uint32_t>(write);
+        }
+        ++write;
+    }
+
+    if (write == count) return;
+
+    ids.resize(write);
+    xs.resize(write);
+    ys.resize(write);
+    hps.resize(write);
+    cooldowns.resize(write);
+    teams.resize(write);
+    dirtyMasks.resize(write);
+    paths.resize(write);
+    handles.resize(write);
+}
+
+bool BallStore::resolve(BallHandle handle, size_t& slot) const {
+    uint32_t index = handle.index();
+    if (handle.isNull() || index >= handleSlots.size() || handleGenerations[index] != handle.generation()) return false;
+    slot = handleSlots[index];
+    return true;
+}
+
+BallHandle BallStore::issueHandle(size_t slot) {
+    uint32_t index;
+    if (!freeHandles.empty()) {
+        index = freeHandles.back();
+        freeHandles.pop_back();
+    }
+    else if (handleSlots.size() <= BallHandle::INDEX_MASK) {
+        index = static_cast<uint32_t>(handleSlots.size());
+        handleSlots.push_back(0);
+        handleGenerations.push_back(1);
+    }
+    else {
+        return BallHandle();
+    }
+
+    handleSlots[index] = static_cast<uint32_t>(slot);
+    BallHandle handle;
+    handle.value = (static_cast<uint32_t>(handleGenerations[index]) << BallHandle::INDEX_BITS) | index;
+    return handle;
+}
+
+void BallStore::retireHandle(BallHandle handle) {
+    if (handle.isNull()) return;
+    uint32_t index = handle.index();
+    // Generations wrap past 0, which would let index 0 issue the null handle
+    uint16_t generation = static_cast<uint16_t>((handleGenerations[index] + 1) & BallHandle::GENERATION_MASK);
+    handleGenerations[index] = generation == 0 ? 1 : generation;
+    freeHandles.push_back(index);
+}
+
+void BallStore::reissueHandles() {
+    for (BallHandle handle : handles) retireHandle(handle);
+    handles.resize(ids.size());
+    for (size_t i = 0; i < handles.size(); ++i) handles[i] = issueHandle(i);
+}
+
+void BallStore::setPosition(size_t i, int x, int y) {
+    if (xs[i] == x && ys[i] == y) return;
+    xs[i] = x;
+    ys[i] = y;
+    dirtyMasks[i] |= SnapshotProtocol::FIELD_POSITION;
+}
+
+bool BallStore::takeDamage(size_t i, int amount) {
+    hps[i] -= amount;
+    dirtyMasks[i] |= SnapshotProtocol::FIELD_HP;
+    return isDead(i);
+}
@@ -0,0 +1,151 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Combat and spawn parameters shared by every ball
+struct BallStats {
+    static const int ATTACK_RANGE = 1;
+    static const int ATTACK_RATE = 3;
+    static const int MIN_HP = 2;
+    static const int MAX_HP = 5;
+};
+
+// Remaining steps of a ball's cached path. Kept out of line from the hot
+// columns; the step vector is reused so replanning does not reallocate.
+// A hierarchical route also keeps the waypoints not yet refined into steps.
+class BallPath {
+public:
+    bool empty() const { return next >= steps.size(); }
+    size_t size() const { return steps.size() - next; }
+    const std::pair<int, int>& front() const { return steps[next]; }
+    const std::pair<int, int>& back() const { return steps.back(); }
+    void pop() { ++next; }
+    void clear() { steps.clear(); next = 0; waypoints.clear(); nextWaypoint = 0; }
+
+    // Replaces the path, skipping the first `skip` steps of newSteps
+    void assign(const std::vector<std::pair<int, int>>& newSteps, size_t skip);
+
+    // Replaces the path with a route to refine later, dropping the first
+    // waypoint (the current position)
+    void assignRoute(const std::vector<std::pair<int, int>>& route);
+    bool hasPendingWaypoints() const { return nextWaypoint < waypoints.size(); }
+    const std::pair<int, int>& pendingWaypoint() const { return waypoints[nextWaypoint]; }
+    void popWaypoint() { ++nextWaypoint; }
+    // Appends a refined segment, skipping the first `skip` steps of newSteps
+    void appendSteps(const std::vector<std::pair<int, int>>& newSteps, size_t skip);
+
+    // Where the path ends once every waypoint has been refined
+    const std::pair<int, int>& destination() const { return waypoints.empty() ? steps.back() : waypoints.back(); }
+
+private:
+    std::vector<std::pair<int, int>> steps;
+    size_t next = 0;
+    std::vector<std::pair<int, int>> waypoints;
+    size_t nextWaypoint = 0;
+
+    friend class Checkpoint;
+};
+
+// Reference to a ball that survives slot compaction: the low INDEX_BITS are
+// an entry in the store's handle table, the rest that entry's generation.
+// The generation moves on when the ball dies, so a handle kept past its
+// ball's death resolves to nothing instead of to whoever reuses the entry.
+// Generations are only GENERATION_MASK wide and skip 0, so after 4095 reuses
+// of one entry they come round again: a handle held that long can resolve
+// to the entry's current ball. Stale handles are caught, not ruled out.
+struct BallHandle {
+    static constexpr uint32_t INDEX_BITS = 20;  // Enough for max-units
+    static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static constexpr uint32_t GENERATION_MASK = (1u << (32 - INDEX_BITS)) - 1;
+
+    uint32_t value = 0;  // 0 is never issued
+
+    bool isNull() const { return value == 0; }
+    uint32_t index() const { return value & INDEX_MASK; }
+    uint32_t generation() const { return value >> INDEX_BITS; }
+    bool operator==(BallHandle other) const { return value == other.value; }
+    bool operator!=(BallHandle other) const { return value != other.value; }
+};
+
+// Structure-of-arrays storage for every ball in a simulation. Each field is a
+// contiguous column indexed by ball slot, so hot loops stream through memory
+// instead of chasing one heap object per ball. Slots are compacted in order
+// when dead balls are removed, so indices are only stable within a tick;
+// keep a BallHandle to refer to a ball for longer.
+class BallStore {
+public:
+    BallStore();
+
+    size_t size() const { return ids.size(); }
+    bool empty() const { return ids.empty(); }
+
+    void clear();
+    void reserve(size_t count);
+
+    // Appends a ball with a fresh ID and handle and returns its slot
+    size_t add(int x, int y, int hp, bool isRed);
+
+    // Drops dead balls in one stable pass and appends their IDs to removedIds
+    void removeDead(std::vector<uint32_t>& removedIds);
+
+    // Per-slot accessors
+    uint32_t getID(size_t i) const { return ids[i]; }
+    int getX(size_t i) const { return xs[i]; }
+    int getY(size_t i) const { return ys[i]; }
+    int getHp(size_t i) const { return hps[i]; }
+    bool isRedTeam(size_t i) const { return teams[i] != 0; }
+    bool isDead(size_t i) const { return hps[i] <= 0; }
+    int getCooldown(size_t i) const { return cooldowns[i]; }
+    uint8_t getDirtyMask(size_t i) const { return dirtyMasks[i]; }
+    // Null only if the handle table is full, which max-units rules out
+    BallHandle getHandle(size_t i) const { return handles[i]; }
+
+    // Current slot of the ball behind handle; false once it has been removed
+    // or the store cleared
+    bool resolve(BallHandle handle, size_t& slot) const;
+
+    void setPosition(size_t i, int x, int y);
+    void setCooldown(size_t i, int value) { cooldowns[i] = value; }
+    void clearDirtyMask(size_t i) { dirtyMasks[i] = 0; }
+    bool takeDamage(size_t i, int amount);  // Returns true if killed
+
+    BallPath& path(size_t i) { return paths[i]; }
+
+    // Raw columns for kernels that scan many balls at once
+    const int32_t* xData() const { return xs.data(); }
+    const int32_t* yData() const { return ys.data(); }
+    const int32_t* hpData() const { return hps.data(); }
+    const uint8_t* teamData() const { return teams.data(); }
+
+    uint32_t getNextID() const { return nextId; }
+
+private:
+    BallHandle issueHandle(size_t slot);
+    void retireHandle(BallHandle handle);
+    // Retires every handle and issues new ones for the current slots, after
+    // the columns were replaced wholesale
+    void reissueHandles();
+
+    std::vector<uint32_t> ids;
+    std::vector<int32_t> xs;
+    std::vector<int32_t> ys;
+    std::vector<int32_t> hps;
+    std::vector<int32_t> cooldowns;
+    std::vector<uint8_t> teams;       // 1 = red, 0 = blue
+    std::vector<uint8_t> dirtyMasks;  // SnapshotProtocol::FieldMask bits since the last snapshot
+    std::vector<BallPath> paths;      // Cold data, touched only when moving
+    std::vector<BallHandle> handles;
+
+    // Handle table, grown to the most balls ever alive at once and then only
+    // recycled: entries of dead balls go on a free list for the next add
+    std::vector<uint32_t> handleSlots;        // Slot of each entry's ball
+    std::vector<uint16_t> handleGenerations;  // Generation a valid handle must carry
+    std::vector<uint32_t> freeHandles;
+
+    uint32_t nextId;  // IDs are unique per store, starting at 1
+
+    friend class Checkpoint;
+};
@@ -0,0 +1,113 @@
+﻿#include "BatchRunner.h"
+#include "SimulationManager.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
+namespace BatchRunner {
+
+namespace {
+
+double percent(size_t part, size_t whole) {
+    return whole ? 100.0 * part / whole : 0.0;
+}
+
+// Nearest-rank percentile of an ascending list
+uint32_t percentile(const std::vector<uint32_t>& sorted, int p) {
+    return sorted[(sorted.size() - 1) * p / 100];
+}
+
+}  // namespace
+
+BattleResult runBattle(const Options& options, uint32_t battleIndex) {
+    SimulationManager sim(options.config);
+    sim.setEventLogging(false);
+    if (options.obstacles) sim.setObstacleMap(*options.obstacles);
+
+    sim.initialize((uint64_t(options.seed) << 32) | battleIndex);
+
+    while (!sim.isGameOver() && sim.getTick() < options.maxTicks) sim.stepSimulation();
+
+    BattleResult result;
+    result.ticks = sim.getTick();
+    result.survivors = 0;
+    result.survivorHp = 0;
+
+    // Same verdict as removeDeadBalls: blue takes a mutual wipe-out
+    bool redExists = false;
+    const BallStore& balls = sim.getBalls();
+    for (size_t i = 0; i < balls.size(); ++i) {
+        if (balls.isRedTeam(i)) redExists = true;
+        result.survivors++;
+        result.survivorHp += static_cast<uint32_t>(balls.getHp(i));
+    }
+
+    if (!sim.isGameOver()) result.outcome = Outcome::Timeout;
+    else result.outcome = redExists ? Outcome::RedWins : Outcome::BlueWins;
+    return result;
+}
+
+Report run(const Options& options) {
+    Report report;
+    report.battles.resize(options.battles);
+
+    ThreadPool pool(options.threads);
+    report.threads = pool.getThreadCount();
+
+    auto start = std::chrono::steady_clock::now();
+    pool.parallelFor(options.battles, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            report.battles[i] = runBattle(options, static_cast<uint32_t>(i));
+        }
+    });
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+void printReport(const Report& report, std::ostream& out) {
+    size_t total = report.battles.size();
+    size_t redWins = 0, blueWins = 0, timeouts = 0;
+    uint64_t winSurvivors = 0, winHp = 0;
+    std::vector<uint32_t> lengths;
+    lengths.reserve(total);
+
+    for (const BattleResult& battle : report.battles) {
+        lengths.push_back(battle.ticks);
+        if (battle.outcome == Outcome::Timeout) {
+            timeouts++;
+            continue;
+        }
+        if (battle.outcome == Outcome::RedWins) redWins++;
+        else blueWins++;
+        winSurvivors += battle.survivors;
+        winHp += battle.survivorHp;
+    }
+
+    out << std::fixed << std::setprecision(1);
+    out << "[Batch] " << total << " battles on " << report.threads << " threads in "
+        << std::setprecision(2) << report.seconds << " s ("
+        << std::setprecision(1) << (report.seconds > 0 ? total / report.seconds : 0.0) << " battles/s)\n";
+    if (total == 0) return;
+
+    out << "[Batch] Red wins:  " << redWins << " (" << percent(redWins, total) << "%)\n";
+    out << "[Batch] Blue wins: " << blueWins << " (" << percent(blueWins, total) << "%)\n";
+    out << "[Batch] Timeouts:  " << timeouts << " (" << percent(timeouts, total) << "%)\n";
+
+    std::sort(lengths.begin(), lengths.end());
+    uint64_t tickSum = 0;
+    for (uint32_t ticks : lengths) tickSum += ticks;
+    out << "[Batch] Battle length (ticks): mean " << static_cast<double>(tickSum) / total
+        << ", min " << lengths.front() << ", p10 " << percentile(lengths, 10) << ", p25 " << percentile(lengths, 25)
+        << ", median " << percentile(lengths, 50) << ", p75 " << percentile(lengths, 75)
+        << ", p90 " << percentile(lengths, 90) << ", p99 " << percentile(lengths, 99)
+        << ", max " << lengths.back() << "\n";
+
+    size_t wins = redWins + blueWins;
+    if (wins > 0) {
+        out << "[Batch] Survivors per win: " << static_cast<double>(winSurvivors) / wins << " units, "
+            << static_cast<double>(winHp) / wins << " HP\n";
+    }
+}
+
+}  // namespace BatchRunner
@@ -0,0 +1,51 @@
+﻿#pragma once
+
+#include "GameConfig.h"
+#include "ObstacleMap.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Headless Monte Carlo mode: runs many independent battles back to back with
+// no networking, pacing or per-event output, spread over a thread pool, and
+// aggregates the outcomes for balance tuning.
+namespace BatchRunner {
+
+struct Options {
+    size_t battles = 1000;
+    size_t threads = 0;        // 0 = one per hardware thread
+    uint32_t seed = 42;        // Battle i is seeded from (seed, i)
+    uint32_t maxTicks = 10000; // Battles still running after this many ticks count as timeouts
+    GameConfig config;         // Grid size, unit count and movement settings of every battle
+    const ObstacleMap* obstacles = nullptr;  // Open grid when null
+};
+
+enum class Outcome : uint8_t {
+    RedWins,
+    BlueWins,
+    Timeout
+};
+
+struct BattleResult {
+    Outcome outcome;
+    uint32_t ticks;
+    uint32_t survivors;   // Units left on the winning side
+    uint32_t survivorHp;  // Their combined HP
+};
+
+struct Report {
+    std::vector<BattleResult> battles;  // In battle order, independent of thread count
+    size_t threads = 0;
+    double seconds = 0;
+};
+
+// Runs one battle to completion with the given seed
+BattleResult runBattle(const Options& options, uint32_t battleIndex);
+
+Report run(const Options& options);
+
+// Win rates, battle length percentiles, survivor statistics and throughput
+void printReport(const Report& report, std::ostream& out);
+
+}  // namespace BatchRunner
@@ -0,0 +1,288 @@
+﻿#include "Checkpoint.h"
+#include "Log.h"
+#include "MappedFile.h"
+#include "SimulationManager.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+const char Checkpoint::MAGIC[4] = { 'B', 'S', 'C', 'P' };
+
+namespace {
+
+std::atomic<bool> saveRequested(false);
+
+// Lays out sections back to back and writes them in the same order
+class SectionWriter {
+public:
+    explicit SectionWriter(Checkpoint::Header& fileHeader) : header(fileHeader), end(sizeof(Checkpoint::Header)) {}
+
+    void plan(Checkpoint::Section section, size_t bytes) {
+        end = align(end);
+        header.sections[section] = { end, bytes };
+        end += bytes;
+    }
+
+    template <typename T>
+    void write(std::ofstream& file, Checkpoint::Section section, const T* data) {
+        static const char padding[Checkpoint::SECTION_ALIGNMENT] = {};
+        const Checkpoint::SectionEntry& entry = header.sections[section];
+        file.write(padding, static_cast<std::streamsize>(entry.offset - written));
+        file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(entry.size));
+        written = entry.offset + entry.size;
+    }
+
+private:
+    static uint64_t align(uint64_t offset) {
+        return (offset + Checkpoint::SECTION_ALIGNMENT - 1) / Checkpoint::SECTION_ALIGNMENT * Checkpoint::SECTION_ALIGNMENT;
+    }
+
+    Checkpoint::Header& header;
+    uint64_t end;
+    uint64_t written = sizeof(Checkpoint::Header);
+};
+
+// Typed view of one section of a mapped checkpoint
+template <typename T>
+const T* sectionData(const MappedFile& file, const Checkpoint::Header& header, Checkpoint::Section section) {
+    return reinterpret_cast<const T*>(file.data() + header.sections[section].offset);
+}
+
+template <typename T>
+size_t sectionCount(const Checkpoint::Header& header, Checkpoint::Section section) {
+    return static_cast<size_t>(header.sections[section].size / sizeof(T));
+}
+
+template <typename T>
+void assignSection(std::vector<T>& column, const MappedFile& file, const Checkpoint::Header& header, Checkpoint::Section section) {
+    const T* first = sectionData<T>(file, header, section);
+    column.assign(first, first + sectionCount<T>(header, section));
+}
+
+void appendPairs(std::vector<int32_t>& out, const std::vector<std::pair<int, int>>& pairs) {
+    for (const std::pair<int, int>& pair : pairs) {
+        out.push_back(pair.first);
+        out.push_back(pair.second);
+    }
+}
+
+void assignPairs(std::vector<std::pair<int, int>>& pairs, const int32_t* xy, size_t count) {
+    pairs.resize(count);
+    for (size_t i = 0; i < count; ++i) pairs[i] = { xy[2 * i], xy[2 * i + 1] };
+}
+
+}  // namespace
+
+bool Checkpoint::save(const SimulationManager& simulation, const std::string& path) {
+    const BallStore& balls = simulation.balls;
+    const ObstacleMap& obstacles = simulation.obstacles;
+    const size_t count = balls.size();
+
+    // Paths are the only per-ball data not already in flat columns
+    std::vector<uint32_t> stepCounts(count), stepCursors(count), waypointCounts(count), waypointCursors(count);
+    std::vector<int32_t> steps, waypoints;
+    for (size_t i = 0; i < count; ++i) {
+        const BallPath& path = balls.paths[i];
+        stepCounts[i] = static_cast<uint32_t>(path.steps.size());
+        stepCursors[i] = static_cast<uint32_t>(path.next);
+        waypointCounts[i] = static_cast<uint32_t>(path.waypoints.size());
+        waypointCursors[i] = static_cast<uint32_t>(path.nextWaypoint);
+        appendPairs(steps, path.steps);
+        appendPairs(waypoints, path.waypoints);
+    }
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.gridSize = static_cast<uint32_t>(simulation.config.gridSize);
+    header.clusterSize = static_cast<uint32_t>(simulation.config.hierarchicalClusterSize);
+    header.movementMode = static_cast<uint8_t>(simulation.movementMode);
+    header.hierarchical = simulation.hierarchical ? 1 : 0;
+    header.parallel = simulation.workerPool ? 1 : 0;
+    header.tick = simulation.tickCount;
+    header.nextId = balls.nextId;
+    header.seed = simulation.seed;
+    header.publishCount = simulation.publishCount;
+    header.ballCount = count;
+    header.blockedCount = obstacles.blockedCount;
+
+    SectionWriter sections(header);
+    sections.plan(IDS, count * sizeof(uint32_t));
+    sections.plan(XS, count * sizeof(int32_t));
+    sections.plan(YS, count * sizeof(int32_t));
+    sections.plan(HPS, count * sizeof(int32_t));
+    sections.plan(COOLDOWNS, count * sizeof(int32_t));
+    sections.plan(TEAMS, count);
+    sections.plan(DIRTY_MASKS, count);
+    sections.plan(STEP_COUNTS, count * sizeof(uint32_t));
+    sections.plan(STEP_CURSORS, count * sizeof(uint32_t));
+    sections.plan(WAYPOINT_COUNTS, count * sizeof(uint32_t));
+    sections.plan(WAYPOINT_CURSORS, count * sizeof(uint32_t));
+    sections.plan(STEPS, steps.size() * sizeof(int32_t));
+    sections.plan(WAYPOINTS, waypoints.size() * sizeof(int32_t));
+    sections.plan(REMOVED_IDS, simulation.removedIds.size() * sizeof(uint32_t));
+    sections.plan(OBSTACLE_BITS, obstacles.bits.size() * sizeof(uint64_t));
+    sections.plan(WINNING_TEAM, simulation.winningTeam.size());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        LOG_ERROR("[Server] Cannot create checkpoint file: {}", path);
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    sections.write(file, IDS, balls.ids.data());
+    sections.write(file, XS, balls.xs.data());
+    sections.write(file, YS, balls.ys.data());
+    sections.write(file, HPS, balls.hps.data());
+    sections.write(file, COOLDOWNS, balls.cooldowns.data());
+    sections.write(file, TEAMS, balls.teams.data());
+    sections.write(file, DIRTY_MASKS, balls.dirtyMasks.data());
+    sections.write(file, STEP_COUNTS, stepCounts.data());
+    sections.write(file, STEP_CURSORS, stepCursors.data());
+    sections.write(file, WAYPOINT_COUNTS, waypointCounts.data());
+    sections.write(file, WAYPOINT_CURSORS, waypointCursors.data());
+    sections.write(file, STEPS, steps.data());
+    sections.write(file, WAYPOINTS, waypoints.data());
+    sections.write(file, REMOVED_IDS, simulation.removedIds.data());
+    sections.write(file, OBSTACLE_BITS, obstacles.bits.data());
+    sections.write(file, WINNING_TEAM, simulation.winningTeam.data());
+
+    file.close();
+    if (!file) {
+        LOG_ERROR("[Server] Failed writing checkpoint file: {}", path);
+        return false;
+    }
+    return true;
+}
+
+bool Checkpoint::restore(SimulationManager& simulation, const std::string& path) {
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    Header header;
+    if (file.size() < sizeof(header) || std::memcmp(file.data(), MAGIC, sizeof(MAGIC)) != 0) {
+        LOG_ERROR("[Server] {} is not a checkpoint file", path);
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.byteOrder != BYTE_ORDER_MARK) {
+        LOG_ERROR("[Server] {} was written on a machine with a different byte order", path);
+        return false;
+    }
+    if (header.version != VERSION) {
+        LOG_ERROR("[Server] {} is checkpoint version {}, expected {}", path, header.version, VERSION);
+        return false;
+    }
+
+    // Check every size before touching the simulation, so a damaged file changes nothing
+    const size_t count = static_cast<size_t>(header.ballCount);
+    const size_t wordsPerRow = (header.gridSize + 63) / 64;
+    const uint64_t expectedSizes[SECTION_COUNT] = {
+        count * sizeof(uint32_t), count * sizeof(int32_t), count * sizeof(int32_t), count * sizeof(int32_t),
+        count * sizeof(int32_t), count, count,
+        count * sizeof(uint32_t), count * sizeof(uint32_t), count * sizeof(uint32_t), count * sizeof(uint32_t),
+        0, 0, 0, static_cast<uint64_t>(wordsPerRow) * header.gridSize * sizeof(uint64_t), 0
+    };
+    bool valid = header.gridSize >= 3 && header.gridSize <= 65535 && header.clusterSize >= 4 &&
+        header.movementMode <= static_cast<uint8_t>(MovementMode::FlowField);
+    for (uint32_t section = 0; section < SECTION_COUNT && valid; ++section) {
+        const SectionEntry& entry = header.sections[section];
+        valid = entry.offset % SECTION_ALIGNMENT == 0 && entry.offset <= file.size() &&
+            entry.size <= file.size() - entry.offset &&
+            (expectedSizes[section] == 0 || entry.size == expectedSizes[section]);
+    }
+
+    const uint32_t* stepCounts = valid ? sectionData<uint32_t>(file, header, STEP_COUNTS) : nullptr;
+    const uint32_t* stepCursors = valid ? sectionData<uint32_t>(file, header, STEP_CURSORS) : nullptr;
+    const uint32_t* waypointCounts = valid ? sectionData<uint32_t>(file, header, WAYPOINT_COUNTS) : nullptr;
+    const uint32_t* waypointCursors = valid ? sectionData<uint32_t>(file, header, WAYPOINT_CURSORS) : nullptr;
+    uint64_t totalSteps = 0, totalWaypoints = 0;
+    for (size_t i = 0; i < count && valid; ++i) {
+        valid = stepCursors[i] <= stepCounts[i] && waypointCursors[i] <= waypointCounts[i];
+        totalSteps += stepCounts[i];
+        totalWaypoints += waypointCounts[i];
+    }
+    valid = valid && header.sections[STEPS].size == totalSteps * 2 * sizeof(int32_t) &&
+        header.sections[WAYPOINTS].size == totalWaypoints * 2 * sizeof(int32_t) &&
+        header.sections[REMOVED_IDS].size % sizeof(uint32_t) == 0;
+    if (!valid) {
+        LOG_ERROR("[Server] {} is damaged or cut short", path);
+        return false;
+    }
+
+    // Columns are copied straight out of the mapping
+    BallStore& balls = simulation.balls;
+    assignSection(balls.ids, file, header, IDS);
+    assignSection(balls.xs, file, header, XS);
+    assignSection(balls.ys, file, header, YS);
+    assignSection(balls.hps, file, header, HPS);
+    assignSection(balls.cooldowns, file, header, COOLDOWNS);
+    assignSection(balls.teams, file, header, TEAMS);
+    assignSection(balls.dirtyMasks, file, header, DIRTY_MASKS);
+    balls.nextId = header.nextId;
+    balls.reissueHandles();  // Handles are not saved; the restored balls get new ones
+
+    const int32_t* steps = sectionData<int32_t>(file, header, STEPS);
+    const int32_t* waypoints = sectionData<int32_t>(file, header, WAYPOINTS);
+    balls.paths.assign(count, BallPath());
+    for (size_t i = 0; i < count; ++i) {
+        BallPath& ballPath = balls.paths[i];
+        assignPairs(ballPath.steps, steps, stepCounts[i]);
+        ballPath.next = stepCursors[i];
+        assignPairs(ballPath.waypoints, waypoints, waypointCounts[i]);
+        ballPath.nextWaypoint = waypointCursors[i];
+        steps += 2 * static_cast<size_t>(stepCounts[i]);
+        waypoints += 2 * static_cast<size_t>(waypointCounts[i]);
+    }
+
+    ObstacleMap& obstacles = simulation.obstacles;
+    obstacles = ObstacleMap(static_cast<int>(header.gridSize), static_cast<int>(header.gridSize));
+    assignSection(obstacles.bits, file, header, OBSTACLE_BITS);
+    obstacles.blockedCount = static_cast<size_t>(header.blockedCount);
+
+    assignSection(simulation.removedIds, file, header, REMOVED_IDS);
+    const char* winner = sectionData<char>(file, header, WINNING_TEAM);
+    simulation.winningTeam.assign(winner, static_cast<size_t>(header.sections[WINNING_TEAM].size));
+    simulation.seed = header.seed;
+    simulation.tickCount = header.tick;
+    simulation.publishCount = header.publishCount;
+
+    // Settings that change how the battle plays out follow the checkpoint
+    GameConfig& config = simulation.config;
+    config.gridSize = static_cast<int>(header.gridSize);
+    config.hierarchicalClusterSize = static_cast<int>(header.clusterSize);
+    simulation.hierarchical = header.hierarchical != 0;
+    simulation.movementMode = static_cast<MovementMode>(header.movementMode);
+    config.movementMode = simulation.movementMode;
+    if (header.parallel && !simulation.workerPool) {
+        // Any thread count gives the same ticks, so only the mode has to match
+        size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        LOG_WARNING("[Server] Checkpoint was taken with worker threads; moving with {}", threads);
+        simulation.workerPool.reset(new ThreadPool(threads));
+        config.workerThreads = static_cast<int>(threads);
+    }
+    else if (!header.parallel && simulation.workerPool) {
+        LOG_WARNING("[Server] Checkpoint was taken without worker threads; moving in place");
+        simulation.workerPool.reset();
+        config.workerThreads = 0;
+    }
+
+    simulation.rebuildPathfinder();
+    simulation.spatialGrid.rebuild(balls, config.gridSize);
+    return true;
+}
+
+void Checkpoint::requestSave() {
+    saveRequested.store(true, std::memory_order_relaxed);
+}
+
+bool Checkpoint::takeSaveRequest() {
+    // One step, so a signal arriving while the flag is cleared is not lost
+    return saveRequested.exchange(false, std::memory_order_relaxed);
+}
@@ -0,0 +1,91 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+class SimulationManager;
+
+// Checkpoint file layout, in the byte order of the machine that wrote it:
+//   header:   the Header struct below, copied as it is
+//   sections: one raw array per section, each starting on a SECTION_ALIGNMENT
+//             boundary, at the offset and byte size the header lists
+//
+// Every ball column but the handles is stored as the BallStore holds it. Cached paths are
+// flattened: per ball, the length of its step and waypoint lists and how far
+// along each it is, with all steps (and all waypoints) as x, y pairs back to
+// back in slot order. The obstacle bitset goes in word for word. Spatial
+// grid, flow field and pathfinder tables are rebuilt from those on restore.
+// Ball handles only mean something in memory, so restored balls get new
+// ones. Random draws need only the seed and tick because they are counter
+// based (see CounterRng.h).
+class Checkpoint {
+public:
+    enum Section : uint32_t {
+        IDS,
+        XS,
+        YS,
+        HPS,
+        COOLDOWNS,
+        TEAMS,
+        DIRTY_MASKS,
+        STEP_COUNTS,      // u32 per ball
+        STEP_CURSORS,     // u32 per ball: steps already taken
+        WAYPOINT_COUNTS,  // u32 per ball
+        WAYPOINT_CURSORS, // u32 per ball: waypoints already refined
+        STEPS,            // i32 x, y per step
+        WAYPOINTS,        // i32 x, y per waypoint
+        REMOVED_IDS,      // Dead units not yet reported in a snapshot
+        OBSTACLE_BITS,
+        WINNING_TEAM,     // Characters, empty while the battle is running
+        SECTION_COUNT
+    };
+
+    struct SectionEntry {
+        uint64_t offset;
+        uint64_t size;  // Bytes
+    };
+
+    struct Header {
+        char magic[4];         // "BSCP"
+        uint32_t version;
+        uint32_t byteOrder;    // BYTE_ORDER_MARK as the writer stored it
+        uint32_t gridSize;
+        uint32_t clusterSize;  // HPA* cluster size
+        uint8_t movementMode;  // MovementMode
+        uint8_t hierarchical;
+        uint8_t parallel;      // Moved with worker threads, which plans from the previous tick
+        uint8_t reserved;
+        uint32_t tick;
+        uint32_t nextId;
+        uint64_t seed;
+        uint64_t publishCount;
+        uint64_t ballCount;
+        uint64_t blockedCount;
+        SectionEntry sections[SECTION_COUNT];
+    };
+    static_assert(std::is_trivially_copyable<Header>::value, "the header is copied as raw bytes");
+
+    static const char MAGIC[4];
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+    static constexpr size_t SECTION_ALIGNMENT = 64;
+
+    // Writes the whole state of simulation. Call at a tick boundary with the
+    // simulation stopped or from its own thread. Prints the reason and
+    // returns false if the file cannot be written.
+    static bool save(const SimulationManager& simulation, const std::string& path);
+
+    // Replaces the state of simulation, including its grid size, movement
+    // mode and pathfinding settings, with the file's. Prints the reason and
+    // returns false, leaving simulation unchanged, if the file is not a
+    // checkpoint written by this version on a machine of the same byte order.
+    static bool restore(SimulationManager& simulation, const std::string& path);
+
+    // Asks the running simulation to save a checkpoint after its current
+    // tick; safe to call from a signal handler
+    static void requestSave();
+    // True once per request
+    static bool takeSaveRequest();
+};
@@ -0,0 +1,47 @@
+﻿#pragma once
+
+#include "SocketPlatform.h"
+#include <vector>
+
+// Readiness notifications for many non-blocking sockets from a single thread.
+// Backed by epoll on Linux and WSAPoll on Windows.
+class ConnectionPoller {
+public:
+    struct Event {
+        SocketPlatform::SocketHandle socket;
+        bool readable;
+        bool writable;
+        bool hangup;
+    };
+
+    ConnectionPoller();
+    ~ConnectionPoller();
+
+    ConnectionPoller(const ConnectionPoller&) = delete;
+    ConnectionPoller& operator=(const ConnectionPoller&) = delete;
+
+    bool initialize();
+
+    bool add(SocketPlatform::SocketHandle socket, bool wantWrite);
+    bool modify(SocketPlatform::SocketHandle socket, bool wantWrite);
+    void remove(SocketPlatform::SocketHandle socket);
+
+    // Blocks for at most timeoutMs and fills events with ready sockets.
+    // Returns false on a fatal poller error.
+    bool wait(int timeoutMs, std::vector<Event>& events);
+
+    // Interrupts a concurrent wait(). Safe to call from any thread.
+    void wakeup();
+
+private:
+#ifdef _WIN32
+    struct Entry {
+        SocketPlatform::SocketHandle socket;
+        bool wantWrite;
+    };
+    std::vector<Entry> entries;
+#else
+    int epollFd;
+    int wakeupFd;
+#endif
+};
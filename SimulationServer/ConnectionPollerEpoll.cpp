@@ -0,0 +1,73 @@
+﻿#include "ConnectionPoller.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <cstdint>
+
+ConnectionPoller::ConnectionPoller() : epollFd(-1), wakeupFd(-1) {}
+
+ConnectionPoller::~ConnectionPoller() {
+    if (wakeupFd >= 0) close(wakeupFd);
+    if (epollFd >= 0) close(epollFd);
+}
+
+bool ConnectionPoller::initialize() {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) return false;
+
+    // The eventfd lets the simulation thread interrupt epoll_wait when a new tick is ready
+    wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeupFd < 0) return false;
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = wakeupFd;
+    return epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeupFd, &ev) == 0;
+}
+
+bool ConnectionPoller::add(SocketPlatform::SocketHandle socket, bool wantWrite) {
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLRDHUP | (wantWrite ? EPOLLOUT : 0u);
+    ev.data.fd = socket;
+    return epoll_ctl(epollFd, EPOLL_CTL_ADD, socket, &ev) == 0;
+}
+
+bool ConnectionPoller::modify(SocketPlatform::SocketHandle socket, bool wantWrite) {
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLRDHUP | (wantWrite ? EPOLLOUT : 0u);
+    ev.data.fd = socket;
+    return epoll_ctl(epollFd, EPOLL_CTL_MOD, socket, &ev) == 0;
+}
+
+void ConnectionPoller::remove(SocketPlatform::SocketHandle socket) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, socket, nullptr);
+}
+
+bool ConnectionPoller::wait(int timeoutMs, std::vector<Event>& events) {
+    events.clear();
+
+    epoll_event ready[256];
+    int count = epoll_wait(epollFd, ready, 256, timeoutMs);
+    if (count < 0) return errno == EINTR;
+
+    for (int i = 0; i < count; ++i) {
+        if (ready[i].data.fd == wakeupFd) {
+            uint64_t value;
+            while (read(wakeupFd, &value, sizeof(value)) > 0) {}
+            continue;
+        }
+
+        Event event;
+        event.socket = ready[i].data.fd;
+        event.readable = (ready[i].events & EPOLLIN) != 0;
+        event.writable = (ready[i].events & EPOLLOUT) != 0;
+        event.hangup = (ready[i].events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) != 0;
+        events.push_back(event);
+    }
+    return true;
+}
+
+void ConnectionPoller::wakeup() {
+    uint64_t one = 1;
+    ssize_t ignored = write(wakeupFd, &one, sizeof(one));
+    (void)ignored;
+}
@@ -0,0 +1,64 @@
+﻿#include "ConnectionPoller.h"
+#include <algorithm>
+
+// WSAPoll cannot be interrupted from another thread, so waits are capped to
+// keep tick latency bounded instead of relying on wakeup().
+static const int MaxPollSliceMs = 5;
+
+ConnectionPoller::ConnectionPoller() {}
+
+ConnectionPoller::~ConnectionPoller() {}
+
+bool ConnectionPoller::initialize() {
+    return true;
+}
+
+bool ConnectionPoller::add(SocketPlatform::SocketHandle socket, bool wantWrite) {
+    entries.push_back({ socket, wantWrite });
+    return true;
+}
+
+bool ConnectionPoller::modify(SocketPlatform::SocketHandle socket, bool wantWrite) {
+    for (auto& entry : entries) {
+        if (entry.socket == socket) {
+            entry.wantWrite = wantWrite;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ConnectionPoller::remove(SocketPlatform::SocketHandle socket) {
+    entries.erase(
+        std::remove_if(entries.begin(), entries.end(),
+            [socket](const Entry& e) { return e.socket == socket; }),
+        entries.end());
+}
+
+bool ConnectionPoller::wait(int timeoutMs, std::vector<Event>& events) {
+    events.clear();
+
+    std::vector<WSAPOLLFD> fds(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        fds[i].fd = entries[i].socket;
+        fds[i].events = POLLRDNORM | (entries[i].wantWrite ? POLLWRNORM : 0);
+        fds[i].revents = 0;
+    }
+
+    int slice = (timeoutMs < 0 || timeoutMs > MaxPollSliceMs) ? MaxPollSliceMs : timeoutMs;
+    int count = WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), slice);
+    if (count == SOCKET_ERROR) return false;
+
+    for (const auto& fd : fds) {
+        if (fd.revents == 0) continue;
+        Event event;
+        event.socket = fd.fd;
+        event.readable = (fd.revents & POLLRDNORM) != 0;
+        event.writable = (fd.revents & POLLWRNORM) != 0;
+        event.hangup = (fd.revents & (POLLHUP | POLLERR | POLLNVAL)) != 0;
+        events.push_back(event);
+    }
+    return true;
+}
+
+void ConnectionPoller::wakeup() {}
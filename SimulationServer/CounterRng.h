@@ -0,0 +1,39 @@
+﻿#pragma once
+
+#include <cstdint>
+
+// Stateless random numbers: every draw is a hash of (seed, tick, unit, purpose,
+// counter) instead of the next value of a shared generator. Any unit can draw
+// on any thread in any order and still get the same numbers, so a seed fully
+// determines a battle regardless of how many threads run it. The mixing
+// function is the SplitMix64 finalizer.
+namespace CounterRng {
+
+// Separates the streams a unit draws from within one tick
+enum class Purpose : uint32_t {
+    SpawnPosition = 1,
+    SpawnHp = 2,
+    Wander = 3
+};
+
+inline uint64_t mix(uint64_t z) {
+    z += 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// 64 random bits; counter tells apart several draws with the same key
+inline uint64_t draw(uint64_t seed, uint32_t tick, uint32_t unit, Purpose purpose, uint32_t counter = 0) {
+    uint64_t h = mix(seed);
+    h = mix(h ^ ((uint64_t(tick) << 32) | unit));
+    return mix(h ^ ((uint64_t(static_cast<uint32_t>(purpose)) << 32) | counter));
+}
+
+// Maps random bits onto [0, range) with a multiply instead of a modulo. The
+// bias is below range / 2^32, far under anything a battle can show.
+inline uint32_t below(uint64_t bits, uint32_t range) {
+    return static_cast<uint32_t>(((bits >> 32) * range) >> 32);
+}
+
+}  // namespace CounterRng
@@ -0,0 +1,88 @@
+﻿#include "DistanceKernels.h"
+#include <cstdlib>
+#include <initializer_list>
+
+#if DISTANCE_KERNELS_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace DistanceKernels {
+
+namespace {
+
+#if DISTANCE_KERNELS_X86
+bool cpuSupports(Isa isa) {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (isa == Isa::SSE2) return sse2;
+    if (!osxsave || maxLeaf < 7) return false;
+
+    // The OS must save the YMM (and for AVX-512 the ZMM/opmask) state
+    unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    if (isa == Isa::AVX2) return (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0;
+    if (isa == Isa::AVX512) return (xcr0 & 0xE6) == 0xE6 && (info[1] & (1 << 16)) != 0;
+    return false;
+#else
+    __builtin_cpu_init();
+    if (isa == Isa::SSE2) return __builtin_cpu_supports("sse2");
+    if (isa == Isa::AVX2) return __builtin_cpu_supports("avx2");
+    if (isa == Isa::AVX512) return __builtin_cpu_supports("avx512f");
+    return false;
+#endif
+}
+#endif
+
+}  // namespace
+
+void nearestScalar(const int32_t* xs, const int32_t* ys, const int32_t* slots, size_t count,
+    int32_t x, int32_t y, Nearest& best) {
+    for (size_t i = 0; i < count; ++i) {
+        consider(best, std::abs(x - xs[i]) + std::abs(y - ys[i]), slots[i]);
+    }
+}
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+    case Isa::Scalar: return "scalar";
+    case Isa::SSE2: return "SSE2";
+    case Isa::AVX2: return "AVX2";
+    case Isa::AVX512: return "AVX-512";
+    }
+    return "unknown";
+}
+
+NearestFn kernelFor(Isa isa) {
+    if (isa == Isa::Scalar) return nearestScalar;
+#if DISTANCE_KERNELS_X86
+    if (!cpuSupports(isa)) return nullptr;
+    switch (isa) {
+    case Isa::SSE2: return nearestSSE2;
+    case Isa::AVX2: return nearestAVX2;
+    case Isa::AVX512: return nearestAVX512;
+    default: break;
+    }
+#endif
+    return nullptr;
+}
+
+Isa detectIsa() {
+    for (Isa isa : { Isa::AVX512, Isa::AVX2, Isa::SSE2 }) {
+        if (kernelFor(isa)) return isa;
+    }
+    return Isa::Scalar;
+}
+
+NearestFn nearest() {
+    static const NearestFn selected = kernelFor(detectIsa());
+    return selected;
+}
+
+}  // namespace DistanceKernels
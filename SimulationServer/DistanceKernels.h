@@ -0,0 +1,63 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define DISTANCE_KERNELS_X86 1
+#else
+#define DISTANCE_KERNELS_X86 0
+#endif
+
+// Vectorized Manhattan-distance search over a contiguous block of coordinates.
+// Every kernel produces exactly the same answer as the scalar one: the smallest
+// distance wins, and on equal distances the lowest slot wins, no matter in
+// which order or lane the candidates were visited.
+namespace DistanceKernels {
+
+struct Nearest {
+    int32_t distance = INT32_MAX;
+    int32_t slot = -1;
+};
+
+// Folds count entries of (xs, ys, slots) into best. Distances must fit in int32.
+using NearestFn = void (*)(const int32_t* xs, const int32_t* ys, const int32_t* slots, size_t count,
+    int32_t x, int32_t y, Nearest& best);
+
+enum class Isa {
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512
+};
+
+const char* isaName(Isa isa);
+
+// Widest instruction set both compiled in and supported by this CPU and OS
+Isa detectIsa();
+
+// Kernel for a specific ISA, or nullptr if it is unavailable on this machine
+NearestFn kernelFor(Isa isa);
+
+// Kernel picked by detectIsa() on first use
+NearestFn nearest();
+
+// Per-ISA entry points. The SIMD ones are only defined on x86 builds.
+void nearestScalar(const int32_t* xs, const int32_t* ys, const int32_t* slots, size_t count,
+    int32_t x, int32_t y, Nearest& best);
+void nearestSSE2(const int32_t* xs, const int32_t* ys, const int32_t* slots, size_t count,
+    int32_t x, int32_t y, Nearest& best);
+void nearestAVX2(const int32_t* xs, const int32_t* ys, const int32_t* slots, size_t count,
+    int32_t x, int32_t y, Nearest& best);
+void nearestAVX512(const int32_t* xs, const int32_t* ys, const int32_t* slots, size_t count,
+    int32_t x, int32_t y, Nearest& best);
+
+// Folds one candidate into best using the shared ordering
+inline void consider(Nearest& best, int32_t distance, int32_t slot) {
+    if (distance < best.distance || (distance == best.distance && slot < best.slot)) {
+        best.distance = distance;
+        best.slot = slot;
+    }
+}
+
+}  // namespace DistanceKernels
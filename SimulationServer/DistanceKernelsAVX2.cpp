@@ -0,0 +1,47 @@
+﻿#include "DistanceKernels.h"
+
+// Built with AVX2 code generation enabled; only called after a runtime CPU check
+#if DISTANCE_KERNELS_X86
+#include <immintrin.h>
+
+namespace DistanceKernels {
+
+void nearestAVX2(const int32_t* xs, const int32_t* ys, const int32_t* slots, size_t count,
+    int32_t x, int32_t y, Nearest& best) {
+    const size_t lanes = 8;
+    size_t i = 0;
+
+    if (count >= lanes) {
+        __m256i px = _mm256_set1_epi32(x);
+        __m256i py = _mm256_set1_epi32(y);
+        __m256i bestDistance = _mm256_set1_epi32(INT32_MAX);
+        __m256i bestSlot = _mm256_set1_epi32(-1);
+
+        for (; i + lanes <= count; i += lanes) {
+            __m256i dx = _mm256_abs_epi32(_mm256_sub_epi32(px, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(xs + i))));
+            __m256i dy = _mm256_abs_epi32(_mm256_sub_epi32(py, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ys + i))));
+            __m256i distance = _mm256_add_epi32(dx, dy);
+            __m256i slot = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(slots + i));
+
+            __m256i closer = _mm256_cmpgt_epi32(bestDistance, distance);
+            __m256i tie = _mm256_and_si256(_mm256_cmpeq_epi32(distance, bestDistance), _mm256_cmpgt_epi32(bestSlot, slot));
+            __m256i take = _mm256_or_si256(closer, tie);
+            bestDistance = _mm256_blendv_epi8(bestDistance, distance, take);
+            bestSlot = _mm256_blendv_epi8(bestSlot, slot, take);
+        }
+
+        alignas(32) int32_t laneDistance[lanes];
+        alignas(32) int32_t laneSlot[lanes];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(laneDistance), bestDistance);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(laneSlot), bestSlot);
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            consider(best, laneDistance[lane], laneSlot[lane]);
+        }
+    }
+
+    nearestScalar(xs + i, ys + i, slots + i, count - i, x, y, best);
+}
+
+}  // namespace DistanceKernels
+
+#endif
@@ -0,0 +1,47 @@
+﻿#include "DistanceKernels.h"
+
+// Built with AVX-512F code generation enabled; only called after a runtime CPU check
+#if DISTANCE_KERNELS_X86
+#include <immintrin.h>
+
+namespace DistanceKernels {
+
+void nearestAVX512(const int32_t* xs, const int32_t* ys, const int32_t* slots, size_t count,
+    int32_t x, int32_t y, Nearest& best) {
+    const size_t lanes = 16;
+
+    __m512i px = _mm512_set1_epi32(x);
+    __m512i py = _mm512_set1_epi32(y);
+    __m512i bestDistance = _mm512_set1_epi32(INT32_MAX);
+    __m512i bestSlot = _mm512_set1_epi32(-1);
+
+    // Masked loads handle the tail, so no scalar remainder loop is needed
+    for (size_t i = 0; i < count; i += lanes) {
+        size_t remaining = count - i;
+        __mmask16 active = remaining >= lanes ? static_cast<__mmask16>(0xFFFF)
+            : static_cast<__mmask16>((1u << remaining) - 1);
+
+        __m512i dx = _mm512_abs_epi32(_mm512_sub_epi32(px, _mm512_maskz_loadu_epi32(active, xs + i)));
+        __m512i dy = _mm512_abs_epi32(_mm512_sub_epi32(py, _mm512_maskz_loadu_epi32(active, ys + i)));
+        __m512i distance = _mm512_add_epi32(dx, dy);
+        __m512i slot = _mm512_maskz_loadu_epi32(active, slots + i);
+
+        __mmask16 closer = _mm512_mask_cmplt_epi32_mask(active, distance, bestDistance);
+        __mmask16 tie = _mm512_mask_cmpeq_epi32_mask(active, distance, bestDistance)
+            & _mm512_cmplt_epi32_mask(slot, bestSlot);
+        __mmask16 take = closer | tie;
+        bestDistance = _mm512_mask_blend_epi32(take, bestDistance, distance);
+        bestSlot = _mm512_mask_blend_epi32(take, bestSlot, slot);
+    }
+
+    // Reduce to the minimum distance, then the lowest slot among lanes that hold it
+    int32_t minDistance = _mm512_reduce_min_epi32(bestDistance);
+    if (minDistance == INT32_MAX) return;
+    __mmask16 atMin = _mm512_cmpeq_epi32_mask(bestDistance, _mm512_set1_epi32(minDistance));
+    int32_t minSlot = _mm512_mask_reduce_min_epi32(atMin, bestSlot);
+    consider(best, minDistance, minSlot);
+}
+
+}  // namespace DistanceKernels
+
+#endif
@@ -0,0 +1,60 @@
+﻿#include "DistanceKernels.h"
+
+#if DISTANCE_KERNELS_X86
+#include <emmintrin.h>
+
+namespace DistanceKernels {
+
+namespace {
+
+// SSE2 has no abs, min or blend for 32-bit lanes; build them from shifts and masks
+inline __m128i abs32(__m128i v) {
+    __m128i sign = _mm_srai_epi32(v, 31);
+    return _mm_sub_epi32(_mm_xor_si128(v, sign), sign);
+}
+
+inline __m128i select32(__m128i mask, __m128i ifTrue, __m128i ifFalse) {
+    return _mm_or_si128(_mm_and_si128(mask, ifTrue), _mm_andnot_si128(mask, ifFalse));
+}
+
+}  // namespace
+
+void nearestSSE2(const int32_t* xs, const int32_t* ys, const int32_t* slots, size_t count,
+    int32_t x, int32_t y, Nearest& best) {
+    const size_t lanes = 4;
+    size_t i = 0;
+
+    if (count >= lanes) {
+        __m128i px = _mm_set1_epi32(x);
+        __m128i py = _mm_set1_epi32(y);
+        __m128i bestDistance = _mm_set1_epi32(INT32_MAX);
+        __m128i bestSlot = _mm_set1_epi32(-1);
+
+        for (; i + lanes <= count; i += lanes) {
+            __m128i dx = abs32(_mm_sub_epi32(px, _mm_loadu_si128(reinterpret_cast<const __m128i*>(xs + i))));
+            __m128i dy = abs32(_mm_sub_epi32(py, _mm_loadu_si128(reinterpret_cast<const __m128i*>(ys + i))));
+            __m128i distance = _mm_add_epi32(dx, dy);
+            __m128i slot = _mm_loadu_si128(reinterpret_cast<const __m128i*>(slots + i));
+
+            __m128i closer = _mm_cmplt_epi32(distance, bestDistance);
+            __m128i tie = _mm_and_si128(_mm_cmpeq_epi32(distance, bestDistance), _mm_cmplt_epi32(slot, bestSlot));
+            __m128i take = _mm_or_si128(closer, tie);
+            bestDistance = select32(take, distance, bestDistance);
+            bestSlot = select32(take, slot, bestSlot);
+        }
+
+        alignas(16) int32_t laneDistance[lanes];
+        alignas(16) int32_t laneSlot[lanes];
+        _mm_store_si128(reinterpret_cast<__m128i*>(laneDistance), bestDistance);
+        _mm_store_si128(reinterpret_cast<__m128i*>(laneSlot), bestSlot);
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            consider(best, laneDistance[lane], laneSlot[lane]);
+        }
+    }
+
+    nearestScalar(xs + i, ys + i, slots + i, count - i, x, y, best);
+}
+
+}  // namespace DistanceKernels
+
+#endif
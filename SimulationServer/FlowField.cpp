@@ -0,0 +1,114 @@
+﻿#include "FlowField.h"
+#include <algorithm>
+
+const int32_t FlowField::UNREACHABLE;
+const int32_t FlowField::BORDER;
+
+FlowField::FlowField() : width(0), height(0), stride(2), neighborOffsets{ 0, 0, 0, 0 } {}
+
+void FlowField::build(const BallStore& balls, const ObstacleMap& obstacles) {
+    width = obstacles.getWidth();
+    height = obstacles.getHeight();
+    stride = width + 2;
+    neighborOffsets[0] = stride;
+    neighborOffsets[1] = 1;
+    neighborOffsets[2] = -stride;
+    neighborOffsets[3] = -1;
+
+    buildField(fields[0], balls, obstacles, 1);  // Blue balls chase red ones
+    buildField(fields[1], balls, obstacles, 0);
+}
+
+void FlowField::buildField(std::vector<int32_t>& field, const BallStore& balls, const ObstacleMap& obstacles,
+    uint8_t enemyTeam) {
+    size_t cells = static_cast<size_t>(stride) * (height + 2);
+    field.assign(cells, BORDER);
+
+    bool hasObstacles = obstacles.getBlockedCount() > 0;
+    if (hasObstacles) {
+        // Open cells start unreached; blocked ones stay BORDER like the padding
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                if (obstacles.isOpen(x, y)) field[cellIndex(x, y)] = UNREACHABLE;
+            }
+        }
+        frontier.resize(static_cast<size_t>(width) * height);
+    }
+
+    // Every living enemy is a source at distance zero
+    const uint8_t* teams = balls.teamData();
+    size_t sources = 0;
+    for (size_t i = 0; i < balls.size(); ++i) {
+        if (teams[i] != enemyTeam || balls.isDead(i)) continue;
+        int cell = cellIndex(balls.getX(i), balls.getY(i));
+        if (field[cell] == 0) continue;
+        field[cell] = 0;
+        if (hasObstacles) frontier[sources] = cell;
+        sources++;
+    }
+
+    if (sources == 0) {
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                if (obstacles.isOpen(x, y)) field[cellIndex(x, y)] = UNREACHABLE;
+            }
+        }
+        return;
+    }
+
+    if (hasObstacles) breadthFirst(field.data(), sources);
+    else sweepOpen(field.data());
+}
+
+void FlowField::sweepOpen(int32_t* distances) const {
+    // Exact city-block distance transform in two raster sweeps. On an open
+    // grid this matches a multi-source BFS but reads memory in order instead
+    // of jumping between thousands of wavefronts.
+    for (int y = 0; y < height; ++y) {
+        for (int cell = cellIndex(0, y), end = cell + width; cell < end; ++cell) {
+            int32_t fromBefore = std::min(distances[cell - stride], distances[cell - 1]) + 1;
+            distances[cell] = std::min(distances[cell], fromBefore);
+        }
+    }
+    for (int y = height - 1; y >= 0; --y) {
+        for (int cell = cellIndex(width - 1, y), end = cell - width; cell > end; --cell) {
+            int32_t fromAfter = std::min(distances[cell + stride], distances[cell + 1]) + 1;
+            distances[cell] = std::min(distances[cell], fromAfter);
+        }
+    }
+}
+
+void FlowField::breadthFirst(int32_t* distances, size_t sources) {
+    // Walls break the sweep's straight-line assumption, so flood outwards
+    // from the sources; each cell is reached first at its final distance
+    size_t tail = sources;
+    for (size_t head = 0; head < tail; ++head) {
+        int cell = frontier[head];
+        int32_t nextDistance = distances[cell] + 1;
+
+        for (int offset : neighborOffsets) {
+            int neighbor = cell + offset;
+            if (distances[neighbor] != UNREACHABLE) continue;
+            distances[neighbor] = nextDistance;
+            frontier[tail++] = neighbor;
+        }
+    }
+}
+
+void FlowField::stepDownhill(bool isRed, int& x, int& y) const {
+    const int32_t* distances = fields[isRed ? 1 : 0].data();
+    int cell = cellIndex(x, y);
+    int32_t best = distances[cell];
+    if (best == 0 || best >= BORDER) return;
+
+    // BORDER (padding and walls) is farther than any real distance, so it is never chosen
+    int bestCell = cell;
+    for (int offset : neighborOffsets) {
+        if (distances[cell + offset] < best) {
+            best = distances[cell + offset];
+            bestCell = cell + offset;
+        }
+    }
+    x = bestCell % stride - 1;
+    y = bestCell / stride - 1;
+}
@@ -0,0 +1,51 @@
+﻿#pragma once
+
+#include "BallStore.h"
+#include "ObstacleMap.h"
+#include <cstdint>
+#include <vector>
+
+// Per-team distance fields over the simulation grid. Each field holds, for
+// every cell, the number of 4-way steps to the nearest living ball of the
+// other team, seeded from all of them at once. A ball reaches its nearest
+// enemy by repeatedly stepping to a downhill neighbour, so one field replaces
+// a path search per ball. Blocked cells are never entered.
+class FlowField {
+public:
+    static const int32_t UNREACHABLE = INT32_MAX;
+    static const int32_t BORDER = INT32_MAX / 2;  // Padding; farther than any cell, and +1 cannot overflow
+
+    FlowField();
+
+    // Recomputes both fields from the current ball positions over the map
+    void build(const BallStore& balls, const ObstacleMap& obstacles);
+
+    // Steps from (x, y) to the nearest enemy of a ball on the given team, or UNREACHABLE
+    int32_t distance(bool isRed, int x, int y) const {
+        return fields[isRed ? 1 : 0][cellIndex(x, y)];
+    }
+
+    // Moves (x, y) one step downhill; leaves it unchanged on an enemy's cell or
+    // if no enemy is reachable. Ties go to the first of +y, +x, -y, -x.
+    void stepDownhill(bool isRed, int& x, int& y) const;
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+private:
+    // Fields are padded by one border cell on every side so neighbour lookups
+    // need no bounds checks
+    int cellIndex(int x, int y) const { return (y + 1) * stride + (x + 1); }
+
+    void buildField(std::vector<int32_t>& field, const BallStore& balls, const ObstacleMap& obstacles,
+        uint8_t enemyTeam);
+    void sweepOpen(int32_t* distances) const;
+    void breadthFirst(int32_t* distances, size_t sources);
+
+    int width;
+    int height;
+    int stride;                      // width plus the two border columns
+    int neighborOffsets[4];          // +y, +x, -y, -x in padded cell units
+    std::vector<int32_t> fields[2];  // Indexed by the moving ball's team (0 = blue, 1 = red)
+    std::vector<int32_t> frontier;   // BFS queue for maps with obstacles, reused between builds
+};
@@ -0,0 +1,139 @@
+﻿#include "GameConfig.h"
+#include "Log.h"
+#include <cstdlib>
+#include <fstream>
+
+namespace {
+
+struct IntSetting {
+    const char* key;
+    int GameConfig::* field;
+    int minValue;
+    int maxValue;
+};
+
+// Ranges keep every combination valid: spawning needs a border plus one inner
+// cell, and coordinates go out as 16-bit values
+const IntSetting INT_SETTINGS[] = {
+    { "grid-size", &GameConfig::gridSize, 3, 65535 },
+    { "server-port", &GameConfig::serverPort, 1, 65535 },
+    { "update-interval-ms", &GameConfig::updateIntervalMs, 1, 60000 },
+    { "max-units", &GameConfig::maxUnits, 2, 1 << 20 },
+    { "keyframe-interval", &GameConfig::keyframeInterval, 1, 1 << 20 },
+    { "frame-interval-ms", &GameConfig::frameIntervalMs, 0, 60000 },
+    { "start-delay-ms", &GameConfig::startDelayMs, 0, 600000 },
+    { "viewport-margin", &GameConfig::viewportMargin, 0, 65535 },
+    { "udp-port", &GameConfig::udpPort, 0, 65535 },
+    { "udp-loss-percent", &GameConfig::udpLossPercent, 0, 100 },
+    { "udp-latency-ms", &GameConfig::udpLatencyMs, 0, 10000 },
+    { "worker-threads", &GameConfig::workerThreads, 0, 1024 },
+    { "hierarchical-min-grid-size", &GameConfig::hierarchicalMinGridSize, 1, 1 << 30 },
+    { "hierarchical-cluster-size", &GameConfig::hierarchicalClusterSize, 4, 4096 },
+    { "trace-detail", &GameConfig::traceDetail, 0, 1 },
+    { "checkpoint-tick", &GameConfig::checkpointTick, 0, 1 << 30 },
+};
+
+const char* MOVEMENT_MODE_KEY = "movement-mode";
+const char* TIME_SCALE_KEY = "time-scale";
+const double MAX_TIME_SCALE = 1000.0;
+const char* TRACE_FILE_KEY = "trace-file";
+const char* RECORD_FILE_KEY = "record-file";
+const char* CHECKPOINT_FILE_KEY = "checkpoint-file";
+
+std::string trim(const std::string& text) {
+    size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos) return std::string();
+    size_t last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+}  // namespace
+
+bool GameConfig::isKey(const std::string& key) {
+    if (key == MOVEMENT_MODE_KEY || key == TIME_SCALE_KEY || key == TRACE_FILE_KEY || key == RECORD_FILE_KEY ||
+        key == CHECKPOINT_FILE_KEY) {
+        return true;
+    }
+    for (const IntSetting& setting : INT_SETTINGS) {
+        if (key == setting.key) return true;
+    }
+    return false;
+}
+
+bool GameConfig::set(const std::string& key, const std::string& value) {
+    if (key == TRACE_FILE_KEY) {
+        traceFile = value;
+        return true;
+    }
+    if (key == RECORD_FILE_KEY) {
+        recordFile = value;
+        return true;
+    }
+    if (key == CHECKPOINT_FILE_KEY) {
+        checkpointFile = value;
+        return true;
+    }
+    if (key == TIME_SCALE_KEY) {
+        char* end = nullptr;
+        double parsed = std::strtod(value.c_str(), &end);
+        if (value.empty() || *end != '\0' || !(parsed >= 0 && parsed <= MAX_TIME_SCALE)) {
+            LOG_ERROR("[Server] {} must be a number from 0 to {}, got '{}'", key, MAX_TIME_SCALE, value);
+            return false;
+        }
+        timeScale = parsed;
+        return true;
+    }
+    if (key == MOVEMENT_MODE_KEY) {
+        if (value == "path-per-unit") movementMode = MovementMode::PathPerUnit;
+        else if (value == "flow-field") movementMode = MovementMode::FlowField;
+        else {
+            LOG_ERROR("[Server] {} must be path-per-unit or flow-field, got '{}'", key, value);
+            return false;
+        }
+        return true;
+    }
+
+    for (const IntSetting& setting : INT_SETTINGS) {
+        if (key != setting.key) continue;
+
+        char* end = nullptr;
+        long parsed = std::strtol(value.c_str(), &end, 10);
+        if (value.empty() || *end != '\0' || parsed < setting.minValue || parsed > setting.maxValue) {
+            LOG_ERROR("[Server] {} must be a number from {} to {}, got '{}'", key, setting.minValue,
+                setting.maxValue, value);
+            return false;
+        }
+        this->*setting.field = static_cast<int>(parsed);
+        return true;
+    }
+
+    LOG_ERROR("[Server] Unknown setting: {}", key);
+    return false;
+}
+
+bool GameConfig::loadFromFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        LOG_ERROR("[Server] Cannot open config file: {}", path);
+        return false;
+    }
+
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); ++lineNumber) {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        line = trim(line);
+        if (line.empty()) continue;
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            LOG_ERROR("[Server] {}:{}: expected key = value", path, lineNumber);
+            return false;
+        }
+        if (!set(trim(line.substr(0, equals)), trim(line.substr(equals + 1)))) {
+            LOG_ERROR("[Server] Bad setting on line {} of {}", lineNumber, path);
+            return false;
+        }
+    }
+    return true;
+}
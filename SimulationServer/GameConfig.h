@@ -1,9 +1,62 @@
 ﻿#pragma once
 
+#include <string>
+
+// How balls find their way to enemies
+enum class MovementMode {
+    PathPerUnit,  // Each ball runs A* toward its nearest enemy
+    FlowField     // One shared distance field per team, rebuilt every tick
+};
+
+// Server settings, read once at startup. The defaults apply unless a config
+// file or command-line flag overrides them; every setting has a key of the
+// same name in both, e.g. "grid-size = 256" in a file or --grid-size 256.
 class GameConfig {
 public:
-    static const int GRID_SIZE = 100;
-    static const int SERVER_PORT = 8080;
-    static const int UPDATE_INTERVAL_MS = 100;
-    static const int MAX_UNITS = 10;
-};
\ No newline at end of file
+    int gridSize = 100;
+    int serverPort = 8080;
+    int updateIntervalMs = 100;
+    int maxUnits = 10;
+    int keyframeInterval = 50;  // Frames between full snapshots; deltas in between
+    // Simulated ticks per real tick: 10 runs ten ticks every update-interval-ms,
+    // 0 runs them back to back as fast as the machine allows
+    double timeScale = 1.0;
+    // Least wall time between frames sent to clients; 0 sends every tick,
+    // or one frame per update-interval-ms when time-scale speeds ticks up
+    int frameIntervalMs = 0;
+    int startDelayMs = 3000;  // Wall time between the first client connecting and the first tick
+    // Cells added around a client's viewport, so units near its edge do not
+    // flicker in and out of view
+    int viewportMargin = 8;
+    // Also serves snapshots over UDP on this port; 0 serves TCP only
+    int udpPort = 0;
+    // Simulated network conditions for UDP testing over loopback: the share
+    // of datagrams dropped and the delay added to each, in both directions
+    int udpLossPercent = 0;
+    int udpLatencyMs = 0;
+    MovementMode movementMode = MovementMode::PathPerUnit;
+    int workerThreads = 0;  // Targeting and movement threads; 0 moves balls in place
+    // Grids at least this wide plan with HPA* instead of flat Jump Point Search
+    int hierarchicalMinGridSize = 1024;
+    int hierarchicalClusterSize = 32;
+    // Records phase timings and writes them here as a Chrome trace on exit
+    // (and on SIGUSR1 where available); empty leaves tracing off
+    std::string traceFile;
+    int traceDetail = 0;  // 1 also records every path search, at a cost per ball
+    // Appends every tick to this replay file; empty records nothing
+    std::string recordFile;
+    // Saves the full simulation state here at checkpointTick (0 for none) and
+    // on SIGUSR2 where available; empty saves nothing
+    std::string checkpointFile;
+    int checkpointTick = 0;
+
+    // Reads "key = value" lines; '#' starts a comment and blank lines are
+    // skipped. Prints the reason and returns false on the first bad line;
+    // settings read before it stay applied.
+    bool loadFromFile(const std::string& path);
+
+    // Sets one setting by key. Prints the reason and returns false for an
+    // unknown key or a value out of range.
+    bool set(const std::string& key, const std::string& value);
+    static bool isKey(const std::string& key);
+};
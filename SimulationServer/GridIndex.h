@@ -0,0 +1,46 @@
+﻿#pragma once
+
+// Cell index <-> coordinate conversion for row-major grids. Hot loops are
+// written once as templates over an index type. dispatchGridWidth
+// instantiates them with a compile-time shift for common power-of-two widths,
+// so % and / by the width become a mask and a shift; every other width takes
+// the runtime path.
+
+struct RuntimeGridIndex {
+    int width;
+
+    int x(int cell) const { return cell % width; }
+    int y(int cell) const { return cell / width; }
+    int cell(int x, int y) const { return y * width + x; }
+    bool containsX(int x) const { return static_cast<unsigned>(x) < static_cast<unsigned>(width); }
+};
+
+template <int Shift>
+struct PowerOfTwoGridIndex {
+    static const int WIDTH = 1 << Shift;
+
+    int x(int cell) const { return cell & (WIDTH - 1); }
+    int y(int cell) const { return cell >> Shift; }
+    int cell(int x, int y) const { return (y << Shift) | x; }
+    bool containsX(int x) const { return (static_cast<unsigned>(x) >> Shift) == 0; }
+};
+
+// Calls body with the fastest index type for the width. With specialize off
+// every width takes the runtime path, which benchmarks use as the baseline.
+template <typename Body>
+auto dispatchGridWidth(int width, bool specialize, Body&& body) -> decltype(body(RuntimeGridIndex{ width })) {
+    if (specialize) {
+        switch (width) {
+        case 32: return body(PowerOfTwoGridIndex<5>());
+        case 64: return body(PowerOfTwoGridIndex<6>());
+        case 128: return body(PowerOfTwoGridIndex<7>());
+        case 256: return body(PowerOfTwoGridIndex<8>());
+        case 512: return body(PowerOfTwoGridIndex<9>());
+        case 1024: return body(PowerOfTwoGridIndex<10>());
+        case 2048: return body(PowerOfTwoGridIndex<11>());
+        case 4096: return body(PowerOfTwoGridIndex<12>());
+        default: break;
+        }
+    }
+    return body(RuntimeGridIndex{ width });
+}
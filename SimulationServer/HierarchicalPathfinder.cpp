@@ -0,0 +1,396 @@
+﻿#include "HierarchicalPathfinder.h"
+#include "Pathfinding.h"
+#include <algorithm>
+#include <cstdlib>
+
+const int32_t HierarchicalPathfinder::UNREACHABLE;
+
+namespace {
+
+struct HeapEntry {
+    int32_t f;
+    int32_t g;
+    int32_t node;
+};
+
+// Min-heap on f; among equal f prefer the deeper node, then the lower id
+struct HeapOrder {
+    bool operator()(const HeapEntry& a, const HeapEntry& b) const {
+        if (a.f != b.f) return a.f > b.f;
+        if (a.g != b.g) return a.g < b.g;
+        return a.node > b.node;
+    }
+};
+
+// Per-thread scratch for cluster floods and abstract searches. Node-indexed
+// arrays use generation stamps so a query never clears them.
+struct SearchScratch {
+    std::vector<int32_t> cellDistances;
+    std::vector<int32_t> queue;
+    std::vector<int32_t> startDistances;  // Per slot of the start cluster
+    std::vector<int32_t> goalDistances;   // Per slot of the goal cluster
+    std::vector<int32_t> gScore;
+    std::vector<int32_t> parent;
+    std::vector<uint32_t> seen;
+    std::vector<uint32_t> closed;
+    std::vector<HeapEntry> heap;
+    std::vector<int32_t> routeNodes;
+    uint32_t generation = 0;
+
+    void beginSearch(size_t nodeCount) {
+        if (nodeCount > seen.size()) {
+            seen.resize(nodeCount, 0);
+            closed.resize(nodeCount, 0);
+            gScore.resize(nodeCount);
+            parent.resize(nodeCount);
+        }
+        if (++generation == 0) {
+            std::fill(seen.begin(), seen.end(), 0);
+            std::fill(closed.begin(), closed.end(), 0);
+            generation = 1;
+        }
+        heap.clear();
+    }
+};
+
+SearchScratch& scratchForThisThread() {
+    thread_local SearchScratch scratch;
+    return scratch;
+}
+
+const int32_t START_PARENT = -1;
+
+}  // namespace
+
+HierarchicalPathfinder::HierarchicalPathfinder()
+    : clusterSize(DEFAULT_CLUSTER_SIZE), clustersX(0), clustersY(0) {}
+
+void HierarchicalPathfinder::build(const ObstacleMap& obstacles, int newClusterSize) {
+    map = obstacles;
+    clusterSize = std::max(2, newClusterSize);
+    clustersX = (map.getWidth() + clusterSize - 1) / clusterSize;
+    clustersY = (map.getHeight() + clusterSize - 1) / clusterSize;
+
+    nodes.clear();
+    freeNodes.clear();
+    clusters.assign(static_cast<size_t>(clustersX) * clustersY, Cluster());
+    for (int cy = 0; cy < clustersY; ++cy) {
+        for (int cx = 0; cx < clustersX; ++cx) {
+            Cluster& cluster = clusters[cy * clustersX + cx];
+            cluster.x0 = cx * clusterSize;
+            cluster.y0 = cy * clusterSize;
+            cluster.width = std::min(clusterSize, map.getWidth() - cluster.x0);
+            cluster.height = std::min(clusterSize, map.getHeight() - cluster.y0);
+        }
+    }
+
+    for (int cy = 0; cy < clustersY; ++cy) {
+        for (int cx = 0; cx < clustersX; ++cx) {
+            int cluster = cy * clustersX + cx;
+            if (cx + 1 < clustersX) buildBorder(cluster, true);
+            if (cy + 1 < clustersY) buildBorder(cluster, false);
+        }
+    }
+    for (size_t cluster = 0; cluster < clusters.size(); ++cluster) {
+        buildDistances(static_cast<int>(cluster));
+    }
+}
+
+int HierarchicalPathfinder::addNode(int x, int y, int cluster) {
+    int node;
+    if (!freeNodes.empty()) {
+        node = freeNodes.back();
+        freeNodes.pop_back();
+    }
+    else {
+        node = static_cast<int>(nodes.size());
+        nodes.emplace_back();
+    }
+
+    Cluster& owner = clusters[cluster];
+    nodes[node] = { x, y, cluster, static_cast<int32_t>(owner.nodes.size()), -1 };
+    owner.nodes.push_back(node);
+    return node;
+}
+
+void HierarchicalPathfinder::removeNode(int node) {
+    Cluster& owner = clusters[nodes[node].cluster];
+    int32_t slot = nodes[node].slot;
+    int32_t moved = owner.nodes.back();
+    owner.nodes[slot] = moved;
+    nodes[moved].slot = slot;
+    owner.nodes.pop_back();
+
+    nodes[node].cluster = -1;
+    freeNodes.push_back(node);
+}
+
+void HierarchicalPathfinder::buildBorder(int cluster, bool east) {
+    const Cluster& near = clusters[cluster];
+    int neighbor = east ? cluster + 1 : cluster + clustersX;
+    int length = east ? near.height : near.width;
+
+    // Cell t along the border on this side, and its twin across it
+    auto nearCell = [&](int t) {
+        return east ? std::make_pair(near.x0 + near.width - 1, near.y0 + t)
+                    : std::make_pair(near.x0 + t, near.y0 + near.height - 1);
+    };
+    auto addEntrance = [&](int t) {
+        std::pair<int, int> inside = nearCell(t);
+        std::pair<int, int> across = east ? std::make_pair(inside.first + 1, inside.second)
+                                          : std::make_pair(inside.first, inside.second + 1);
+        int a = addNode(inside.first, inside.second, cluster);
+        int b = addNode(across.first, across.second, neighbor);
+        nodes[a].partner = b;
+        nodes[b].partner = a;
+        (east ? clusters[cluster].eastBorder : clusters[cluster].northBorder).push_back(a);
+    };
+
+    int runStart = -1;
+    for (int t = 0; t <= length; ++t) {
+        bool open = false;
+        if (t < length) {
+            std::pair<int, int> inside = nearCell(t);
+            open = map.isOpen(inside.first, inside.second) &&
+                (east ? map.isOpen(inside.first + 1, inside.second) : map.isOpen(inside.first, inside.second + 1));
+        }
+
+        if (open && runStart < 0) runStart = t;
+        if (!open && runStart >= 0) {
+            // One entrance in the middle of a short run, one at each end of a long one
+            int runLength = t - runStart;
+            if (runLength < LONG_ENTRANCE) {
+                addEntrance(runStart + (runLength - 1) / 2);
+            }
+            else {
+                addEntrance(runStart);
+                addEntrance(t - 1);
+            }
+            runStart = -1;
+        }
+    }
+}
+
+void HierarchicalPathfinder::clearBorder(int cluster, bool east) {
+    std::vector<int32_t>& border = east ? clusters[cluster].eastBorder : clusters[cluster].northBorder;
+    for (int32_t node : border) {
+        removeNode(nodes[node].partner);
+        removeNode(node);
+    }
+    border.clear();
+}
+
+void HierarchicalPathfinder::clusterDistances(const Cluster& cluster, int x, int y, std::vector<int32_t>& out) const {
+    SearchScratch& scratch = scratchForThisThread();
+    size_t cells = static_cast<size_t>(cluster.width) * cluster.height;
+    out.assign(cells, UNREACHABLE);
+    scratch.queue.resize(cells);
+
+    int start = (y - cluster.y0) * cluster.width + (x - cluster.x0);
+    out[start] = 0;
+    scratch.queue[0] = start;
+    size_t tail = 1;
+
+    static const int DX[4] = { 0, 1, 0, -1 };
+    static const int DY[4] = { 1, 0, -1, 0 };
+    for (size_t head = 0; head < tail; ++head) {
+        int cell = scratch.queue[head];
+        int lx = cell % cluster.width;
+        int ly = cell / cluster.width;
+        for (int dir = 0; dir < 4; ++dir) {
+            int nx = lx + DX[dir];
+            int ny = ly + DY[dir];
+            if (nx < 0 || ny < 0 || nx >= cluster.width || ny >= cluster.height) continue;
+            int neighbor = ny * cluster.width + nx;
+            if (out[neighbor] != UNREACHABLE || map.isBlocked(cluster.x0 + nx, cluster.y0 + ny)) continue;
+            out[neighbor] = out[cell] + 1;
+            scratch.queue[tail++] = neighbor;
+        }
+    }
+}
+
+void HierarchicalPathfinder::buildDistances(int clusterIndex) {
+    Cluster& cluster = clusters[clusterIndex];
+    size_t count = cluster.nodes.size();
+    cluster.distances.assign(count * count, UNREACHABLE);
+
+    bool open = true;
+    for (int y = cluster.y0; y < cluster.y0 + cluster.height && open; ++y) {
+        for (int x = cluster.x0; x < cluster.x0 + cluster.width && open; ++x) {
+            open = map.isOpen(x, y);
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const Node& from = nodes[cluster.nodes[i]];
+        int32_t* row = &cluster.distances[i * count];
+
+        // Nothing to route around in an empty cluster
+        if (open) {
+            for (size_t j = 0; j < count; ++j) {
+                const Node& to = nodes[cluster.nodes[j]];
+                row[j] = std::abs(from.x - to.x) + std::abs(from.y - to.y);
+            }
+            continue;
+        }
+
+        std::vector<int32_t>& flood = scratchForThisThread().cellDistances;
+        clusterDistances(cluster, from.x, from.y, flood);
+        for (size_t j = 0; j < count; ++j) {
+            const Node& to = nodes[cluster.nodes[j]];
+            row[j] = flood[(to.y - cluster.y0) * cluster.width + (to.x - cluster.x0)];
+        }
+    }
+}
+
+void HierarchicalPathfinder::setBlocked(int x, int y, bool blocked) {
+    if (x < 0 || y < 0 || x >= map.getWidth() || y >= map.getHeight()) return;
+    if (map.isBlocked(x, y) == blocked) return;
+    map.setBlocked(x, y, blocked);
+
+    int clusterIndex = clusterOf(x, y);
+    const Cluster& cluster = clusters[clusterIndex];
+    int cx = clusterIndex % clustersX;
+    int cy = clusterIndex / clustersX;
+
+    // A border cell changes the entrances shared with that neighbour, and
+    // with them the node set of both clusters
+    int affected[5];
+    int affectedCount = 0;
+    affected[affectedCount++] = clusterIndex;
+
+    auto refreshBorder = [&](int owner, bool east, int other) {
+        clearBorder(owner, east);
+        buildBorder(owner, east);
+        affected[affectedCount++] = other;
+    };
+    if (x == cluster.x0 && cx > 0) refreshBorder(clusterIndex - 1, true, clusterIndex - 1);
+    if (x == cluster.x0 + cluster.width - 1 && cx + 1 < clustersX) refreshBorder(clusterIndex, true, clusterIndex + 1);
+    if (y == cluster.y0 && cy > 0) refreshBorder(clusterIndex - clustersX, false, clusterIndex - clustersX);
+    if (y == cluster.y0 + cluster.height - 1 && cy + 1 < clustersY) refreshBorder(clusterIndex, false, clusterIndex + clustersX);
+
+    for (int i = 0; i < affectedCount; ++i) {
+        buildDistances(affected[i]);
+    }
+}
+
+size_t HierarchicalPathfinder::getMemoryBytes() const {
+    size_t bytes = map.getMemoryBytes();
+    bytes += clusters.capacity() * sizeof(Cluster);
+    for (const Cluster& cluster : clusters) {
+        bytes += (cluster.nodes.capacity() + cluster.distances.capacity() +
+            cluster.eastBorder.capacity() + cluster.northBorder.capacity()) * sizeof(int32_t);
+    }
+    bytes += nodes.capacity() * sizeof(Node) + freeNodes.capacity() * sizeof(int32_t);
+    return bytes;
+}
+
+const std::vector<std::pair<int, int>>& HierarchicalPathfinder::refineSegment(int fromX, int fromY, int toX, int toY) const {
+    const Cluster& a = clusters[clusterOf(fromX, fromY)];
+    const Cluster& b = clusters[clusterOf(toX, toY)];
+
+    // Consecutive waypoints share a cluster or sit on either side of a border,
+    // so the union of their clusters is always a rectangle
+    int x0 = std::min(a.x0, b.x0);
+    int y0 = std::min(a.y0, b.y0);
+    int x1 = std::max(a.x0 + a.width, b.x0 + b.width);
+    int y1 = std::max(a.y0 + a.height, b.y0 + b.height);
+    return PathWorkspace::forThisThread().findPathInWindow(map, x0, y0, x1 - x0, y1 - y0, fromX, fromY, toX, toY);
+}
+
+bool HierarchicalPathfinder::findRoute(int startX, int startY, int goalX, int goalY,
+    std::vector<std::pair<int, int>>& waypoints) const {
+    waypoints.clear();
+    if (map.isBlocked(startX, startY) || map.isBlocked(goalX, goalY)) return false;
+
+    int startCluster = clusterOf(startX, startY);
+    int goalCluster = clusterOf(goalX, goalY);
+
+    // Short trips inside one cluster skip the abstract graph entirely
+    if (startCluster == goalCluster && !refineSegment(startX, startY, goalX, goalY).empty()) {
+        waypoints.emplace_back(startX, startY);
+        if (startX != goalX || startY != goalY) waypoints.emplace_back(goalX, goalY);
+        return true;
+    }
+
+    SearchScratch& scratch = scratchForThisThread();
+    const Cluster& first = clusters[startCluster];
+    const Cluster& last = clusters[goalCluster];
+
+    // Connect the start and goal to the entrances of their clusters
+    clusterDistances(first, startX, startY, scratch.cellDistances);
+    scratch.startDistances.resize(first.nodes.size());
+    for (size_t slot = 0; slot < first.nodes.size(); ++slot) {
+        const Node& node = nodes[first.nodes[slot]];
+        scratch.startDistances[slot] = scratch.cellDistances[(node.y - first.y0) * first.width + (node.x - first.x0)];
+    }
+    clusterDistances(last, goalX, goalY, scratch.cellDistances);
+    scratch.goalDistances.resize(last.nodes.size());
+    for (size_t slot = 0; slot < last.nodes.size(); ++slot) {
+        const Node& node = nodes[last.nodes[slot]];
+        scratch.goalDistances[slot] = scratch.cellDistances[(node.y - last.y0) * last.width + (node.x - last.x0)];
+    }
+
+    scratch.beginSearch(nodes.size());
+    auto relax = [&](int32_t node, int32_t g, int32_t from) {
+        if (scratch.closed[node] == scratch.generation) return;
+        if (scratch.seen[node] == scratch.generation && scratch.gScore[node] <= g) return;
+        scratch.seen[node] = scratch.generation;
+        scratch.gScore[node] = g;
+        scratch.parent[node] = from;
+        int32_t h = std::abs(nodes[node].x - goalX) + std::abs(nodes[node].y - goalY);
+        scratch.heap.push_back({ g + h, g, node });
+        std::push_heap(scratch.heap.begin(), scratch.heap.end(), HeapOrder());
+    };
+
+    for (size_t slot = 0; slot < first.nodes.size(); ++slot) {
+        if (scratch.startDistances[slot] != UNREACHABLE) relax(first.nodes[slot], scratch.startDistances[slot], START_PARENT);
+    }
+
+    int32_t bestTotal = UNREACHABLE;
+    int32_t bestNode = -1;
+    while (!scratch.heap.empty()) {
+        std::pop_heap(scratch.heap.begin(), scratch.heap.end(), HeapOrder());
+        HeapEntry entry = scratch.heap.back();
+        scratch.heap.pop_back();
+
+        // Stale duplicates left behind by later improvements
+        if (scratch.closed[entry.node] == scratch.generation || entry.g != scratch.gScore[entry.node]) continue;
+        if (entry.f >= bestTotal) break;
+        scratch.closed[entry.node] = scratch.generation;
+
+        const Node& node = nodes[entry.node];
+        if (node.cluster == goalCluster && scratch.goalDistances[node.slot] != UNREACHABLE) {
+            int32_t total = entry.g + scratch.goalDistances[node.slot];
+            if (total < bestTotal) {
+                bestTotal = total;
+                bestNode = entry.node;
+            }
+        }
+
+        relax(node.partner, entry.g + 1, entry.node);
+
+        const Cluster& cluster = clusters[node.cluster];
+        size_t count = cluster.nodes.size();
+        const int32_t* row = &cluster.distances[node.slot * count];
+        for (size_t other = 0; other < count; ++other) {
+            if (row[other] == UNREACHABLE || static_cast<int32_t>(other) == node.slot) continue;
+            relax(cluster.nodes[other], entry.g + row[other], entry.node);
+        }
+    }
+
+    if (bestNode < 0) return false;
+
+    scratch.routeNodes.clear();
+    for (int32_t node = bestNode; node != START_PARENT; node = scratch.parent[node]) {
+        scratch.routeNodes.push_back(node);
+    }
+
+    waypoints.emplace_back(startX, startY);
+    for (auto it = scratch.routeNodes.rbegin(); it != scratch.routeNodes.rend(); ++it) {
+        std::pair<int, int> cell(nodes[*it].x, nodes[*it].y);
+        if (cell != waypoints.back()) waypoints.push_back(cell);
+    }
+    if (waypoints.back() != std::make_pair(goalX, goalY)) waypoints.emplace_back(goalX, goalY);
+    return true;
+}
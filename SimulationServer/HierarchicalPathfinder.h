@@ -0,0 +1,89 @@
+﻿#pragma once
+
+#include "ObstacleMap.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// HPA* for large grids. The map is split into square clusters. Wherever two
+// neighbouring clusters share an open stretch of border, entrance nodes are
+// placed on both sides, and every pair of nodes inside a cluster is linked by
+// its precomputed in-cluster distance. A query searches this small abstract
+// graph for a route of waypoints. The caller then refines one segment at a
+// time with a search confined to a single cluster, so a long trip only costs
+// cell-level work near the unit.
+//
+// Editing a cell rebuilds only its own cluster and the neighbours that share
+// a border with it. Routes are near-optimal: they are restricted to the
+// chosen entrance cells.
+class HierarchicalPathfinder {
+public:
+    static const int DEFAULT_CLUSTER_SIZE = 32;
+    static const int32_t UNREACHABLE = INT32_MAX;
+
+    HierarchicalPathfinder();
+
+    void build(const ObstacleMap& map, int clusterSize = DEFAULT_CLUSTER_SIZE);
+
+    // Changes one cell and refreshes the clusters the change can affect
+    void setBlocked(int x, int y, bool blocked);
+
+    const ObstacleMap& getMap() const { return map; }
+    int getClusterSize() const { return clusterSize; }
+    size_t getNodeCount() const { return nodes.size() - freeNodes.size(); }
+    // Map bitset plus abstract graph
+    size_t getMemoryBytes() const;
+
+    // Fills waypoints with start, the entrance cells to pass through and the
+    // goal. Consecutive waypoints share a cluster or are adjacent across a
+    // border. Returns false if the goal is unreachable or either end is blocked.
+    bool findRoute(int startX, int startY, int goalX, int goalY,
+        std::vector<std::pair<int, int>>& waypoints) const;
+
+    // Cell path between two consecutive waypoints, searched only inside their
+    // clusters. Owned by the calling thread's PathWorkspace.
+    const std::vector<std::pair<int, int>>& refineSegment(int fromX, int fromY, int toX, int toY) const;
+
+private:
+    // Entrances are split into one node per end once an open run is this long
+    static const int LONG_ENTRANCE = 6;
+
+    struct Node {
+        int32_t x;
+        int32_t y;
+        int32_t cluster;
+        int32_t slot;     // Index within the cluster's node list
+        int32_t partner;  // Node on the other side of the border
+    };
+
+    struct Cluster {
+        int32_t x0;
+        int32_t y0;
+        int32_t width;
+        int32_t height;
+        std::vector<int32_t> nodes;
+        std::vector<int32_t> distances;  // nodes.size()^2 in-cluster distances, row per node
+        std::vector<int32_t> eastBorder;  // Nodes on this side of the east border
+        std::vector<int32_t> northBorder; // Nodes on this side of the north border
+    };
+
+    int clusterOf(int x, int y) const { return (y / clusterSize) * clustersX + (x / clusterSize); }
+
+    void buildBorder(int cluster, bool east);
+    void clearBorder(int cluster, bool east);
+    void buildDistances(int cluster);
+    int addNode(int x, int y, int cluster);
+    void removeNode(int node);
+
+    // Distances from (x, y) to every cell of the cluster, staying inside it
+    void clusterDistances(const Cluster& cluster, int x, int y, std::vector<int32_t>& out) const;
+
+    ObstacleMap map;
+    int clusterSize;
+    int clustersX;
+    int clustersY;
+    std::vector<Cluster> clusters;
+    std::vector<Node> nodes;
+    std::vector<int32_t> freeNodes;
+};
@@ -0,0 +1,70 @@
+﻿#include "JumpTable.h"
+
+const int JumpTable::DX[4] = { 0, 1, 0, -1 };
+const int JumpTable::DY[4] = { 1, 0, -1, 0 };
+
+JumpTable::JumpTable() : width(0), height(0) {}
+
+void JumpTable::build(const ObstacleMap& obstacles) {
+    map = obstacles;
+    width = map.getWidth();
+    height = map.getHeight();
+    size_t cells = static_cast<size_t>(width) * height;
+    for (int dir = 0; dir < 4; ++dir) {
+        clear[dir].assign(cells, 0);
+        jumpDistance[dir].assign(cells, 0);
+    }
+
+    // Entering open (x, y) while moving dx: an open cell above or below that
+    // was blocked beside the previous cell can only be reached through here
+    auto forcedHorizontal = [&](int x, int y, int dx) {
+        return (map.isOpen(x, y - 1) && map.isBlocked(x - dx, y - 1)) ||
+            (map.isOpen(x, y + 1) && map.isBlocked(x - dx, y + 1));
+    };
+    auto forcedVertical = [&](int x, int y, int dy) {
+        return (map.isOpen(x - 1, y) && map.isBlocked(x - 1, y - dy)) ||
+            (map.isOpen(x + 1, y) && map.isBlocked(x + 1, y - dy));
+    };
+
+    // Each direction is filled by walking against it, so every cell can
+    // extend the answer of the neighbour it steps into
+    for (int y = 0; y < height; ++y) {
+        for (int x = width - 1; x >= 0; --x) {
+            int cell = y * width + x;
+            if (map.isBlocked(x + 1, y)) continue;
+            clear[East][cell] = clear[East][cell + 1] + 1;
+            int32_t next = jumpDistance[East][cell + 1];
+            jumpDistance[East][cell] = forcedHorizontal(x + 1, y, 1) ? 1 : (next > 0 ? next + 1 : 0);
+        }
+        for (int x = 0; x < width; ++x) {
+            int cell = y * width + x;
+            if (map.isBlocked(x - 1, y)) continue;
+            clear[West][cell] = clear[West][cell - 1] + 1;
+            int32_t next = jumpDistance[West][cell - 1];
+            jumpDistance[West][cell] = forcedHorizontal(x - 1, y, -1) ? 1 : (next > 0 ? next + 1 : 0);
+        }
+    }
+
+    // Vertical jump points also include every cell whose horizontal jumps succeed
+    auto verticalJumpPoint = [&](int x, int y, int dy) {
+        int cell = y * width + x;
+        return forcedVertical(x, y, dy) || jumpDistance[East][cell] > 0 || jumpDistance[West][cell] > 0;
+    };
+
+    for (int x = 0; x < width; ++x) {
+        for (int y = height - 1; y >= 0; --y) {
+            int cell = y * width + x;
+            if (map.isBlocked(x, y + 1)) continue;
+            clear[North][cell] = clear[North][cell + width] + 1;
+            int32_t next = jumpDistance[North][cell + width];
+            jumpDistance[North][cell] = verticalJumpPoint(x, y + 1, 1) ? 1 : (next > 0 ? next + 1 : 0);
+        }
+        for (int y = 0; y < height; ++y) {
+            int cell = y * width + x;
+            if (map.isBlocked(x, y - 1)) continue;
+            clear[South][cell] = clear[South][cell - width] + 1;
+            int32_t next = jumpDistance[South][cell - width];
+            jumpDistance[South][cell] = verticalJumpPoint(x, y - 1, -1) ? 1 : (next > 0 ? next + 1 : 0);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+﻿#pragma once
+
+#include "ObstacleMap.h"
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+// Precomputed jump distances for Jump Point Search on a static 4-connected
+// obstacle map. For each cell and direction it stores how many open cells
+// follow in a straight line and how far away the first jump point is that
+// does not depend on the goal. A jump then costs O(1) instead of a scan;
+// only the "the goal is on this line" test is done at query time.
+//
+// Jump points follow the usual 4-connected JPS rules: moving horizontally, a
+// cell is a jump point when an open cell beside it was blocked beside the
+// previous cell (a forced neighbour). Moving vertically, the same holds, and
+// also whenever a horizontal jump from the cell would find a jump point.
+class JumpTable {
+public:
+    enum Direction {
+        North = 0,  // +y
+        East = 1,   // +x
+        South = 2,  // -y
+        West = 3    // -x
+    };
+
+    static const int DX[4];
+    static const int DY[4];
+
+    JumpTable();
+
+    // Rebuild whenever the obstacle map changes
+    void build(const ObstacleMap& map);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    const ObstacleMap& getMap() const { return map; }
+
+    // Open cells in a straight line from the cell, not counting itself
+    int32_t clearRun(Direction dir, int cell) const { return clear[dir][cell]; }
+    bool canStep(Direction dir, int cell) const { return clear[dir][cell] > 0; }
+
+    // Next jump point from the cell at (x, y) towards dir for the given goal,
+    // or -1 if the line runs into a wall first. Index converts cells for this
+    // table's width (see GridIndex.h).
+    template <typename Index>
+    int jump(const Index& index, int cell, int x, int y, Direction dir, int goalX, int goalY) const;
+
+private:
+    ObstacleMap map;  // Copy of the map the table was built from
+    int width;
+    int height;
+    std::vector<int32_t> clear[4];
+    std::vector<int32_t> jumpDistance[4];  // Steps to the first goal-independent jump point, 0 if none
+};
+
+template <typename Index>
+int JumpTable::jump(const Index& index, int cell, int x, int y, Direction dir, int goalX, int goalY) const {
+    int32_t run = clear[dir][cell];
+    if (run == 0) return -1;
+
+    int32_t staticJump = jumpDistance[dir][cell];
+    int32_t limit = staticJump > 0 ? staticJump : run;
+
+    if (DY[dir] == 0) {
+        // The goal itself is a jump point when it lies ahead on this row
+        int ahead = (goalX - x) * DX[dir];
+        if (goalY == y && ahead > 0 && ahead <= limit) return index.cell(goalX, goalY);
+    }
+    else {
+        // Moving vertically, the cell on the goal's row is a jump point if a
+        // horizontal jump from it would reach the goal
+        int ahead = (goalY - y) * DY[dir];
+        if (ahead > 0 && ahead <= limit) {
+            int rowCell = index.cell(x, goalY);
+            int across = goalX - x;
+            if (across == 0) return rowCell;
+            Direction toward = across > 0 ? East : West;
+            if (clear[toward][rowCell] >= std::abs(across)) return rowCell;
+        }
+    }
+
+    if (staticJump > 0) return index.cell(x + staticJump * DX[dir], y + staticJump * DY[dir]);
+    return -1;
+}
@@ -0,0 +1,233 @@
+﻿#include "Log.h"
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+namespace Log {
+
+namespace detail {
+namespace {
+
+// A burst of a few thousand lines (one per ball spawned) fits without drops
+const size_t RING_RECORDS = 1 << 13;
+const size_t RING_MASK = RING_RECORDS - 1;
+const auto IDLE_SLEEP = std::chrono::milliseconds(2);
+
+// Bounded multi-producer queue after Dmitry Vyukov's: each cell's sequence
+// says whether it is free for the producer claiming that position or holds a
+// record for the consumer, so producers only contend on the claim counter.
+// There is one consumer, the writer thread.
+class Logger {
+public:
+    Logger() : cells(new Cell[RING_RECORDS]), enqueuePos(0), dequeuePos(0), dropped(0), stopping(false) {
+        for (size_t i = 0; i < RING_RECORDS; ++i) cells[i].sequence.store(i, std::memory_order_relaxed);
+        writer = std::thread(&Logger::run, this);
+    }
+
+    ~Logger() {
+        stopping.store(true, std::memory_order_release);
+        writer.join();
+    }
+
+    Record* claim() {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[pos & RING_MASK];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (difference == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.claimedPos = pos;
+                    return &cell.record;
+                }
+            }
+            else if (difference < 0) {
+                // The writer has not freed this cell yet: full
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void commit(Record* record) {
+        Cell* cell = reinterpret_cast<Cell*>(reinterpret_cast<char*>(record) - offsetof(Cell, record));
+        cell->sequence.store(cell->claimedPos + 1, std::memory_order_release);
+    }
+
+    void flush() {
+        size_t target = enqueuePos.load(std::memory_order_acquire);
+        while (dequeuePos.load(std::memory_order_acquire) < target) std::this_thread::sleep_for(IDLE_SLEEP);
+    }
+
+    uint64_t droppedCount() const {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        size_t claimedPos;  // Written and read only by the claiming producer
+        Record record;
+    };
+
+    void run();
+    bool drain();
+    void format(const Record& record);
+    void writePending(bool toStderr);
+
+    std::unique_ptr<Cell[]> cells;
+    alignas(64) std::atomic<size_t> enqueuePos;
+    alignas(64) std::atomic<size_t> dequeuePos;
+    std::atomic<uint64_t> dropped;
+    std::atomic<bool> stopping;
+    std::thread writer;
+
+    // Writer thread only
+    std::string pending;
+    bool pendingToStderr = false;
+    uint64_t reportedDrops = 0;
+    std::time_t cachedSecond = -1;
+    char cachedStamp[32] = {};
+};
+
+void Logger::run() {
+    while (true) {
+        // Read the flag first so a record committed before shutdown is drained
+        bool stop = stopping.load(std::memory_order_acquire);
+        if (!drain()) {
+            if (stop) break;
+            std::this_thread::sleep_for(IDLE_SLEEP);
+        }
+    }
+}
+
+// Formats every committed record into one batch per stream; false if there
+// were none
+bool Logger::drain() {
+    bool any = false;
+    size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    while (true) {
+        Cell& cell = cells[pos & RING_MASK];
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1) break;
+
+        bool toStderr = cell.record.level >= Level::Warning;
+        if (toStderr != pendingToStderr) writePending(pendingToStderr);
+        pendingToStderr = toStderr;
+        format(cell.record);
+
+        cell.sequence.store(pos + RING_RECORDS, std::memory_order_release);
+        dequeuePos.store(++pos, std::memory_order_release);
+        any = true;
+    }
+
+    uint64_t drops = dropped.load(std::memory_order_relaxed);
+    if (drops != reportedDrops) {
+        writePending(pendingToStderr);
+        std::cerr << "[Log] Dropped " << drops - reportedDrops << " messages; the log queue was full\n";
+        reportedDrops = drops;
+    }
+    writePending(pendingToStderr);
+    return any;
+}
+
+void Logger::format(const Record& record) {
+    // "[YYYY-MM-DD HH:MM:SS.mmm] ", reformatting the date once a second
+    std::time_t second = static_cast<std::time_t>(record.timeNs / 1000000000);
+    if (second != cachedSecond) {
+        std::tm local;
+#ifdef _WIN32
+        localtime_s(&local, &second);
+#else
+        localtime_r(&second, &local);
+#endif
+        std::strftime(cachedStamp, sizeof(cachedStamp), "[%Y-%m-%d %H:%M:%S", &local);
+        cachedSecond = second;
+    }
+    char millis[8];
+    std::snprintf(millis, sizeof(millis), ".%03u] ", static_cast<unsigned>(record.timeNs / 1000000 % 1000));
+    pending += cachedStamp;
+    pending += millis;
+
+    size_t arg = 0;
+    char number[32];
+    for (const char* c = record.format; *c; ++c) {
+        if (c[0] != '{' || c[1] != '}' || arg == record.argCount) {
+            pending += *c;
+            continue;
+        }
+        const Record::Value& value = record.values[arg];
+        switch (record.types[arg]) {
+        case ArgType::Int:
+            std::snprintf(number, sizeof(number), "%lld", static_cast<long long>(value.i));
+            pending += number;
+            break;
+        case ArgType::UInt:
+            std::snprintf(number, sizeof(number), "%llu", static_cast<unsigned long long>(value.u));
+            pending += number;
+            break;
+        case ArgType::Double:
+            std::snprintf(number, sizeof(number), "%g", value.d);
+            pending += number;
+            break;
+        case ArgType::Char:
+            pending += static_cast<char>(value.i);
+            break;
+        case ArgType::Text:
+            pending.append(record.text + value.text[0], value.text[1]);
+            break;
+        }
+        ++arg;
+        ++c;
+    }
+    pending += '\n';
+}
+
+void Logger::writePending(bool toStderr) {
+    if (pending.empty()) return;
+    std::ostream& out = toStderr ? std::cerr : std::cout;
+    out.write(pending.data(), static_cast<std::streamsize>(pending.size()));
+    out.flush();
+    pending.clear();
+}
+
+// Started on first use and drained when the program exits
+Logger& logger() {
+    static Logger instance;
+    return instance;
+}
+
+}  // namespace
+
+Record* beginRecord(Level level, const char* format) {
+    Record* record = logger().claim();
+    if (!record) return nullptr;
+    record->timeNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    record->format = format;
+    record->level = level;
+    record->argCount = 0;
+    record->textUsed = 0;
+    return record;
+}
+
+void commitRecord(Record* record) {
+    logger().commit(record);
+}
+
+}  // namespace detail
+
+void flush() {
+    detail::logger().flush();
+}
+
+uint64_t droppedCount() {
+    return detail::logger().droppedCount();
+}
+
+}  // namespace Log
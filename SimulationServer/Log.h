@@ -0,0 +1,153 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+// Asynchronous console log. A call copies its format string pointer and raw
+// arguments into a fixed-size binary record in a lock-free ring and returns;
+// a background thread formats the records and writes them out in batches,
+// Warning and Error to stderr, the rest to stdout, each line prefixed with
+// the time it was logged. When the ring is full the message is dropped and
+// counted rather than making the caller wait, and the writer reports how
+// many were lost.
+//
+// Messages use "{}" placeholders filled in order, e.g.
+//     LOG_INFO("[Server] Client connected! ({} connected)", clients.size());
+// Arguments may be integers, floating point, char, const char* or
+// std::string; strings are copied, so the caller's buffers may go away.
+// Arguments are taken by value, so a log line never needs an out-of-class
+// definition of a static const member it prints. The format itself must be
+// a string literal.
+//
+// Levels below SIMULATION_LOG_LEVEL (CMake cache variable of the same name)
+// compile to nothing, arguments included.
+#ifndef SIMULATION_LOG_LEVEL
+#define SIMULATION_LOG_LEVEL 0
+#endif
+
+namespace Log {
+
+constexpr int MIN_LEVEL = SIMULATION_LOG_LEVEL;
+
+enum class Level : uint8_t {
+    Debug = 0,  // Per-unit and per-frame chatter
+    Info = 1,
+    Warning = 2,
+    Error = 3
+};
+
+// True if messages of level are compiled in
+constexpr bool enabled(Level level) {
+    return static_cast<int>(level) >= MIN_LEVEL;
+}
+
+// Blocks until everything logged so far has been written, e.g. before
+// printing to std::cout directly
+void flush();
+
+// Messages lost to a full ring since startup
+uint64_t droppedCount();
+
+namespace detail {
+
+const size_t MAX_ARGS = 8;
+const size_t TEXT_BYTES = 160;  // Shared by all string arguments of a record
+
+enum class ArgType : uint8_t { Int, UInt, Double, Char, Text };
+
+struct Record {
+    uint64_t timeNs;  // System clock, for the line prefix
+    const char* format;
+    Level level;
+    uint8_t argCount;
+    uint8_t textUsed;
+    ArgType types[MAX_ARGS];
+    union Value {
+        int64_t i;
+        uint64_t u;
+        double d;
+        uint8_t text[2];  // Offset and length within text
+    } values[MAX_ARGS];
+    char text[TEXT_BYTES];
+};
+
+// Claims the next free slot, or returns null (and counts a drop) when full
+Record* beginRecord(Level level, const char* format);
+void commitRecord(Record* record);
+
+inline void capture(Record& record, const char* text, size_t length) {
+    size_t room = TEXT_BYTES - record.textUsed;
+    if (length > room) length = room;  // Truncated; the line still goes out
+    if (length > 255) length = 255;
+    std::memcpy(record.text + record.textUsed, text, length);
+    Record::Value& value = record.values[record.argCount];
+    value.text[0] = record.textUsed;
+    value.text[1] = static_cast<uint8_t>(length);
+    record.types[record.argCount++] = ArgType::Text;
+    record.textUsed = static_cast<uint8_t>(record.textUsed + length);
+}
+
+inline void capture(Record& record, const char* text) {
+    capture(record, text ? text : "(null)", text ? std::strlen(text) : 6);
+}
+
+inline void capture(Record& record, const std::string& text) {
+    capture(record, text.data(), text.size());
+}
+
+inline void capture(Record& record, char c) {
+    record.values[record.argCount].i = c;
+    record.types[record.argCount++] = ArgType::Char;
+}
+
+template <typename T>
+void capture(Record& record, T value) {
+    static_assert(std::is_arithmetic<T>::value, "log arguments must be numbers, chars or strings");
+    Record::Value& slot = record.values[record.argCount];
+    if constexpr (std::is_floating_point<T>::value) {
+        slot.d = static_cast<double>(value);
+        record.types[record.argCount++] = ArgType::Double;
+    }
+    else if constexpr (std::is_signed<T>::value) {
+        slot.i = static_cast<int64_t>(value);
+        record.types[record.argCount++] = ArgType::Int;
+    }
+    else {
+        slot.u = static_cast<uint64_t>(value);
+        record.types[record.argCount++] = ArgType::UInt;
+    }
+}
+
+inline void captureAll(Record&) {}
+
+template <typename First, typename... Rest>
+void captureAll(Record& record, const First& first, const Rest&... rest) {
+    capture(record, first);
+    captureAll(record, rest...);
+}
+
+}  // namespace detail
+
+template <size_t N, typename... Args>
+void write(Level level, const char (&format)[N], Args... args) {
+    static_assert(sizeof...(Args) <= detail::MAX_ARGS, "too many log arguments");
+    detail::Record* record = detail::beginRecord(level, format);
+    if (!record) return;
+    detail::captureAll(*record, args...);
+    detail::commitRecord(record);
+}
+
+}  // namespace Log
+
+#define LOG_AT(level, ...) \
+    do { \
+        if (Log::enabled(level)) Log::write(level, __VA_ARGS__); \
+    } while (0)
+#define LOG_DEBUG(...) LOG_AT(Log::Level::Debug, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(Log::Level::Info, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_AT(Log::Level::Warning, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(Log::Level::Error, __VA_ARGS__)
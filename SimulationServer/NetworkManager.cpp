@@ -1,66 +1,93 @@
 ﻿#include "NetworkManager.h"
 #include "GameConfig.h"
-#include <iostream>
-#include <sstream>
-#include <iomanip>
+#include "Log.h"
+#include "SnapshotProtocol.h"
+#include "Tracing.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 
 NetworkManager::NetworkManager(SimulationManager& simManager)
-    : simulationManager(simManager), serverSocket(INVALID_SOCKET),
-    clientSocket(INVALID_SOCKET), initialized(false) {}
+    : simulationManager(&simManager), replay(nullptr), replayTick(0), config(simManager.getConfig()),
+    serverSocket(SocketPlatform::InvalidSocket), initialized(false), closed(false), nextFrameTime(0),
+    streaming(false), cachedKeyframeKey(0) {}
+
+NetworkManager::NetworkManager(const GameConfig& gameConfig, ReplayReader& replayReader)
+    : simulationManager(nullptr), replay(&replayReader), replayTick(0), config(gameConfig),
+    serverSocket(SocketPlatform::InvalidSocket), initialized(false), closed(false), nextFrameTime(0),
+    streaming(false), cachedKeyframeKey(0) {}
 
 NetworkManager::~NetworkManager() {
     closeConnection();
 }
 
-std::string getCurrentTimestamp() {
-    using namespace std::chrono;
-
-    auto now = system_clock::now();
-    auto timeT = system_clock::to_time_t(now);
-    auto nowMs = duration_cast<milliseconds>(now.time_since_epoch()) % 1000;
-
-    std::tm tmTime;
-    localtime_s(&tmTime, &timeT);
-
-    std::ostringstream oss;
-    oss << std::put_time(&tmTime, "[%Y-%m-%d %H:%M:%S]")
-        << "." << std::setw(3) << std::setfill('0') << nowMs.count();
-
-    return oss.str();
-}
-
 bool NetworkManager::initialize() {
-    WSADATA wsa;
-    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
-        std::cerr << "[Server] WSAStartup failed!\n";
+    if (!SocketPlatform::startup()) {
+        LOG_ERROR("[Server] Socket startup failed!");
         return false;
     }
 
     serverSocket = socket(AF_INET, SOCK_STREAM, 0);
-    if (serverSocket == INVALID_SOCKET) {
-        std::cerr << "[Server] Failed to create socket.\n";
-        WSACleanup();
+    if (serverSocket == SocketPlatform::InvalidSocket) {
+        LOG_ERROR("[Server] Failed to create socket.");
+        SocketPlatform::cleanup();
         return false;
     }
 
-    const char opt = 1;
-    setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    int opt = 1;
+    setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&opt), sizeof(opt));
 
-    sockaddr_in serverAddr = { AF_INET, htons(GameConfig::SERVER_PORT), INADDR_ANY };
-    if (bind(serverSocket, (sockaddr*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
-        std::cerr << "[Server] Bind failed.\n";
-        closesocket(serverSocket);
-        WSACleanup();
+    sockaddr_in serverAddr;
+    std::memset(&serverAddr, 0, sizeof(serverAddr));
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(config.serverPort);
+    serverAddr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (bind(serverSocket, (sockaddr*)&serverAddr, sizeof(serverAddr)) != 0) {
+        LOG_ERROR("[Server] Bind failed.");
+        SocketPlatform::closeSocket(serverSocket);
+        SocketPlatform::cleanup();
+        return false;
+    }
+
+    if (listen(serverSocket, SOMAXCONN) != 0) {
+        LOG_ERROR("[Server] Listen failed.");
+        SocketPlatform::closeSocket(serverSocket);
+        SocketPlatform::cleanup();
         return false;
     }
 
-    if (listen(serverSocket, 1) == SOCKET_ERROR) {
-        std::cerr << "[Server] Listen failed.\n";
-        closesocket(serverSocket);
-        WSACleanup();
+    // All sockets are non-blocking and serviced from the network thread's poll loop
+    if (!SocketPlatform::setNonBlocking(serverSocket) || !poller.initialize() ||
+        !poller.add(serverSocket, false)) {
+        LOG_ERROR("[Server] Failed to set up connection poller.");
+        SocketPlatform::closeSocket(serverSocket);
+        SocketPlatform::cleanup();
         return false;
     }
 
+    if (config.udpPort != 0 && replay) {
+        LOG_WARNING("[Server] Replays are served over TCP only; ignoring udp-port.");
+    }
+    else if (config.udpPort != 0) {
+        udp.reset(new UdpTransport(config));
+        if (!udp->open() || !poller.add(udp->getSocket(), false)) {
+            udp.reset();
+            SocketPlatform::closeSocket(serverSocket);
+            SocketPlatform::cleanup();
+            return false;
+        }
+    }
+
+    // Wake the poll loop as soon as the simulation publishes a tick it can send
+    if (simulationManager) {
+        simulationManager->setUpdateListener([this] {
+            if (std::chrono::steady_clock::now().time_since_epoch().count() >= nextFrameTime.load(std::memory_order_relaxed)) {
+                poller.wakeup();
+            }
+        });
+    }
+
     initialized = true;
     return true;
 }
@@ -68,106 +95,487 @@ bool NetworkManager::initialize() {
 bool NetworkManager::waitForClient() {
     if (!initialized) return false;
 
-    std::cout << "[Server] Waiting for Unreal client...\n";
+    LOG_INFO("[Server] Waiting for Unreal client...");
+
+    while (getClientCount() == 0) {
+        if (simulationManager && simulationManager->shouldExit()) return false;
+        pollOnce(config.updateIntervalMs);
+    }
+
+    if (simulationManager) simulationManager->signalClientConnected();
+    return true;
+}
+
+void NetworkManager::pollOnce(int timeoutMs) {
+    if (udp) timeoutMs = udp->pollTimeout(timeoutMs);
+    if (!poller.wait(timeoutMs, readyEvents)) {
+        LOG_ERROR("[Server] Connection poller failed.");
+        return;
+    }
+
+    for (const auto& event : readyEvents) {
+        if (event.socket == serverSocket) {
+            acceptClients();
+            continue;
+        }
+        if (udp && event.socket == udp->getSocket()) {
+            udp->receive();
+            continue;
+        }
+
+        auto it = clients.find(event.socket);
+        if (it == clients.end()) continue;
+
+        if (event.readable || event.hangup) readFromClient(it->second);
+        if (event.writable && !flushClient(it->second)) closedClients.push_back(event.socket);
+    }
+
+    for (auto socket : closedClients) disconnectClient(socket);
+    closedClients.clear();
+    if (udp) udp->flushDelayed();
+}
+
+void NetworkManager::acceptClients() {
+    // Accept everything queued on the listen socket; the poller is level-triggered
+    // but draining here avoids one wakeup per pending connection.
+    while (true) {
+        SocketPlatform::SocketHandle clientSocket = accept(serverSocket, nullptr, nullptr);
+        if (clientSocket == SocketPlatform::InvalidSocket) {
+            if (!SocketPlatform::lastErrorWouldBlock()) {
+                LOG_ERROR("[Server] Accept failed.");
+            }
+            return;
+        }
+
+        if (!SocketPlatform::setNonBlocking(clientSocket) || !poller.add(clientSocket, false)) {
+            LOG_ERROR("[Server] Failed to register client socket.");
+            SocketPlatform::closeSocket(clientSocket);
+            continue;
+        }
+        SocketPlatform::setNoDelay(clientSocket);
+
+        ClientConnection& client = clients[clientSocket];
+        client.socket = clientSocket;
+        LOG_INFO("[Server] Client connected! ({} connected)", clients.size());
+
+        // Every client starts from a full state. Once frames are streaming, a
+        // late joiner gets the state the others were last sent, so the deltas
+        // that follow apply to it too and nobody else needs a resync.
+        if (simulationManager && !streaming) simulationManager->acquirePublishedState();
+        queueToClient(client, latestKeyframe());
+        LOG_INFO("[Server] Sent initialization data to client.");
+    }
+}
+
+void NetworkManager::readFromClient(ClientConnection& client) {
+    // Read everything available straight into the client's decoder
+    while (true) {
+        size_t writable = 0;
+        uint8_t* buffer = client.inbound.prepareWrite(256, writable);
+        int received = recv(client.socket, reinterpret_cast<char*>(buffer), static_cast<int>(std::min<size_t>(writable, 1 << 20)), 0);
+        if (received > 0) {
+            client.inbound.commitWrite(static_cast<size_t>(received));
+            continue;
+        }
+        if (received < 0 && SocketPlatform::lastErrorWouldBlock()) break;
+
+        closedClients.push_back(client.socket);
+        return;
+    }
+
+    SnapshotProtocol::FrameView message;
+    SnapshotProtocol::DecodeStatus status;
+    while ((status = client.inbound.next(message)) == SnapshotProtocol::DecodeStatus::Frame) {
+        handleClientMessage(client, message);
+    }
+    if (status == SnapshotProtocol::DecodeStatus::Malformed) {
+        LOG_WARNING("[Server] Malformed message from a client; disconnecting it.");
+        closedClients.push_back(client.socket);
+    }
+}
+
+void NetworkManager::handleClientMessage(ClientConnection& client, const SnapshotProtocol::FrameView& message) {
+    if (message.type != SnapshotProtocol::MessageType::Viewport) {
+        LOG_WARNING("[Server] Ignoring message type {} from a client.", static_cast<int>(message.type));
+        return;
+    }
+    if (replay) {
+        LOG_DEBUG("[Server] Viewports are not supported in replay mode; sending every unit.");
+        return;
+    }
+
+    int margin = config.viewportMargin;
+    client.viewMinX = message.viewMinX - margin;
+    client.viewMinY = message.viewMinY - margin;
+    client.viewMaxX = message.viewMaxX + margin;
+    client.viewMaxY = message.viewMaxY + margin;
+    if (!client.hasViewport) {
+        // The client was sent every unit so far; start it over with only the visible ones
+        client.hasViewport = true;
+        client.needsViewKeyframe = true;
+    }
+    LOG_DEBUG("[Server] Client viewport ({}, {}) to ({}, {})", message.viewMinX, message.viewMinY, message.viewMaxX,
+        message.viewMaxY);
+}
+
+bool NetworkManager::flushClient(ClientConnection& client) {
+    while (!client.outbound.empty()) {
+        const std::string& frame = *client.outbound.front();
+        if (client.outboundOffset == frame.size()) {
+            client.outbound.pop_front();
+            client.outboundOffset = 0;
+            continue;
+        }
 
-    clientSocket = accept(serverSocket, nullptr, nullptr);
-    if (clientSocket == INVALID_SOCKET) {
-        std::cerr << "[Server] Accept failed.\n";
+        const char* data = frame.data() + client.outboundOffset;
+        int remaining = static_cast<int>(frame.size() - client.outboundOffset);
+        int sent = send(client.socket, data, remaining, SocketPlatform::SendFlags);
+        if (sent > 0) {
+            client.outboundOffset += sent;
+            client.pendingBytes -= sent;
+            continue;
+        }
+        if (sent < 0 && SocketPlatform::lastErrorWouldBlock()) break;
         return false;
     }
 
-    std::cout << "[Server] Client connected!\n";
-    simulationManager.signalClientConnected();
+    // Only ask for writability while there is something left to send
+    bool needsWrite = !client.outbound.empty();
+    if (needsWrite != client.wantsWrite) {
+        poller.modify(client.socket, needsWrite);
+        client.wantsWrite = needsWrite;
+    }
     return true;
 }
 
-void NetworkManager::sendInitializationData() {
-    if (clientSocket == INVALID_SOCKET) return;
+bool NetworkManager::queueToClient(ClientConnection& client, const FrameBuffer& frame) {
+    if (client.pendingBytes > MAX_PENDING_BYTES) {
+        // Lagging client skips this frame and is resynced with a keyframe later
+        client.needsKeyframe = true;
+        return false;
+    }
 
-    auto balls = simulationManager.getBalls();
-    std::ostringstream ss;
+    bool wasIdle = client.outbound.empty();
+    client.outbound.push_back(frame);  // Shares the buffer; nothing is copied
+    client.pendingBytes += frame->size();
 
-    ss << "GridSize=" << GameConfig::GRID_SIZE << ";BallCount=" << balls.size();
+    // Try to write immediately; leftovers are sent when the socket becomes writable
+    if (wasIdle && !flushClient(client)) {
+        closedClients.push_back(client.socket);
+    }
+    return true;
+}
 
-    for (const auto& ball : balls) {
-        ss << ";" << ball->getID() << "," << ball->getX() << "," << ball->getY()
-            << "," << ball->getHp() << "," << (ball->isRedTeam() ? "1" : "0");
+void NetworkManager::broadcast(const FrameBuffer& message) {
+    for (auto& entry : clients) {
+        queueToClient(entry.second, message);
     }
 
-    std::string initMessage = ss.str();
-    send(clientSocket, initMessage.c_str(), static_cast<int>(initMessage.length()), 0);
-    std::cout << "[Server] Sent initialization data to client.\n";
+    for (auto socket : closedClients) disconnectClient(socket);
+    closedClients.clear();
 }
 
-void NetworkManager::sendSimulationData() {
-    if (clientSocket == INVALID_SOCKET) return;
+void NetworkManager::broadcastFrame(const FrameBuffer& frame, bool isKeyframe) {
+    for (auto& entry : clients) {
+        ClientConnection& client = entry.second;
+        if (client.hasViewport) continue;
 
-    std::string lastSentData;
-    auto lastSendTime = std::chrono::steady_clock::now();
+        if (client.needsKeyframe && !isKeyframe) {
+            // A delta is meaningless to a client that missed an earlier one
+            if (queueToClient(client, latestKeyframe())) client.needsKeyframe = false;
+            continue;
+        }
 
-    while (!simulationManager.shouldExit()) {
-        // Wait for simulation update
-        simulationManager.waitForUpdate();
+        if (queueToClient(client, frame)) client.needsKeyframe = false;
+    }
 
-        if (simulationManager.isGameOver()) {
-            sendGameOverMessage(simulationManager.getWinningTeam());
-            break;
+    for (auto socket : closedClients) disconnectClient(socket);
+    closedClients.clear();
+}
+
+void NetworkManager::sendViewportFrames(const SnapshotProtocol::SimulationSnapshot& state, bool isKeyframe) {
+    bool anyViewport = false;
+    for (const auto& entry : clients) anyViewport = anyViewport || entry.second.hasViewport;
+    if (!anyViewport) return;
+
+    // One index per frame, shared by every viewport
+    viewportIndex.rebuild(state.units, config.gridSize);
+    auto isAlive = [&state](uint32_t id) {
+        auto found = std::lower_bound(state.units.begin(), state.units.end(), id,
+            [](const SnapshotProtocol::UnitRecord& unit, uint32_t value) { return unit.id < value; });
+        return found != state.units.end() && found->id == id;
+    };
+
+    for (auto& entry : clients) {
+        ClientConnection& client = entry.second;
+        if (!client.hasViewport) continue;
+
+        viewportIndex.query(client.viewMinX, client.viewMinY, client.viewMaxX, client.viewMaxY, nowVisible);
+        std::string& viewFrame = reuseFrame(client.viewFrame);
+        if (isKeyframe || client.needsViewKeyframe) {
+            SnapshotProtocol::encodeKeyframe(viewFrame, state.tick, config.gridSize, nowVisible);
         }
+        else {
+            // Compared with what this client was last sent, so frames it
+            // skipped while lagging are caught up without a keyframe
+            SnapshotProtocol::diffUnits(client.visible, nowVisible, state.tick, viewChanges,
+                SnapshotProtocol::FIELD_ALL | SnapshotProtocol::FIELD_ENTERED);
+
+            // Units gone from the view either died or walked out of it
+            leftIds.clear();
+            size_t died = 0;
+            for (uint32_t id : viewChanges.removedIds) {
+                if (isAlive(id)) leftIds.push_back(id);
+                else viewChanges.removedIds[died++] = id;
+            }
+            viewChanges.removedIds.resize(died);
 
-        // Prepare data packet
-        auto balls = simulationManager.getBalls();
-        std::ostringstream ss;
-        ss << balls.size();
+            if (viewChanges.units.empty() && viewChanges.removedIds.empty() && leftIds.empty()) continue;
+            SnapshotProtocol::encodeViewDelta(viewFrame, viewChanges, leftIds);
+        }
 
-        for (const auto& ball : balls) {
-            ss << ";" << ball->getID() << "," << ball->getX() << ","
-                << ball->getY() << "," << ball->getHp() << "," << (ball->isRedTeam() ? "1" : "0");
+        if (queueToClient(client, client.viewFrame)) {
+            client.visible.swap(nowVisible);
+            client.needsViewKeyframe = false;
         }
+    }
+
+    for (auto socket : closedClients) disconnectClient(socket);
+    closedClients.clear();
+}
+
+void NetworkManager::disconnectClient(SocketPlatform::SocketHandle socket) {
+    auto it = clients.find(socket);
+    if (it == clients.end()) return;
+
+    poller.remove(socket);
+    SocketPlatform::closeSocket(socket);
+    clients.erase(it);
+
+    LOG_INFO("[Server] Client disconnected. ({} connected)", clients.size());
+}
 
-        std::string updateMessage = ss.str();
+void NetworkManager::drainPendingOutput(int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
 
-        // Only send if data has changed
-        if (updateMessage != lastSentData) {
-            lastSentData = updateMessage;
+    while (std::chrono::steady_clock::now() < deadline) {
+        bool pending = false;
+        for (const auto& entry : clients) {
+            if (!entry.second.outbound.empty()) pending = true;
+        }
+        if (udp && udp->hasDelayed()) pending = true;
+        if (!pending) return;
 
-            // Send the data packet
-            int result = send(clientSocket, updateMessage.c_str(), static_cast<int>(updateMessage.length()), 0);
+        pollOnce(10);
+    }
+}
 
-            if (result == SOCKET_ERROR) {
-                std::cerr << "[Server] Client disconnected. Stopping server.\n";
-                simulationManager.signalShouldExit();
-                return;
+NetworkManager::FrameBuffer NetworkManager::latestKeyframe() {
+    uint64_t key = replay ? replayTick : simulationManager->getPublishedState().sequence;
+    if (cachedKeyframe && cachedKeyframeKey == key) return cachedKeyframe;
+
+    TRACE_SCOPE("serialize");
+    auto keyframe = std::make_shared<std::string>();
+    if (replay) {
+        replay->buildKeyframe(replayTick, *keyframe);
+    }
+    else {
+        const SnapshotProtocol::SimulationSnapshot& state = simulationManager->getPublishedState().state;
+        SnapshotProtocol::encodeKeyframe(*keyframe, state.tick, config.gridSize, state.units);
+    }
+    cachedKeyframe = std::move(keyframe);
+    cachedKeyframeKey = key;
+    return cachedKeyframe;
+}
+
+std::string& NetworkManager::reuseFrame(std::shared_ptr<std::string>& frame) {
+    // Only the network thread touches frames, so the count is exact
+    if (!frame || frame.use_count() > 1) frame = std::make_shared<std::string>();
+    frame->clear();
+    return *frame;
+}
+
+std::chrono::milliseconds NetworkManager::frameBudget() const {
+    if (config.frameIntervalMs > 0) return std::chrono::milliseconds(config.frameIntervalMs);
+    // Faster than real time, clients still get frames at the real tick rate
+    if (config.timeScale == 0 || config.timeScale > 1) return std::chrono::milliseconds(config.updateIntervalMs);
+    return std::chrono::milliseconds::zero();
+}
+
+void NetworkManager::sendSimulationData() {
+    if (!initialized || !simulationManager) return;
+
+    using Clock = std::chrono::steady_clock;
+    Tracing::setThreadName("network");
+    streaming = true;
+    int framesSinceKeyframe = 0;
+    uint64_t lastSentSequence = 0;
+
+    // With a frame budget, ticks between frames are folded into one delta
+    // against the units last sent, so the simulation never waits on clients
+    const Clock::duration budget = frameBudget();
+    const bool subsampling = budget > Clock::duration::zero();
+    std::vector<SnapshotProtocol::UnitRecord> sentUnits;
+    SnapshotProtocol::SimulationSnapshot folded;
+    int timeoutMs = config.updateIntervalMs;
+
+    while (true) {
+        // Sleeps until a socket is ready, the simulation wakes us with a new
+        // tick or the next frame is due
+        pollOnce(timeoutMs);
+        Tracing::dumpIfRequested();
+        timeoutMs = config.updateIntervalMs;
+
+        // Published states are immutable, so nothing here waits on the simulation
+        simulationManager->acquirePublishedState();
+        const PublishedState& published = simulationManager->getPublishedState();
+
+        Clock::time_point now = Clock::now();
+        if (subsampling && published.sequence != lastSentSequence && now.time_since_epoch().count() < nextFrameTime) {
+            auto untilDue = Clock::time_point(Clock::duration(nextFrameTime.load())) - now;
+            timeoutMs = static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(untilDue).count());
+        }
+        else if (published.sequence != lastSentSequence && published.winningTeam.empty()) {
+            // The changes only cover the step from the previous publication; if
+            // any publication was skipped, fold the ticks in between into one
+            // delta, or resync everyone with a keyframe when not subsampling
+            bool skipped = published.sequence != lastSentSequence + 1;
+            bool foldSkipped = skipped && subsampling && lastSentSequence != 0;
+            bool isKeyframe = ++framesSinceKeyframe >= config.keyframeInterval || (skipped && !foldSkipped);
+            lastSentSequence = published.sequence;
+            if (subsampling) nextFrameTime = (now + budget).time_since_epoch().count();
+
+            // Encoded once, however many clients it goes to
+            const SnapshotProtocol::SimulationSnapshot* changes = &published.changes;
+            FrameBuffer frame;
+            if (isKeyframe) {
+                frame = latestKeyframe();
+                framesSinceKeyframe = 0;
+            }
+            else {
+                TRACE_SCOPE("serialize");
+                if (foldSkipped) {
+                    SnapshotProtocol::diffUnits(sentUnits, published.state.units, published.state.tick, folded);
+                    changes = &folded;
+                }
+                if (!changes->units.empty() || !changes->removedIds.empty()) {
+                    SnapshotProtocol::encodeDelta(reuseFrame(deltaFrame), *changes);
+                    frame = deltaFrame;
+                }
             }
+            if (subsampling) sentUnits = published.state.units;
 
-            std::cout << getCurrentTimestamp() << " [Server] Sent data: " << updateMessage << std::endl;
+            {
+                TRACE_SCOPE("send");
+                if (frame) broadcastFrame(frame, isKeyframe);
+                sendViewportFrames(published.state, isKeyframe);
+                if (udp) udp->sendSnapshot(published.state, config.gridSize);
+            }
+            if (frame) {
+                const SnapshotProtocol::SimulationSnapshot& sent = isKeyframe ? published.state : *changes;
+                LOG_DEBUG("[Server] Sent {} for tick {}: {} units, {} removed, {} bytes", isKeyframe ? "keyframe" : "delta",
+                    sent.tick, sent.units.size(), sent.removedIds.size(), frame->size());
+            }
         }
 
-        // Reset update flag only after sending
-        simulationManager.resetUpdateFlag();
+        if (simulationManager->shouldExit()) {
+            // The final tick is published before the exit flag is raised
+            simulationManager->acquirePublishedState();
+            const std::string& winningTeam = simulationManager->getPublishedState().winningTeam;
+            if (!winningTeam.empty()) {
+                sendGameOverMessage(winningTeam);
+            }
+            drainPendingOutput(1000);
+            return;
+        }
     }
 }
 
-void NetworkManager::sendGameOverMessage(const std::string& message) {
-    if (clientSocket == INVALID_SOCKET) return;
+void NetworkManager::playReplay(uint32_t fromTick, double speed) {
+    if (!initialized || !replay) return;
 
-    std::string gameOverMessage = "GameOver:" + message;
-    send(clientSocket, gameOverMessage.c_str(), static_cast<int>(gameOverMessage.length()), 0);
-    std::cout << "[Server] Sent '" << gameOverMessage << "' to client.\n";
+    Tracing::setThreadName("network");
+    replayTick = std::min(std::max(fromTick, replay->getFirstTick()), replay->getLastTick());
+
+    // Clients get the state at replayTick when they connect, so playback
+    // continues from the frame after it
+    LOG_INFO("[Server] Waiting for a client to watch the replay...");
+    while (clients.empty()) pollOnce(config.updateIntervalMs);
+    replay->seek(replayTick);
+
+    ReplayReader::Frame frame;
+    bool more = replay->next(frame);
+    while (more && frame.tick <= replayTick && frame.type != SnapshotProtocol::MessageType::GameOver) {
+        more = replay->next(frame);
+    }
+    if (speed > 0) LOG_INFO("[Server] Replaying ticks {} to {} at {}x speed", replayTick, replay->getLastTick(), speed);
+    else LOG_INFO("[Server] Replaying ticks {} to {} as fast as clients take them", replayTick, replay->getLastTick());
+
+    // Speed 0 sends as fast as the clients take it
+    using Clock = std::chrono::steady_clock;
+    Clock::duration tickLength = Clock::duration::zero();
+    if (speed > 0) {
+        tickLength = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::milli>(config.updateIntervalMs / speed));
+    }
+    auto nextTickTime = Clock::now() + tickLength;
+    std::shared_ptr<std::string> buffer;
+
+    while (more) {
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(nextTickTime - Clock::now());
+        pollOnce(wait.count() > 0 ? static_cast<int>(wait.count()) : 0);
+        Tracing::dumpIfRequested();
+        if (Clock::now() < nextTickTime) continue;
+
+        // One tick: its keyframe or delta, and the GameOver frame on the last one
+        uint32_t tick = frame.tick;
+        do {
+            replayTick = frame.tick;  // Resync keyframes include this frame
+            reuseFrame(buffer).assign(frame.data, frame.size);
+            if (frame.type == SnapshotProtocol::MessageType::Keyframe) {
+                // Already the full state at replayTick, so joining and lagging clients can share it
+                cachedKeyframe = buffer;
+                cachedKeyframeKey = replayTick;
+            }
+            if (frame.type == SnapshotProtocol::MessageType::GameOver) {
+                broadcast(buffer);
+                LOG_INFO("[Server] Replay reached the end of the battle.");
+            }
+            else {
+                TRACE_SCOPE("send");
+                broadcastFrame(buffer, frame.type == SnapshotProtocol::MessageType::Keyframe);
+            }
+            more = replay->next(frame);
+        } while (more && frame.tick == tick);
+        nextTickTime += tickLength;
+    }
+
+    drainPendingOutput(1000);
+    LOG_INFO("[Server] Replay finished at tick {}.", replayTick);
+}
+
+void NetworkManager::sendGameOverMessage(const std::string& message) {
+    auto gameOverMessage = std::make_shared<std::string>();
+    SnapshotProtocol::encodeGameOver(*gameOverMessage, simulationManager->getPublishedState().state.tick, message);
+    broadcast(gameOverMessage);
+    if (udp) udp->sendGameOver(simulationManager->getPublishedState().state.tick, message);
+    LOG_INFO("[Server] Sent 'GameOver:{}' to {} client(s).", message, getClientCount());
 }
 
 void NetworkManager::closeConnection() {
-    static std::atomic<bool> closed(false);
     if (closed.exchange(true)) return;  // Ensure it runs only once
 
-    if (clientSocket != INVALID_SOCKET) {
-        closesocket(clientSocket);
-        clientSocket = INVALID_SOCKET;
+    for (auto& entry : clients) {
+        SocketPlatform::closeSocket(entry.first);
     }
+    clients.clear();
 
-    if (serverSocket != INVALID_SOCKET) {
-        closesocket(serverSocket);
-        serverSocket = INVALID_SOCKET;
+    if (serverSocket != SocketPlatform::InvalidSocket) {
+        SocketPlatform::closeSocket(serverSocket);
+        serverSocket = SocketPlatform::InvalidSocket;
     }
+    if (udp) udp->close();
 
-    std::cout << "[Server] All connections closed properly.\n";
-}
\ No newline at end of file
+    SocketPlatform::cleanup();
+    LOG_INFO("[Server] All connections closed properly.");
+}
@@ -1,27 +1,121 @@
 ﻿#pragma once
 
-#include <winsock2.h>
+#include "SocketPlatform.h"
+#include "ConnectionPoller.h"
+#include "GameConfig.h"
+#include "ReplayReader.h"
+#include "UdpTransport.h"
+#include "ViewportIndex.h"
+#include <SnapshotProtocol/StreamDecoder.h>
 #include <string>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include "SimulationManager.h"
 
-#pragma comment(lib, "ws2_32.lib")
-
+// Serves the live simulation or, with the replay constructor, a recording;
+// clients cannot tell the two apart. Live battles can also go out over UDP
+// when udp-port is set.
 class NetworkManager {
 public:
     NetworkManager(SimulationManager& simManager);
+    NetworkManager(const GameConfig& config, ReplayReader& replay);
     ~NetworkManager();
 
     bool initialize();
     bool waitForClient();
-    void sendInitializationData();
     void sendSimulationData();
+    // Replay mode: waits for the first client, then streams the recording
+    // from fromTick at speed times the recorded tick rate (0 for as fast as
+    // the clients take it) and returns at its end
+    void playReplay(uint32_t fromTick, double speed);
     void sendGameOverMessage(const std::string& message);
     void closeConnection();
 
+    size_t getClientCount() const { return clients.size() + (udp ? udp->getClientCount() : 0); }
+
 private:
-    SimulationManager& simulationManager;
-    SOCKET serverSocket;
-    SOCKET clientSocket;
+    // An encoded frame, immutable once queued. Every client sent the same
+    // frame holds the same buffer, which is freed when the last one sent it.
+    using FrameBuffer = std::shared_ptr<const std::string>;
+
+    struct ClientConnection {
+        SocketPlatform::SocketHandle socket = SocketPlatform::InvalidSocket;
+        std::deque<FrameBuffer> outbound;  // Frames queued but not yet accepted by the kernel
+        size_t outboundOffset = 0;         // First unsent byte of the front frame
+        size_t pendingBytes = 0;           // Unsent bytes across all of outbound
+        bool wantsWrite = false;    // Registered for writability with the poller
+        bool needsKeyframe = false; // Skipped a frame, so deltas alone cannot resync it
+        SnapshotProtocol::StreamDecoder inbound{ 256 };  // Messages from the client
+
+        // Area of interest, set once the client sends a Viewport message.
+        // Inclusive cell bounds with the margin already added.
+        bool hasViewport = false;
+        bool needsViewKeyframe = false;  // Viewport just set; replace everything the client has
+        int viewMinX = 0;
+        int viewMinY = 0;
+        int viewMaxX = 0;
+        int viewMaxY = 0;
+        std::vector<SnapshotProtocol::UnitRecord> visible;  // Units the client has, as last sent, by ID
+        std::shared_ptr<std::string> viewFrame;             // Reused once the previous one is sent
+    };
+
+    // Upper bound on bytes buffered for a client before new frames are skipped for it
+    static const size_t MAX_PENDING_BYTES = 1 << 20;
+
+    void pollOnce(int timeoutMs);
+    void acceptClients();
+    void readFromClient(ClientConnection& client);
+    void handleClientMessage(ClientConnection& client, const SnapshotProtocol::FrameView& message);
+    bool flushClient(ClientConnection& client);
+    bool queueToClient(ClientConnection& client, const FrameBuffer& frame);
+    void broadcast(const FrameBuffer& message);
+    void broadcastFrame(const FrameBuffer& frame, bool isKeyframe);  // Clients without a viewport
+    // Per-client frames for clients with a viewport: their units only, with
+    // enter and leave events, as a keyframe when isKeyframe
+    void sendViewportFrames(const SnapshotProtocol::SimulationSnapshot& state, bool isKeyframe);
+    void disconnectClient(SocketPlatform::SocketHandle socket);
+    void drainPendingOutput(int timeoutMs);
+
+    // Keyframe of the published state (or replayTick in replay mode), encoded
+    // once and shared by joining clients, resyncs and the periodic keyframe
+    FrameBuffer latestKeyframe();
+    // Empty string to encode the next frame into: the one in frame if no
+    // client still has it queued, otherwise a new one
+    static std::string& reuseFrame(std::shared_ptr<std::string>& frame);
+    // Least wall time between live frames, from frame-interval-ms and time-scale
+    std::chrono::milliseconds frameBudget() const;
+
+    SimulationManager* simulationManager;  // Null in replay mode
+    ReplayReader* replay;                  // Null in live mode
+    uint32_t replayTick;                   // Last tick sent from the replay
+    GameConfig config;
+    SocketPlatform::SocketHandle serverSocket;
+    std::unique_ptr<UdpTransport> udp;  // Null unless udp-port is set in live mode
+    ConnectionPoller poller;
+    std::unordered_map<SocketPlatform::SocketHandle, ClientConnection> clients;
+    std::vector<ConnectionPoller::Event> readyEvents;
+    std::vector<SocketPlatform::SocketHandle> closedClients;
     std::atomic<bool> initialized;
-};
\ No newline at end of file
+    std::atomic<bool> closed;  // closeConnection has run; the destructor calls it again
+    // steady_clock time before which new ticks do not wake the network
+    // thread, because they would be folded into the next frame anyway
+    std::atomic<int64_t> nextFrameTime;
+    // Set once sendSimulationData owns the published state; joining clients
+    // then get the state the others were last sent instead of acquiring a newer one
+    bool streaming;
+
+    FrameBuffer cachedKeyframe;
+    uint64_t cachedKeyframeKey;  // Publication sequence, or replay tick, it was built from
+    std::shared_ptr<std::string> deltaFrame;
+
+    // Scratch for sendViewportFrames, reused across frames
+    ViewportIndex viewportIndex;
+    std::vector<SnapshotProtocol::UnitRecord> nowVisible;
+    SnapshotProtocol::SimulationSnapshot viewChanges;
+    std::vector<uint32_t> leftIds;
+};
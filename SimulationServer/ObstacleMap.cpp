@@ -0,0 +1,64 @@
+﻿#include "ObstacleMap.h"
+#include "Log.h"
+#include <fstream>
+
+ObstacleMap::ObstacleMap() : width(0), height(0), wordsPerRow(0), blockedCount(0) {}
+
+ObstacleMap::ObstacleMap(int mapWidth, int mapHeight)
+    : width(mapWidth), height(mapHeight), wordsPerRow((mapWidth + 63) / 64),
+      bits(static_cast<size_t>(wordsPerRow) * mapHeight, 0), blockedCount(0) {}
+
+void ObstacleMap::setBlocked(int x, int y, bool blocked) {
+    if (x < 0 || y < 0 || x >= width || y >= height) return;
+
+    uint64_t& word = bits[static_cast<size_t>(y) * wordsPerRow + (x >> 6)];
+    uint64_t mask = uint64_t(1) << (x & 63);
+    bool wasBlocked = (word & mask) != 0;
+    if (wasBlocked == blocked) return;
+
+    word ^= mask;
+    if (blocked) blockedCount++;
+    else blockedCount--;
+}
+
+bool ObstacleMap::loadFromFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        LOG_ERROR("[Server] Cannot open obstacle map: {}", path);
+        return false;
+    }
+
+    std::vector<std::string> rows;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+
+        if (!rows.empty() && line.size() != rows.front().size()) {
+            LOG_ERROR("[Server] Obstacle map row {} has {} cells, expected {}", rows.size(), line.size(),
+                rows.front().size());
+            return false;
+        }
+        for (char cell : line) {
+            if (cell != '#' && cell != '.') {
+                LOG_ERROR("[Server] Obstacle map row {} has invalid cell '{}'", rows.size(), cell);
+                return false;
+            }
+        }
+        rows.push_back(line);
+    }
+
+    if (rows.empty()) {
+        LOG_ERROR("[Server] Obstacle map is empty: {}", path);
+        return false;
+    }
+
+    ObstacleMap loaded(static_cast<int>(rows.front().size()), static_cast<int>(rows.size()));
+    for (int y = 0; y < loaded.height; ++y) {
+        for (int x = 0; x < loaded.width; ++x) {
+            if (rows[y][x] == '#') loaded.setBlocked(x, y, true);
+        }
+    }
+    *this = std::move(loaded);
+    return true;
+}
@@ -0,0 +1,42 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Static terrain for the simulation grid, one bit per cell (1 = blocked).
+// Each row starts on a 64-bit word boundary. Cells outside the map count as
+// blocked so callers never need a separate bounds check.
+class ObstacleMap {
+public:
+    ObstacleMap();
+    ObstacleMap(int width, int height);  // Fully open
+
+    // Loads a text map: one line per row starting at y = 0, '#' for a blocked
+    // cell and '.' for an open one. All rows must have the same length.
+    // Prints the reason and leaves the map unchanged on failure.
+    bool loadFromFile(const std::string& path);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    size_t getBlockedCount() const { return blockedCount; }
+    size_t getMemoryBytes() const { return bits.capacity() * sizeof(uint64_t); }
+
+    bool isBlocked(int x, int y) const {
+        if (x < 0 || y < 0 || x >= width || y >= height) return true;
+        return (bits[static_cast<size_t>(y) * wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+    }
+    bool isOpen(int x, int y) const { return !isBlocked(x, y); }
+
+    void setBlocked(int x, int y, bool blocked);
+
+private:
+    int width;
+    int height;
+    int wordsPerRow;
+    std::vector<uint64_t> bits;
+    size_t blockedCount;
+
+    friend class Checkpoint;
+};
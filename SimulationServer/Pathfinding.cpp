@@ -0,0 +1,246 @@
+﻿#include "Pathfinding.h"
+#include <algorithm>
+#include <cstdlib>
+
+PathWorkspace::PathWorkspace()
+    : originX(0), originY(0), width(0), height(0), targetX(0), targetY(0), generation(0), expandedNodes(0),
+      specializedKernels(true) {}
+
+PathWorkspace& PathWorkspace::forThisThread() {
+    thread_local PathWorkspace workspace;
+    return workspace;
+}
+
+void PathWorkspace::reset(int newWidth, int newHeight) {
+    // Arrays only grow, so alternating between window sizes never reallocates;
+    // the generation bump below invalidates whatever they held before
+    size_t cells = static_cast<size_t>(newWidth) * newHeight;
+    width = newWidth;
+    height = newHeight;
+    if (cells > seen.size()) {
+        seen.resize(cells, 0);
+        gScore.resize(cells);
+        parent.resize(cells);
+        heapIndex.resize(cells);
+    }
+
+    // Stamps from a previous wrap-around could collide with the new generation
+    if (++generation == 0) {
+        std::fill(seen.begin(), seen.end(), 0);
+        generation = 1;
+    }
+    heap.clear();
+}
+
+// Lower f first; among equal f prefer the deeper node, which heads straight
+// for the target on open ground; the cell index makes the order total
+template <typename Index>
+bool PathWorkspace::before(const Index& index, int a, int b) const {
+    int ha = std::abs(index.x(a) - targetX) + std::abs(index.y(a) - targetY);
+    int hb = std::abs(index.x(b) - targetX) + std::abs(index.y(b) - targetY);
+    int fa = gScore[a] + ha;
+    int fb = gScore[b] + hb;
+    if (fa != fb) return fa < fb;
+    if (gScore[a] != gScore[b]) return gScore[a] > gScore[b];
+    return a < b;
+}
+
+template <typename Index>
+void PathWorkspace::siftUp(const Index& index, int32_t position) {
+    int cell = heap[position];
+    while (position > 0) {
+        int32_t parentPosition = (position - 1) / 2;
+        if (!before(index, cell, heap[parentPosition])) break;
+        heap[position] = heap[parentPosition];
+        heapIndex[heap[position]] = position;
+        position = parentPosition;
+    }
+    heap[position] = cell;
+    heapIndex[cell] = position;
+}
+
+template <typename Index>
+void PathWorkspace::siftDown(const Index& index, int32_t position) {
+    int cell = heap[position];
+    int32_t count = static_cast<int32_t>(heap.size());
+    while (true) {
+        int32_t child = 2 * position + 1;
+        if (child >= count) break;
+        if (child + 1 < count && before(index, heap[child + 1], heap[child])) ++child;
+        if (!before(index, heap[child], cell)) break;
+        heap[position] = heap[child];
+        heapIndex[heap[position]] = position;
+        position = child;
+    }
+    heap[position] = cell;
+    heapIndex[cell] = position;
+}
+
+template <typename Index>
+void PathWorkspace::push(const Index& index, int cell) {
+    heap.push_back(cell);
+    siftUp(index, static_cast<int32_t>(heap.size()) - 1);
+}
+
+template <typename Index>
+int PathWorkspace::pop(const Index& index) {
+    int top = heap.front();
+    heapIndex[top] = NOT_IN_HEAP;
+    int last = heap.back();
+    heap.pop_back();
+    if (!heap.empty()) {
+        heap[0] = last;
+        siftDown(index, 0);
+    }
+    return top;
+}
+
+template <typename Index>
+void PathWorkspace::relax(const Index& index, int cell, int parentCell, int32_t g) {
+    if (!isSeen(cell)) {
+        seen[cell] = generation;
+        gScore[cell] = g;
+        parent[cell] = parentCell;
+        push(index, cell);
+    }
+    else if (heapIndex[cell] != NOT_IN_HEAP && g < gScore[cell]) {
+        // Still open and reached more cheaply: decrease its key in place
+        gScore[cell] = g;
+        parent[cell] = parentCell;
+        siftUp(index, heapIndex[cell]);
+    }
+}
+
+template <typename Index>
+void PathWorkspace::reconstruct(const Index& index, int goal) {
+    int cell = goal;
+    for (; parent[cell] != -1; cell = parent[cell]) {
+        // Parents of jump points may be several cells away along a straight line
+        int x = index.x(cell);
+        int y = index.y(cell);
+        int px = index.x(parent[cell]);
+        int py = index.y(parent[cell]);
+        int dx = (px > x) - (px < x);
+        int dy = (py > y) - (py < y);
+        for (; x != px || y != py; x += dx, y += dy) {
+            path.emplace_back(x + originX, y + originY);
+        }
+    }
+    path.emplace_back(index.x(cell) + originX, index.y(cell) + originY);
+    std::reverse(path.begin(), path.end());
+}
+
+template <typename Index>
+bool PathWorkspace::begin(const Index& index, const ObstacleMap& map, int windowX, int windowY,
+    int windowWidth, int windowHeight, int startX, int startY, int goalX, int goalY) {
+    reset(windowWidth, windowHeight);
+    originX = windowX;
+    originY = windowY;
+    path.clear();
+    expandedNodes = 0;
+
+    // Everything below works in window-local coordinates
+    startX -= originX;
+    startY -= originY;
+    targetX = goalX - originX;
+    targetY = goalY - originY;
+
+    if (!isInsideOpen(index, map, startX, startY) || !isInsideOpen(index, map, targetX, targetY)) return false;
+
+    int start = index.cell(startX, startY);
+    seen[start] = generation;
+    gScore[start] = 0;
+    parent[start] = -1;
+    push(index, start);
+    return true;
+}
+
+const std::vector<std::pair<int, int>>& PathWorkspace::findPath(const ObstacleMap& map,
+    int startX, int startY, int goalX, int goalY) {
+    return findPathInWindow(map, 0, 0, map.getWidth(), map.getHeight(), startX, startY, goalX, goalY);
+}
+
+const std::vector<std::pair<int, int>>& PathWorkspace::findPathInWindow(const ObstacleMap& map,
+    int windowX, int windowY, int windowWidth, int windowHeight, int startX, int startY, int goalX, int goalY) {
+    dispatchGridWidth(windowWidth, specializedKernels, [&](auto index) {
+        searchWindow(index, map, windowX, windowY, windowWidth, windowHeight, startX, startY, goalX, goalY);
+    });
+    return path;  // Empty if no path found
+}
+
+template <typename Index>
+void PathWorkspace::searchWindow(const Index& index, const ObstacleMap& map,
+    int windowX, int windowY, int windowWidth, int windowHeight, int startX, int startY, int goalX, int goalY) {
+    if (!begin(index, map, windowX, windowY, windowWidth, windowHeight, startX, startY, goalX, goalY)) return;
+
+    int goal = index.cell(targetX, targetY);
+    while (!heap.empty()) {
+        int current = pop(index);
+        ++expandedNodes;
+        if (current == goal) {
+            reconstruct(index, goal);
+            return;
+        }
+
+        int cx = index.x(current);
+        int cy = index.y(current);
+        int nextG = gScore[current] + 1;
+
+        for (int dir = 0; dir < 4; ++dir) {
+            int nx = cx + JumpTable::DX[dir];
+            int ny = cy + JumpTable::DY[dir];
+            if (!isInsideOpen(index, map, nx, ny)) continue;
+            relax(index, index.cell(nx, ny), current, nextG);
+        }
+    }
+}
+
+const std::vector<std::pair<int, int>>& PathWorkspace::findJumpPointPath(const JumpTable& jumps,
+    int startX, int startY, int goalX, int goalY) {
+    dispatchGridWidth(jumps.getWidth(), specializedKernels, [&](auto index) {
+        searchJumpPoints(index, jumps, startX, startY, goalX, goalY);
+    });
+    return path;  // Empty if no path found
+}
+
+template <typename Index>
+void PathWorkspace::searchJumpPoints(const Index& index, const JumpTable& jumps,
+    int startX, int startY, int goalX, int goalY) {
+    const ObstacleMap& map = jumps.getMap();
+    if (!begin(index, map, 0, 0, map.getWidth(), map.getHeight(), startX, startY, goalX, goalY)) return;
+
+    int goal = index.cell(goalX, goalY);
+    while (!heap.empty()) {
+        int current = pop(index);
+        ++expandedNodes;
+        if (current == goal) {
+            reconstruct(index, goal);
+            return;
+        }
+
+        int cx = index.x(current);
+        int cy = index.y(current);
+
+        // Prune the direction we came from; a straight arrival keeps going
+        // straight and may also turn to either side
+        int from = parent[current];
+        bool skip[4] = { false, false, false, false };
+        if (from != -1) {
+            int px = index.x(from);
+            int py = index.y(from);
+            if (py < cy) skip[JumpTable::South] = true;
+            else if (py > cy) skip[JumpTable::North] = true;
+            else if (px < cx) skip[JumpTable::West] = true;
+            else skip[JumpTable::East] = true;
+        }
+
+        for (int dir = 0; dir < 4; ++dir) {
+            if (skip[dir]) continue;
+            int next = jumps.jump(index, current, cx, cy, static_cast<JumpTable::Direction>(dir), goalX, goalY);
+            if (next == -1) continue;
+
+            int distance = std::abs(index.x(next) - cx) + std::abs(index.y(next) - cy);
+            relax(index, next, current, gScore[current] + distance);
+        }
+    }
+}
@@ -0,0 +1,103 @@
+﻿#pragma once
+#include "GridIndex.h"
+#include "JumpTable.h"
+#include "ObstacleMap.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Reusable search state for one thread. Per-cell scores live in flat arrays
+// indexed by y * width + x and are invalidated by bumping a generation counter
+// instead of clearing them, and the open set is a binary heap that tracks each
+// cell's position so improved cells are updated in place rather than pushed
+// twice. Once the arrays have grown to the map size a query allocates nothing.
+// The search loops are instantiated per grid width (see GridIndex.h), so on
+// power-of-two windows cell <-> coordinate conversions are a mask and a shift.
+//
+// Both searches move 4-way and return the cells from start to target
+// inclusive, or an empty path if either end is blocked or the target is
+// unreachable. The result is owned by the workspace and valid until its next
+// query.
+class PathWorkspace {
+public:
+    PathWorkspace();
+
+    // Plain A* expanding one cell at a time
+    const std::vector<std::pair<int, int>>& findPath(const ObstacleMap& map,
+        int startX, int startY, int targetX, int targetY);
+
+    // Plain A* that never leaves the given rectangle of the map. The arrays
+    // only need to cover the window, so this stays cheap on huge maps.
+    const std::vector<std::pair<int, int>>& findPathInWindow(const ObstacleMap& map,
+        int windowX, int windowY, int windowWidth, int windowHeight,
+        int startX, int startY, int targetX, int targetY);
+
+    // Jump Point Search: A* over jump points only, using precomputed jumps.
+    // Returns a shortest path like findPath, but may pick a different one of
+    // equal length.
+    const std::vector<std::pair<int, int>>& findJumpPointPath(const JumpTable& jumps,
+        int startX, int startY, int targetX, int targetY);
+
+    // Nodes taken off the open set by the last query
+    size_t getExpandedNodes() const { return expandedNodes; }
+
+    // Off forces the runtime-width kernels on every grid; for benchmarks
+    void setSpecializedKernels(bool enabled) { specializedKernels = enabled; }
+
+    // Workspace owned by the calling thread
+    static PathWorkspace& forThisThread();
+
+private:
+    static const int32_t NOT_IN_HEAP = -1;
+
+    template <typename Index>
+    bool begin(const Index& index, const ObstacleMap& map, int windowX, int windowY, int windowWidth, int windowHeight,
+        int startX, int startY, int goalX, int goalY);
+    template <typename Index>
+    bool isInsideOpen(const Index& index, const ObstacleMap& map, int localX, int localY) const {
+        return index.containsX(localX) && static_cast<unsigned>(localY) < static_cast<unsigned>(height) &&
+            map.isOpen(localX + originX, localY + originY);
+    }
+    void reset(int width, int height);
+    bool isSeen(int cell) const { return seen[cell] == generation; }
+    template <typename Index>
+    bool before(const Index& index, int a, int b) const;
+    template <typename Index>
+    void siftUp(const Index& index, int32_t position);
+    template <typename Index>
+    void siftDown(const Index& index, int32_t position);
+    template <typename Index>
+    void push(const Index& index, int cell);
+    template <typename Index>
+    int pop(const Index& index);
+    // Opens or improves a cell reached from parentCell at cost g
+    template <typename Index>
+    void relax(const Index& index, int cell, int parentCell, int32_t g);
+    // Writes the path ending at goal, filling in the straight runs between parents
+    template <typename Index>
+    void reconstruct(const Index& index, int goal);
+
+    template <typename Index>
+    void searchWindow(const Index& index, const ObstacleMap& map,
+        int windowX, int windowY, int windowWidth, int windowHeight, int startX, int startY, int goalX, int goalY);
+    template <typename Index>
+    void searchJumpPoints(const Index& index, const JumpTable& jumps, int startX, int startY, int goalX, int goalY);
+
+    int originX;    // Map position of the search window's first cell
+    int originY;
+    int width;      // Window size; cells are indexed by localY * width + localX
+    int height;
+    int targetX;    // Window-local goal
+    int targetY;
+    uint32_t generation;
+    size_t expandedNodes;
+    bool specializedKernels;
+
+    std::vector<uint32_t> seen;       // Generation that last touched the cell
+    std::vector<int32_t> gScore;      // Cost from start, valid when seen
+    std::vector<int32_t> parent;      // Previous node on the best path, -1 at start
+    std::vector<int32_t> heapIndex;   // Position in heap, or NOT_IN_HEAP once closed
+    std::vector<int32_t> heap;        // Open cells ordered by f, then by larger g
+    std::vector<std::pair<int, int>> path;
+};
@@ -0,0 +1,52 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Replay file layout, all integers little-endian:
+//   header: char[4] "BSRP" | u32 version | u32 gridSize | u32 keyframeInterval
+//           | u64 indexOffset | u32 keyframeCount | u32 lastTick
+//   frames: one wire frame per published tick, byte for byte what clients
+//           receive (see SnapshotProtocol/WireFormat.h): a keyframe every
+//           keyframeInterval ticks and deltas in between, then a GameOver
+//           frame if the battle was decided
+//   index:  keyframeCount entries of u32 tick | u32 reserved | u64 frame offset
+//
+// The last three fields stay 0 until the recording is closed; a reader then
+// rebuilds the index by walking the frames, which also recovers a recording
+// cut short.
+namespace ReplayFile {
+
+const char MAGIC[4] = { 'B', 'S', 'R', 'P' };
+const uint32_t VERSION = 1;
+const size_t HEADER_SIZE = 32;
+const size_t INDEX_ENTRY_SIZE = 16;
+
+// Byte offsets of the header fields
+const size_t GRID_SIZE_OFFSET = 8;
+const size_t KEYFRAME_INTERVAL_OFFSET = 12;
+const size_t INDEX_OFFSET_OFFSET = 16;
+const size_t KEYFRAME_COUNT_OFFSET = 24;
+const size_t LAST_TICK_OFFSET = 28;
+
+inline void storeU32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+inline void storeU64(uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+inline uint32_t loadU32(const uint8_t* in) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) value = (value << 8) | in[i];
+    return value;
+}
+
+inline uint64_t loadU64(const uint8_t* in) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) value = (value << 8) | in[i];
+    return value;
+}
+
+}  // namespace ReplayFile
@@ -0,0 +1,189 @@
+﻿#include "ReplayReader.h"
+#include "Log.h"
+#include "ReplayFile.h"
+#include "SnapshotProtocol.h"
+#include <SnapshotProtocol/StreamDecoder.h>
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+using SnapshotProtocol::MessageType;
+
+ReplayReader::ReplayReader()
+    : gridSize(0), keyframeInterval(0), framesEnd(0), lastTick(0), cursor(ReplayFile::HEADER_SIZE) {}
+
+bool ReplayReader::open(const std::string& filePath) {
+    keyframes.clear();
+    if (!file.open(filePath)) return false;
+    path = filePath;
+
+    const uint8_t* header = file.data();
+    if (file.size() < ReplayFile::HEADER_SIZE || std::memcmp(header, ReplayFile::MAGIC, sizeof(ReplayFile::MAGIC)) != 0) {
+        LOG_ERROR("[Server] {} is not a replay file", path);
+        return false;
+    }
+    if (ReplayFile::loadU32(header + 4) != ReplayFile::VERSION) {
+        LOG_ERROR("[Server] {} is replay version {}, expected {}", path, ReplayFile::loadU32(header + 4),
+            ReplayFile::VERSION);
+        return false;
+    }
+
+    gridSize = static_cast<int>(ReplayFile::loadU32(header + ReplayFile::GRID_SIZE_OFFSET));
+    keyframeInterval = static_cast<int>(ReplayFile::loadU32(header + ReplayFile::KEYFRAME_INTERVAL_OFFSET));
+    uint64_t indexOffset = ReplayFile::loadU64(header + ReplayFile::INDEX_OFFSET_OFFSET);
+    uint32_t keyframeCount = ReplayFile::loadU32(header + ReplayFile::KEYFRAME_COUNT_OFFSET);
+
+    if (indexOffset == 0 || !loadIndex(indexOffset, keyframeCount)) {
+        LOG_WARNING("[Server] {} has no usable index; scanning its frames", path);
+        rebuildIndex();
+    }
+    else {
+        lastTick = ReplayFile::loadU32(header + ReplayFile::LAST_TICK_OFFSET);
+    }
+
+    if (keyframes.empty()) {
+        LOG_ERROR("[Server] {} holds no complete keyframe", path);
+        return false;
+    }
+    cursor = keyframes.front().offset;
+    return true;
+}
+
+bool ReplayReader::loadIndex(uint64_t indexOffset, uint32_t count) {
+    if (indexOffset < ReplayFile::HEADER_SIZE || indexOffset > file.size() ||
+        (file.size() - indexOffset) / ReplayFile::INDEX_ENTRY_SIZE < count) {
+        return false;
+    }
+
+    framesEnd = static_cast<size_t>(indexOffset);
+    keyframes.resize(count);
+    const uint8_t* entry = file.data() + indexOffset;
+    for (uint32_t i = 0; i < count; ++i, entry += ReplayFile::INDEX_ENTRY_SIZE) {
+        keyframes[i].tick = ReplayFile::loadU32(entry);
+        keyframes[i].offset = static_cast<size_t>(ReplayFile::loadU64(entry + 8));
+
+        // Entries must point at keyframes, in tick order
+        Frame frame;
+        if (!readFrame(keyframes[i].offset, frame) || frame.type != MessageType::Keyframe ||
+            frame.tick != keyframes[i].tick || (i > 0 && keyframes[i].tick < keyframes[i - 1].tick)) {
+            keyframes.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ReplayReader::rebuildIndex() {
+    // Stop at the first frame that is cut off or damaged; everything before it plays
+    framesEnd = file.size();
+    size_t offset = ReplayFile::HEADER_SIZE;
+    Frame frame;
+    while (readFrame(offset, frame)) {
+        if (frame.type == MessageType::Keyframe) keyframes.push_back({ frame.tick, offset });
+        lastTick = frame.tick;
+        offset += frame.size;
+    }
+    framesEnd = offset;
+}
+
+bool ReplayReader::readFrame(size_t offset, Frame& frame) const {
+    using namespace SnapshotProtocol;
+    if (offset < ReplayFile::HEADER_SIZE || offset > framesEnd || framesEnd - offset < FRAME_PREFIX_SIZE + HEADER_SIZE) {
+        return false;
+    }
+
+    const uint8_t* bytes = file.data() + offset;
+    uint32_t length = ReplayFile::loadU32(bytes);
+    if (length < HEADER_SIZE || length > MAX_FRAME_SIZE || framesEnd - offset - FRAME_PREFIX_SIZE < length) return false;
+
+    const uint8_t* payload = bytes + FRAME_PREFIX_SIZE;
+    uint16_t magic = static_cast<uint16_t>(payload[0] | (payload[1] << 8));
+    uint8_t type = payload[3];
+    if (magic != MAGIC || payload[2] != VERSION || type < static_cast<uint8_t>(MessageType::Keyframe) ||
+        type > static_cast<uint8_t>(MessageType::GameOver)) {
+        return false;
+    }
+
+    frame.data = reinterpret_cast<const char*>(bytes);
+    frame.size = FRAME_PREFIX_SIZE + length;
+    frame.type = static_cast<MessageType>(type);
+    frame.tick = ReplayFile::loadU32(payload + 4);
+    return true;
+}
+
+uint32_t ReplayReader::seek(uint32_t tick) {
+    auto after = std::upper_bound(keyframes.begin(), keyframes.end(), tick,
+        [](uint32_t value, const KeyframeEntry& entry) { return value < entry.tick; });
+    const KeyframeEntry& keyframe = after == keyframes.begin() ? keyframes.front() : *(after - 1);
+    cursor = keyframe.offset;
+    return keyframe.tick;
+}
+
+bool ReplayReader::next(Frame& frame) {
+    if (!readFrame(cursor, frame)) return false;
+    cursor += frame.size;
+    return true;
+}
+
+bool ReplayReader::buildKeyframe(uint32_t tick, std::string& out) const {
+    tick = std::min(std::max(tick, getFirstTick()), lastTick);
+    auto after = std::upper_bound(keyframes.begin(), keyframes.end(), tick,
+        [](uint32_t value, const KeyframeEntry& entry) { return value < entry.tick; });
+    const KeyframeEntry& keyframe = after == keyframes.begin() ? keyframes.front() : *(after - 1);
+
+    std::vector<SnapshotProtocol::UnitRecord> units;
+    std::vector<bool> removed;
+    std::unordered_map<uint32_t, size_t> slotOf;
+
+    size_t offset = keyframe.offset;
+    Frame frame;
+    while (readFrame(offset, frame) && frame.tick <= tick) {
+        // Deltas follow the keyframe up to the next keyframe or the GameOver frame
+        if (offset != keyframe.offset && frame.type != MessageType::Delta) break;
+
+        SnapshotProtocol::FrameView view;
+        const uint8_t* payload = reinterpret_cast<const uint8_t*>(frame.data) + SnapshotProtocol::FRAME_PREFIX_SIZE;
+        if (SnapshotProtocol::decodePayload(payload, frame.size - SnapshotProtocol::FRAME_PREFIX_SIZE, view) !=
+            SnapshotProtocol::DecodeStatus::Frame) {
+            LOG_ERROR("[Server] Damaged frame at offset {} of {}", offset, path);
+            return false;
+        }
+
+        SnapshotProtocol::UnitCursor entries = view.units();
+        SnapshotProtocol::UnitView unit;
+        while (entries.next(unit)) {
+            auto found = slotOf.find(unit.id);
+            if (found == slotOf.end()) {
+                found = slotOf.emplace(unit.id, units.size()).first;
+                units.push_back({ unit.id, SnapshotProtocol::FIELD_ALL, 0, 0, 0, false });
+                removed.push_back(false);
+            }
+            SnapshotProtocol::UnitRecord& record = units[found->second];
+            if (unit.fieldMask & SnapshotProtocol::FIELD_POSITION) {
+                record.x = unit.x;
+                record.y = unit.y;
+            }
+            if (unit.fieldMask & SnapshotProtocol::FIELD_HP) record.hp = static_cast<int32_t>(unit.hp);
+            if (unit.fieldMask & SnapshotProtocol::FIELD_TEAM) record.isRed = unit.isRed;
+        }
+
+        SnapshotProtocol::IdCursor removedIds = view.removedIds();
+        uint32_t id = 0;
+        while (removedIds.next(id)) {
+            auto found = slotOf.find(id);
+            if (found == slotOf.end()) continue;
+            removed[found->second] = true;
+            slotOf.erase(found);
+        }
+        offset += frame.size;
+    }
+
+    // Keep the recorded order, which is the server's slot order
+    size_t kept = 0;
+    for (size_t i = 0; i < units.size(); ++i) {
+        if (!removed[i]) units[kept++] = units[i];
+    }
+    units.resize(kept);
+    SnapshotProtocol::encodeKeyframe(out, tick, gridSize, units);
+    return true;
+}
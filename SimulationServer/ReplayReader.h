@@ -0,0 +1,66 @@
+﻿#pragma once
+
+#include "MappedFile.h"
+#include <SnapshotProtocol/WireFormat.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Plays back a file written by ReplayRecorder straight from a memory mapping.
+// Frames are handed out as views into the mapping, ready to send as they are,
+// so streaming a replay copies nothing and decodes nothing.
+class ReplayReader {
+public:
+    struct Frame {
+        const char* data = nullptr;  // Whole wire frame, length prefix included
+        size_t size = 0;
+        SnapshotProtocol::MessageType type = SnapshotProtocol::MessageType::Keyframe;
+        uint32_t tick = 0;
+    };
+
+    ReplayReader();
+
+    // Maps the file and loads its keyframe index, rebuilding it from the
+    // frames if the recording was never closed. Prints the reason and returns
+    // false if the file is not a replay.
+    bool open(const std::string& path);
+
+    int getGridSize() const { return gridSize; }
+    int getKeyframeInterval() const { return keyframeInterval; }
+    uint32_t getFirstTick() const { return keyframes.empty() ? 0 : keyframes.front().tick; }
+    uint32_t getLastTick() const { return lastTick; }
+    size_t getKeyframeCount() const { return keyframes.size(); }
+
+    // Moves the cursor to the last keyframe at or before tick, or the first
+    // keyframe for earlier ticks. Returns that keyframe's tick.
+    uint32_t seek(uint32_t tick);
+
+    // Frame at the cursor, then advances; false at the end of the recording or
+    // at a damaged frame
+    bool next(Frame& frame);
+
+    // Full state at tick (clamped to the recording) as one keyframe frame
+    // appended to out: the keyframe before it with the deltas up to tick
+    // applied, so the cost is bounded by the keyframe interval
+    bool buildKeyframe(uint32_t tick, std::string& out) const;
+
+private:
+    struct KeyframeEntry {
+        uint32_t tick;
+        size_t offset;
+    };
+
+    bool readFrame(size_t offset, Frame& frame) const;  // Validates the prefix and header only
+    bool loadIndex(uint64_t indexOffset, uint32_t count);
+    void rebuildIndex();
+
+    MappedFile file;
+    std::string path;
+    int gridSize;
+    int keyframeInterval;
+    size_t framesEnd;  // One past the last complete frame
+    uint32_t lastTick;
+    std::vector<KeyframeEntry> keyframes;
+    size_t cursor;
+};
@@ -0,0 +1,109 @@
+﻿#include "ReplayRecorder.h"
+#include "Log.h"
+#include "ReplayFile.h"
+#include <cstring>
+
+ReplayRecorder::ReplayRecorder()
+    : gridSize(0), keyframeInterval(1), ticksSinceKeyframe(0), ticksRecorded(0), lastTick(0), offset(0), finished(false), failed(false) {}
+
+ReplayRecorder::~ReplayRecorder() {
+    close();
+}
+
+bool ReplayRecorder::open(const std::string& filePath, int grid, int interval) {
+    close();
+    file.open(filePath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        LOG_ERROR("[Server] Cannot create replay file: {}", filePath);
+        return false;
+    }
+
+    path = filePath;
+    gridSize = grid;
+    keyframeInterval = interval;
+    ticksSinceKeyframe = 0;
+    ticksRecorded = 0;
+    lastTick = 0;
+    finished = false;
+    failed = false;
+    keyframes.clear();
+
+    // The index fields stay zero until close
+    uint8_t header[ReplayFile::HEADER_SIZE] = {};
+    std::memcpy(header, ReplayFile::MAGIC, sizeof(ReplayFile::MAGIC));
+    ReplayFile::storeU32(header + 4, ReplayFile::VERSION);
+    ReplayFile::storeU32(header + ReplayFile::GRID_SIZE_OFFSET, static_cast<uint32_t>(gridSize));
+    ReplayFile::storeU32(header + ReplayFile::KEYFRAME_INTERVAL_OFFSET, static_cast<uint32_t>(keyframeInterval));
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    offset = sizeof(header);
+    return true;
+}
+
+void ReplayRecorder::record(const SnapshotProtocol::SimulationSnapshot& state,
+    const SnapshotProtocol::SimulationSnapshot& changes, const std::string& winningTeam) {
+    if (!file.is_open() || finished || failed) return;
+
+    // The first tick is always a keyframe, so playback can start anywhere
+    frame.clear();
+    if (keyframes.empty() || ++ticksSinceKeyframe >= keyframeInterval) {
+        keyframes.emplace_back(state.tick, offset);
+        SnapshotProtocol::encodeKeyframe(frame, state.tick, gridSize, state.units);
+        ticksSinceKeyframe = 0;
+    }
+    else {
+        // Empty deltas are kept so every tick has a frame to pace playback by
+        SnapshotProtocol::encodeDelta(frame, changes);
+    }
+
+    if (!winningTeam.empty()) {
+        SnapshotProtocol::encodeGameOver(frame, state.tick, winningTeam);
+        finished = true;
+    }
+    write(frame);
+    ++ticksRecorded;
+    lastTick = state.tick;
+}
+
+void ReplayRecorder::write(const std::string& bytes) {
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!file) {
+        LOG_ERROR("[Server] Failed writing replay file: {}; recording stopped", path);
+        failed = true;
+        return;
+    }
+    offset += bytes.size();
+}
+
+bool ReplayRecorder::close() {
+    if (!file.is_open()) return true;
+
+    std::string index;
+    for (const auto& keyframe : keyframes) {
+        uint8_t entry[ReplayFile::INDEX_ENTRY_SIZE] = {};
+        ReplayFile::storeU32(entry, keyframe.first);
+        ReplayFile::storeU64(entry + 8, keyframe.second);
+        index.append(reinterpret_cast<const char*>(entry), sizeof(entry));
+    }
+
+    // A failed recording keeps a zero index offset; readers then recover
+    // whatever complete frames made it to disk
+    bool ok = !failed;
+    if (ok) {
+        uint64_t indexOffset = offset;
+        write(index);
+
+        uint8_t fields[16];
+        ReplayFile::storeU64(fields, indexOffset);
+        ReplayFile::storeU32(fields + 8, static_cast<uint32_t>(keyframes.size()));
+        ReplayFile::storeU32(fields + 12, lastTick);
+        file.seekp(ReplayFile::INDEX_OFFSET_OFFSET);
+        file.write(reinterpret_cast<const char*>(fields), sizeof(fields));
+        file.flush();
+        ok = !failed && static_cast<bool>(file);
+    }
+    file.close();
+
+    if (ok) LOG_INFO("[Server] Recorded {} ticks ({} keyframes) to {}", ticksRecorded, keyframes.size(), path);
+    else LOG_ERROR("[Server] Replay file {} is incomplete", path);
+    return ok;
+}
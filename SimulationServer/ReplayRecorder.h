@@ -0,0 +1,52 @@
+﻿#pragma once
+
+#include "SnapshotProtocol.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Appends every published tick to a replay file (layout in ReplayFile.h).
+// The simulation calls record from its own thread after filling each
+// publication, so the file holds every tick even when the network thread
+// skips some. Writes go through the stream's buffer; a keyframe costs one
+// full encode every keyframeInterval ticks and a delta is what the tick
+// changed.
+class ReplayRecorder {
+public:
+    ReplayRecorder();
+    ~ReplayRecorder();
+
+    ReplayRecorder(const ReplayRecorder&) = delete;
+    ReplayRecorder& operator=(const ReplayRecorder&) = delete;
+
+    // Prints the reason and returns false if the file cannot be created
+    bool open(const std::string& path, int gridSize, int keyframeInterval);
+
+    // state holds every unit, changes what changed since the previous call;
+    // a non-empty winningTeam ends the recording with a GameOver frame
+    void record(const SnapshotProtocol::SimulationSnapshot& state,
+        const SnapshotProtocol::SimulationSnapshot& changes, const std::string& winningTeam);
+
+    // Writes the keyframe index and finalizes the header. Safe to call twice.
+    bool close();
+
+    bool isOpen() const { return file.is_open(); }
+
+private:
+    void write(const std::string& bytes);
+
+    std::ofstream file;
+    std::string path;
+    std::string frame;  // Reused encode buffer
+    int gridSize;
+    int keyframeInterval;
+    int ticksSinceKeyframe;
+    uint64_t ticksRecorded;
+    uint32_t lastTick;
+    uint64_t offset;    // Where the next frame starts
+    bool finished;      // GameOver written; later ticks are ignored
+    bool failed;        // A write failed; stop writing and keep the error quiet
+    std::vector<std::pair<uint32_t, uint64_t>> keyframes;  // Tick and offset
+};
@@ -2,24 +2,226 @@
 #include "GameConfig.h"
 #include "SimulationManager.h"
 #include "NetworkManager.h"
+#include "DistanceKernels.h"
+#include "BatchRunner.h"
+#include "Checkpoint.h"
+#include "Log.h"
+#include "ReplayReader.h"
+#include "ReplayRecorder.h"
+#include "Tracing.h"
+#include <csignal>
+#include <cstdlib>
+#include <string>
 #include <iostream>
 #include <thread>
-#include <random>
 
-int main() {
-    // Initialize random number generator with seed
-    std::mt19937 rng(42);
+namespace {
+
+void printUsage() {
+    std::cerr << "Usage: SimulationServer [--config <file>] [--<setting> <value>...] [map file]\n"
+        << "       SimulationServer --batch <battles> [--threads <n>] [--seed <n>] [--max-ticks <n>] [settings...] [map file]\n"
+        << "       SimulationServer --replay <file> [--replay-speed <x>] [--replay-from <tick>] [settings...]\n"
+        << "       SimulationServer --restore <checkpoint> [settings...]\n"
+        << "Settings: --grid-size, --max-units, --update-interval-ms, --server-port, --keyframe-interval,\n"
+        << "          --time-scale <x> (0 = uncapped), --frame-interval-ms, --start-delay-ms,\n"
+        << "          --worker-threads, --movement-mode path-per-unit|flow-field,\n"
+        << "          --hierarchical-min-grid-size, --hierarchical-cluster-size, --trace-file <file.json>,\n"
+        << "          --trace-detail 0|1, --record-file <file>, --checkpoint-file <file>,\n"
+        << "          --checkpoint-tick <n>, --viewport-margin, --udp-port, --udp-loss-percent,\n"
+        << "          --udp-latency-ms\n";
+}
+
+// Only flags the request; the network thread writes the file
+void onTraceDumpSignal(int) {
+    Tracing::requestDump();
+}
+
+// Only flags the request; the simulation thread saves after its current tick
+void onCheckpointSignal(int) {
+    Checkpoint::requestSave();
+}
+
+bool parseNumber(const char* text, unsigned long& value) {
+    char* end = nullptr;
+    value = std::strtoul(text, &end, 10);
+    return end != text && *end == '\0';
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const char* mapPath = nullptr;
+    const char* replayPath = nullptr;
+    const char* restorePath = nullptr;
+    double replaySpeed = 1.0;
+    uint32_t replayFrom = 0;
+    bool batchMode = false;
+    BatchRunner::Options batch;
+    GameConfig config;
+
+    // The config file comes first so flags override it wherever they appear
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--config" && !config.loadFromFile(argv[i + 1])) return -1;
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            mapPath = argv[i];
+            continue;
+        }
+        if (i + 1 >= argc) {
+            printUsage();
+            return -1;
+        }
+        ++i;
+
+        if (arg == "--config") continue;
+        if (arg == "--replay") {
+            replayPath = argv[i];
+            continue;
+        }
+        if (arg == "--restore") {
+            restorePath = argv[i];
+            continue;
+        }
+        if (arg == "--replay-speed") {
+            char* end = nullptr;
+            replaySpeed = std::strtod(argv[i], &end);
+            if (end == argv[i] || *end != '\0' || replaySpeed < 0) {
+                printUsage();
+                return -1;
+            }
+            continue;
+        }
+        if (GameConfig::isKey(arg.substr(2))) {
+            if (!config.set(arg.substr(2), argv[i])) return -1;
+            continue;
+        }
+
+        unsigned long value = 0;
+        if (!parseNumber(argv[i], value)) {
+            printUsage();
+            return -1;
+        }
+
+        if (arg == "--batch") {
+            batchMode = true;
+            batch.battles = value;
+        }
+        else if (arg == "--threads") batch.threads = value;
+        else if (arg == "--seed") batch.seed = static_cast<uint32_t>(value);
+        else if (arg == "--max-ticks") batch.maxTicks = static_cast<uint32_t>(value);
+        else if (arg == "--replay-from") replayFrom = static_cast<uint32_t>(value);
+        else {
+            printUsage();
+            return -1;
+        }
+    }
+
+    // Phase tracing, written on exit and whenever SIGUSR1 arrives
+    if (!config.traceFile.empty()) {
+#if !SIMULATION_TRACING
+        LOG_WARNING("[Server] Tracing is compiled out (SIMULATION_ENABLE_TRACING=OFF); the trace will be empty.");
+#endif
+        Tracing::setThreadName("main");
+        Tracing::setDumpPath(config.traceFile);
+        Tracing::setEnabled(true);
+        Tracing::setDetailed(config.traceDetail != 0);
+#ifdef SIGUSR1
+        std::signal(SIGUSR1, onTraceDumpSignal);
+#endif
+    }
+
+    // Playback only serves the recorded frames; nothing is simulated
+    if (replayPath) {
+        ReplayReader replay;
+        if (!replay.open(replayPath)) return -1;
+        LOG_INFO("[Server] Replay {}: {}x{} grid, ticks {} to {}, {} keyframes", replayPath, replay.getGridSize(),
+            replay.getGridSize(), replay.getFirstTick(), replay.getLastTick(), replay.getKeyframeCount());
+
+        NetworkManager networkManager(config, replay);
+        if (!networkManager.initialize()) {
+            LOG_ERROR("[Server] Failed to initialize network.");
+            return -1;
+        }
+        networkManager.playReplay(replayFrom, replaySpeed);
+        networkManager.closeConnection();
+
+        if (!config.traceFile.empty()) Tracing::writeChromeTrace(config.traceFile);
+        LOG_INFO("[Server] Shutdown complete.");
+        return 0;
+    }
+
+    LOG_INFO("[Server] {}x{} grid, {} units, {} ms ticks", config.gridSize, config.gridSize, config.maxUnits,
+        config.updateIntervalMs);
+    LOG_INFO("[Server] Distance kernels: {}", DistanceKernels::isaName(DistanceKernels::detectIsa()));
+    if (!batchMode && config.timeScale == 0) LOG_INFO("[Server] Time scale: uncapped, ticks run back to back");
+    else if (!batchMode && config.timeScale != 1) LOG_INFO("[Server] Time scale: {}x real time", config.timeScale);
+
+    // Optional obstacle map file; the grid is open otherwise
+    ObstacleMap obstacles;
+    if (mapPath && !obstacles.loadFromFile(mapPath)) {
+        LOG_ERROR("[Server] Failed to load obstacle map.");
+        return -1;
+    }
+
+    if (batchMode) {
+        // Validate the map once rather than in every battle
+        batch.config = config;
+        SimulationManager probe(config);
+        probe.setEventLogging(false);
+        if (mapPath && !probe.setObstacleMap(obstacles)) {
+            LOG_ERROR("[Server] Failed to load obstacle map.");
+            return -1;
+        }
+        batch.obstacles = mapPath ? &obstacles : nullptr;
+        if (!config.recordFile.empty()) LOG_WARNING("[Batch] record-file is ignored in batch mode");
+        if (!config.checkpointFile.empty() || restorePath) LOG_WARNING("[Batch] Checkpoints are ignored in batch mode");
+
+        LOG_INFO("[Batch] Running {} battles from seed {}...", batch.battles, batch.seed);
+        BatchRunner::Report report = BatchRunner::run(batch);
+        Log::flush();
+        BatchRunner::printReport(report, std::cout);
+        if (!config.traceFile.empty()) Tracing::writeChromeTrace(config.traceFile);
+        return 0;
+    }
 
     // Create simulation manager
-    SimulationManager simulationManager;
-    simulationManager.initialize(rng);
+    SimulationManager simulationManager(config);
+    if (mapPath && !restorePath && !simulationManager.setObstacleMap(obstacles)) {
+        LOG_ERROR("[Server] Failed to load obstacle map.");
+        return -1;
+    }
+    if (mapPath && restorePath) LOG_WARNING("[Server] {} is ignored; the checkpoint holds its own terrain", mapPath);
+
+    // Written between ticks when checkpoint-tick is reached or SIGUSR2 arrives
+    if (!config.checkpointFile.empty()) {
+#ifdef SIGUSR2
+        std::signal(SIGUSR2, onCheckpointSignal);
+#endif
+    }
+
+    // A checkpoint carries on from where it was saved, on its own grid size
+    if (restorePath && !simulationManager.restoreCheckpoint(restorePath)) return -1;
+
+    // Recording starts with the initial state, or the restored one
+    ReplayRecorder recorder;
+    if (!config.recordFile.empty()) {
+        if (!recorder.open(config.recordFile, simulationManager.getConfig().gridSize, config.keyframeInterval)) return -1;
+        simulationManager.setRecorder(&recorder);
+    }
+
+    // Same seed, same battle
+    if (restorePath) simulationManager.publishState();
+    else simulationManager.initialize(42);
 
     // Create network manager
     NetworkManager networkManager(simulationManager);
 
     // Initialize network
     if (!networkManager.initialize()) {
-        std::cerr << "[Server] Failed to initialize network.\n";
+        LOG_ERROR("[Server] Failed to initialize network.");
         return -1;
     }
 
@@ -28,16 +230,13 @@ int main() {
 
     // Wait for client connection
     if (!networkManager.waitForClient()) {
-        std::cerr << "[Server] Failed to connect with client.\n";
+        LOG_ERROR("[Server] Failed to connect with client.");
         simulationManager.signalShouldExit();
         simThread.join();
         return -1;
     }
 
-    // Send initial game state
-    networkManager.sendInitializationData();
-
-    // Start the data sending thread
+    // Start the network thread; it sends initial state to every client as it connects
     std::thread sendThread(&NetworkManager::sendSimulationData, &networkManager);
 
     // Wait for threads to complete
@@ -46,10 +245,13 @@ int main() {
     // Ensure simulation thread exits
     simulationManager.signalShouldExit();
     simThread.join();
+    recorder.close();
 
     // Close network connection
     networkManager.closeConnection();
 
-    std::cout << "[Server] Shutdown complete.\n";
+    if (!config.traceFile.empty()) Tracing::writeChromeTrace(config.traceFile);
+
+    LOG_INFO("[Server] Shutdown complete.");
     return 0;
 }
\ No newline at end of file
@@ -1,36 +1,145 @@
 ﻿#include "SimulationManager.h"
+#include "Checkpoint.h"
 #include "GameConfig.h"
-#include <iostream>
+#include "Log.h"
+#include "Pathfinding.h"
 #include <chrono>
 #include <thread>
 #include <algorithm>
-
-SimulationManager::SimulationManager()
-    : clientConnected(false), exitFlag(false), dataUpdated(false), simulationStarted(false) {}
+#include <cstdlib>
+
+SimulationManager::SimulationManager(const GameConfig& gameConfig)
+    : config(gameConfig), obstacles(config.gridSize, config.gridSize),
+      hierarchical(config.gridSize >= config.hierarchicalMinGridSize),
+      movementMode(config.movementMode), publishCount(0), tickCount(0),
+      seed(0), clientConnected(false), exitFlag(false), simulationStarted(false), eventLogging(true), recorder(nullptr) {
+    rebuildPathfinder();
+    if (config.workerThreads > 0) workerPool.reset(new ThreadPool(config.workerThreads));
+}
 
 SimulationManager::~SimulationManager() {}
 
-void SimulationManager::initialize(std::mt19937& rng) {
+bool SimulationManager::setObstacleMap(const ObstacleMap& map) {
+    if (map.getWidth() != config.gridSize || map.getHeight() != config.gridSize) {
+        LOG_ERROR("[Server] Obstacle map is {}x{}, expected {}x{}", map.getWidth(), map.getHeight(),
+            config.gridSize, config.gridSize);
+        return false;
+    }
+
+    // Balls spawn away from the edges, so at least one inner cell must be open
+    bool canSpawn = false;
+    for (int y = 1; y < config.gridSize - 1 && !canSpawn; ++y) {
+        for (int x = 1; x < config.gridSize - 1 && !canSpawn; ++x) {
+            canSpawn = map.isOpen(x, y);
+        }
+    }
+    if (!canSpawn) {
+        LOG_ERROR("[Server] Obstacle map has no open cells to spawn on");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(ballMutex);
+    obstacles = map;
+    rebuildPathfinder();
+    if (eventLogging) LOG_INFO("[Server] Obstacle map loaded with {} blocked cells.", obstacles.getBlockedCount());
+    return true;
+}
+
+void SimulationManager::setHierarchicalPathfinding(bool enabled) {
+    std::lock_guard<std::mutex> lock(ballMutex);
+    if (hierarchical == enabled) return;
+    hierarchical = enabled;
+    rebuildPathfinder();
+    for (size_t i = 0; i < balls.size(); ++i) balls.path(i).clear();
+}
+
+void SimulationManager::rebuildPathfinder() {
+    // Only the active planner is kept; a flat jump table does not fit in
+    // memory on the grids HPA* is meant for
+    if (hierarchical) {
+        hierarchy.build(obstacles, config.hierarchicalClusterSize);
+        jumpTable = JumpTable();
+    }
+    else {
+        jumpTable.build(obstacles);
+        hierarchy = HierarchicalPathfinder();
+    }
+}
+
+void SimulationManager::initialize(uint64_t battleSeed, int unitCount) {
     std::lock_guard<std::mutex> lock(ballMutex);
     balls.clear();
-    std::uniform_int_distribution<int> posDist(1, GameConfig::GRID_SIZE - 2); // Avoid spawning at edges
+    removedIds.clear();
+    winningTeam.clear();
+    tickCount = 0;
+    seed = battleSeed;
+    if (unitCount <= 0) unitCount = config.maxUnits;
+
+    // Each spawn draws from its own stream, keyed by spawn order
+    const uint32_t spawnRange = config.gridSize - 2;  // Avoid spawning at edges
+    const uint32_t hpRange = BallStats::MAX_HP - BallStats::MIN_HP + 1;
+    uint32_t spawnIndex = 0;
+
+    auto spawn = [&](bool isRed) {
+        int x, y;
+        uint32_t attempt = 0;
+        do {
+            x = 1 + static_cast<int>(CounterRng::below(CounterRng::draw(seed, 0, spawnIndex, CounterRng::Purpose::SpawnPosition, attempt++), spawnRange));
+            y = 1 + static_cast<int>(CounterRng::below(CounterRng::draw(seed, 0, spawnIndex, CounterRng::Purpose::SpawnPosition, attempt++), spawnRange));
+        } while (obstacles.isBlocked(x, y));
+        int hp = BallStats::MIN_HP + static_cast<int>(CounterRng::below(CounterRng::draw(seed, 0, spawnIndex, CounterRng::Purpose::SpawnHp), hpRange));
+        ++spawnIndex;
+
+        size_t slot = balls.add(x, y, hp, isRed);
+        if (eventLogging) {
+            LOG_DEBUG("[Ball] Created {} Ball at ({}, {}) with HP: {}", isRed ? "Red" : "Blue", x, y, balls.getHp(slot));
+        }
+    };
 
-    for (int i = 0; i < GameConfig::MAX_UNITS / 2; ++i) {
-        balls.push_back(std::make_shared<Ball>(posDist(rng), posDist(rng), true, rng));
-        balls.push_back(std::make_shared<Ball>(posDist(rng), posDist(rng), false, rng));
+    balls.reserve(unitCount);
+    for (int i = 0; i < unitCount / 2; ++i) {
+        spawn(true);
+        spawn(false);
     }
+    spatialGrid.rebuild(balls, config.gridSize);
+    publishState();
+
+    if (eventLogging) LOG_INFO("[Server] Balls initialized within grid boundaries.");
+}
 
-    std::cout << "[Server] Balls initialized within grid boundaries.\n";
+bool SimulationManager::saveCheckpoint(const std::string& path) const {
+    std::lock_guard<std::mutex> lock(ballMutex);
+    if (!Checkpoint::save(*this, path)) return false;
+    if (eventLogging) LOG_INFO("[Server] Checkpoint of tick {} saved to {}", tickCount, path);
+    return true;
+}
+
+bool SimulationManager::restoreCheckpoint(const std::string& path) {
+    std::lock_guard<std::mutex> lock(ballMutex);
+    if (!Checkpoint::restore(*this, path)) return false;
+
+    if (eventLogging) {
+        LOG_INFO("[Server] Restored tick {} of battle {} from {}: {} balls on a {}x{} grid", tickCount, seed, path,
+            balls.size(), config.gridSize, config.gridSize);
+    }
+    return true;
 }
 
 void SimulationManager::updateSimulation() {
     using Clock = std::chrono::steady_clock;
     using namespace std::chrono_literals;
 
-    const auto targetTimeStep = std::chrono::milliseconds(GameConfig::UPDATE_INTERVAL_MS);
-    auto nextUpdateTime = Clock::now() + targetTimeStep;
+    // Wall time per tick; zero at time-scale 0, which never sleeps between ticks
+    const auto idleTimeStep = std::chrono::milliseconds(config.updateIntervalMs);
+    Clock::duration targetTimeStep = Clock::duration::zero();
+    if (config.timeScale > 0) {
+        targetTimeStep = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::milli>(config.updateIntervalMs / config.timeScale));
+    }
+    auto nextUpdateTime = Clock::now() + idleTimeStep;
 
-    std::cout << "[Server] Simulation loop started.\n";
+    Tracing::setThreadName("simulation");
+    LOG_INFO("[Server] Simulation loop started.");
 
     while (!exitFlag) {
         // Wait until it's time for the next update
@@ -39,150 +148,399 @@ void SimulationManager::updateSimulation() {
             std::this_thread::sleep_for(timeToWait);
         }
 
-        // Process a single step of simulation
+        // Waiting for a client is paced in real time whatever the time scale
+        if (!clientConnected) {
+            nextUpdateTime = Clock::now() + idleTimeStep;
+            continue;
+        }
+
+        if (!simulationStarted) {
+            LOG_INFO("[Server] Client connected. Starting simulation in {} seconds...", config.startDelayMs / 1000.0);
+            simulationStarted = true;
+
+            // No lock is held during the delay, and readers never take one
+            std::this_thread::sleep_for(std::chrono::milliseconds(config.startDelayMs));
+            LOG_INFO("[Server] Simulation started!");
+
+            // Reset next update time after the initial delay
+            nextUpdateTime = Clock::now() + targetTimeStep;
+            continue;
+        }
+
+        // Process a single step of simulation and hand it to the network thread
         {
+            TRACE_SCOPE("tick");
             std::lock_guard<std::mutex> lock(ballMutex);
-            if (clientConnected) {
-                if (!simulationStarted) {
-                    std::cout << "[Server] Client connected. Starting simulation in 3 seconds...\n";
-                    simulationStarted = true;
-
-                    // Notify client that we're ready to start
-                    dataUpdated = true;
-                    dataReadyCV.notify_one();
-
-                    std::this_thread::sleep_for(std::chrono::seconds(3));
-                    std::cout << "[Server] Simulation started!\n";
-
-                    // Reset next update time after the initial delay
-                    nextUpdateTime = Clock::now() + targetTimeStep;
-                    continue;
-                }
-
-                if (simulationStarted) {
-                    // Update simulation state
-                    for (auto& ball : balls) {
-                        if (!ball->isDead()) {
-                            ball->updateCooldowns();
-                            std::shared_ptr<Ball> target = findNearestEnemy(ball);
-                            if (target) {
-                                ball->moveToward(target);
-                            }
-                            else {
-                                ball->wander();
-                            }
-                        }
-                    }
-
-                    handleCombat();
-                    removeDeadBalls();
-                }
-
-                // Mark data as updated for network thread
-                dataUpdated = true;
-                dataReadyCV.notify_one();
-            }
+            stepSimulation();
+            publishState();
+        }
+        notifyUpdate();
+
+        // Checkpoints fall between ticks, after the tick has been published
+        if (!config.checkpointFile.empty() &&
+            (tickCount == static_cast<uint32_t>(config.checkpointTick) || Checkpoint::takeSaveRequest())) {
+            saveCheckpoint(config.checkpointFile);
         }
 
-        // Schedule next update exactly 100ms after the current one
+        // Stop once the final tick has been published
+        if (isGameOver()) exitFlag = true;
+
+        // Schedule next update exactly one time step after the current one
         nextUpdateTime += targetTimeStep;
     }
 
-    std::cout << "[Server] Simulation loop exited.\n";
+    LOG_INFO("[Server] Simulation loop exited.");
 }
 
+void SimulationManager::stepSimulation() {
+    bool useFlowField = movementMode == MovementMode::FlowField;
+    if (useFlowField) {
+        TRACE_SCOPE("pathfinding");
+        flowField.build(balls, obstacles);
+    }
 
+    // Update simulation state
+    if (workerPool) {
+        moveInParallel(useFlowField);
+    }
+    else {
+        // Each ball targets and moves in turn, so targeting is part of this phase
+        TRACE_SCOPE("movement");
+        size_t count = balls.size();
+        for (size_t i = 0; i < count; ++i) {
+            if (balls.isDead(i)) continue;
+
+            int x = balls.getX(i);
+            int y = balls.getY(i);
+            planMove(i, useFlowField, useFlowField ? NO_BALL : findNearestEnemy(i), x, y);
+            balls.setPosition(i, x, y);
+            spatialGrid.moveBall(balls, i);
+        }
+    }
 
-std::shared_ptr<Ball> SimulationManager::findNearestEnemy(const std::shared_ptr<Ball>& ball) {
-    std::shared_ptr<Ball> target = nullptr;
-    int minDist = GameConfig::GRID_SIZE * 2;
+    handleCombat();
+    removeDeadBalls();
+    ++tickCount;
+}
 
-    int enemyCount = 0;
-    std::shared_ptr<Ball> lastEnemy = nullptr;
+void SimulationManager::setWorkerThreads(size_t threads) {
+    std::lock_guard<std::mutex> lock(ballMutex);
+    if (threads == 0) workerPool.reset();
+    else if (!workerPool || workerPool->getThreadCount() != threads) workerPool.reset(new ThreadPool(threads));
+}
 
-    for (auto& other : balls) {
-        if (ball->isRedTeam() != other->isRedTeam() && !other->isDead()) {
-            enemyCount++;
-            lastEnemy = other;  // Track last seen enemy
+size_t SimulationManager::getWorkerThreads() const {
+    return workerPool ? workerPool->getThreadCount() : 0;
+}
 
-            int dist = std::abs(ball->getX() - other->getX()) +
-                std::abs(ball->getY() - other->getY());
+void SimulationManager::planMove(size_t ball, bool useFlowField, int target, int& x, int& y) {
+    if (balls.getCooldown(ball) > 0) balls.setCooldown(ball, balls.getCooldown(ball) - 1);
+    if (useFlowField) {
+        if (!followFlowField(ball, x, y)) wander(ball, x, y);
+        return;
+    }
 
-            if (dist < minDist) {
-                minDist = dist;
-                target = other;
+    if (target == NO_BALL) wander(ball, x, y);
+    else moveToward(ball, static_cast<size_t>(target), x, y);
+}
+
+void SimulationManager::moveInParallel(bool useFlowField) {
+    size_t count = balls.size();
+    targets.resize(count);
+    nextXs.resize(count);
+    nextYs.resize(count);
+
+    // Every ball plans against the positions at the start of the tick and
+    // writes only its own slot, so the outcome is the same on any number of
+    // threads. The grid and ball positions stay untouched until the commit,
+    // which also lets all targets be found in a pass of their own.
+    if (!useFlowField) {
+        TRACE_SCOPE("targeting");
+        workerPool->parallelFor(count, PARALLEL_CHUNK_SIZE, [&](size_t begin, size_t end) {
+            TRACE_DETAIL_SCOPE("targeting chunk");
+            for (size_t i = begin; i < end; ++i) targets[i] = balls.isDead(i) ? NO_BALL : findNearestEnemy(i);
+        });
+    }
+
+    TRACE_SCOPE("movement");
+    workerPool->parallelFor(count, PARALLEL_CHUNK_SIZE, [&](size_t begin, size_t end) {
+        TRACE_DETAIL_SCOPE("movement chunk");
+        for (size_t i = begin; i < end; ++i) {
+            int x = balls.getX(i);
+            int y = balls.getY(i);
+            if (!balls.isDead(i)) planMove(i, useFlowField, useFlowField ? NO_BALL : targets[i], x, y);
+            nextXs[i] = x;
+            nextYs[i] = y;
+        }
+    });
+
+    // Balls plan from where the others were, so two enemies can mirror each
+    // other tick after tick and never meet. Such moves are held back here,
+    // reading only start-of-tick positions and the plan, so the outcome still
+    // does not depend on the thread count. A held ball drops its path and
+    // plans afresh next tick.
+    if (!useFlowField) {
+        for (size_t i = 0; i < count; ++i) {
+            int target = targets[i];
+            if (target == NO_BALL || balls.isDead(i)) continue;
+
+            int x = balls.getX(i);
+            int y = balls.getY(i);
+            if (nextXs[i] == x && nextYs[i] == y) continue;
+            int targetX = balls.getX(target);
+            int targetY = balls.getY(target);
+            int before = std::abs(targetX - x) + std::abs(targetY - y);
+
+            // A path kept from an earlier tick can lead away from where the
+            // target has gone since; one planned this tick is trusted, detours
+            // included. Having moved, the ball has a step, so destination is valid.
+            bool stale = balls.path(i).destination() != std::make_pair(targetX, targetY) &&
+                std::abs(targetX - nextXs[i]) + std::abs(targetY - nextYs[i]) >= before;
+
+            // Enemies stepping toward each other's old cells can pass, e.g.
+            // diagonal neighbours swapping axes. When the target is closing in
+            // and this step would undo that, the lower slot waits. Higher
+            // slots are not changed yet, so this reads the target's plan.
+            bool contested = false;
+            if (static_cast<size_t>(target) > i) {
+                int ifHeld = std::abs(nextXs[target] - x) + std::abs(nextYs[target] - y);
+                int ifMoved = std::abs(nextXs[target] - nextXs[i]) + std::abs(nextYs[target] - nextYs[i]);
+                contested = ifHeld < before && ifHeld < ifMoved;
             }
+            if (!stale && !contested) continue;
+
+            nextXs[i] = x;
+            nextYs[i] = y;
+            balls.path(i).clear();  // Its next step starts from the cell it skipped
         }
     }
 
-    // If only one enemy remains, force all to target it
-    if (enemyCount == 1 && lastEnemy) {
-        return lastEnemy;
+    for (size_t i = 0; i < count; ++i) {
+        if (balls.isDead(i)) continue;
+        balls.setPosition(i, nextXs[i], nextYs[i]);
+        spatialGrid.moveBall(balls, i);
     }
+}
 
-    return target;
+int SimulationManager::findNearestEnemy(size_t ball) const {
+    // Expanding-ring search over the enemy team's buckets; ties and the
+    // "only one enemy remains" rule behave exactly like a full scan
+    return spatialGrid.findNearestEnemy(balls, ball);
 }
 
-void SimulationManager::handleCombat() {
-    for (auto& attacker : balls) {
-        if (attacker->isDead()) continue;
+void SimulationManager::moveToward(size_t ball, size_t target, int& x, int& y) {
+    if (balls.isDead(ball) || balls.isDead(target)) return;
 
-        // Skip if attacker is on cooldown
-        if (!attacker->canAttack()) continue;
+    int targetX = balls.getX(target);
+    int targetY = balls.getY(target);
+    BallPath& path = balls.path(ball);
 
-        std::shared_ptr<Ball> bestTarget = nullptr;
-        int bestDistance = GameConfig::GRID_SIZE * 2;
+    // A hierarchical route is refined one segment ahead of the ball
+    refineRoute(path, x, y);
 
-        for (auto& defender : balls) {
-            if (defender->isDead() || attacker->isRedTeam() == defender->isRedTeam()) continue;
+    // Always recalculate the path if target moved or if we're close to completing the path
+    // This prevents getting stuck when targets move during path following
+    if (path.empty() || (path.size() < 3 && !path.hasPendingWaypoints()) ||
+        (std::abs(targetX - path.destination().first) > 1 ||
+            std::abs(targetY - path.destination().second) > 1)) {
 
-            int distance = std::abs(attacker->getX() - defender->getX()) +
-                std::abs(attacker->getY() - defender->getY());
+        TRACE_DETAIL_SCOPE("pathfinding");
+        if (hierarchical) {
+            thread_local std::vector<std::pair<int, int>> route;
+            if (hierarchy.findRoute(x, y, targetX, targetY, route)) path.assignRoute(route);
+            else path.clear();
+            refineRoute(path, x, y);
+        }
+        else {
+            // Calculate new path, skipping the first node (current position)
+            path.assign(PathWorkspace::forThisThread().findJumpPointPath(jumpTable, x, y, targetX, targetY), 1);
+        }
+    }
 
-            if (distance <= attacker->getAttackRange() && distance < bestDistance) {
-                bestTarget = defender;
-                bestDistance = distance;
-            }
+    // Take next step on path if available
+    if (!path.empty()) {
+        auto nextMove = path.front();
+        path.pop();
+
+        // Only move if this actually brings us closer to target. Around
+        // obstacles a shortest path may have to step away first, so trust it.
+        int currentDist = std::abs(x - targetX) + std::abs(y - targetY);
+        int newDist = std::abs(nextMove.first - targetX) + std::abs(nextMove.second - targetY);
+
+        if (newDist < currentDist || obstacles.getBlockedCount() > 0) {
+            x = nextMove.first;
+            y = nextMove.second;
+        }
+        else {
+            // If the next step doesn't bring us closer, recalculate path next time
+            path.clear();
+        }
+    }
+    else {
+        // Direct movement if no path or path is invalid; fall back to a
+        // single axis when the diagonal is blocked
+        int dx = (targetX > x) ? 1 : (targetX < x) ? -1 : 0;
+        int dy = (targetY > y) ? 1 : (targetY < y) ? -1 : 0;
+
+        if (canStep(x, y, x + dx, y + dy)) {
+            x += dx;
+            y += dy;
         }
+        else if (dx != 0 && canStep(x, y, x + dx, y)) {
+            x += dx;
+        }
+        else if (dy != 0 && canStep(x, y, x, y + dy)) {
+            y += dy;
+        }
+    }
+
+    // Keep within grid boundaries
+    x = std::clamp(x, 0, config.gridSize - 1);
+    y = std::clamp(y, 0, config.gridSize - 1);
+
+    // Update cooldowns
+    if (balls.getCooldown(ball) > 0) balls.setCooldown(ball, balls.getCooldown(ball) - 1);
+}
+
+void SimulationManager::refineRoute(BallPath& path, int x, int y) {
+    while (path.size() < 3 && path.hasPendingWaypoints()) {
+        std::pair<int, int> from = path.empty() ? std::make_pair(x, y) : path.back();
+        const std::pair<int, int>& to = path.pendingWaypoint();
+        TRACE_DETAIL_SCOPE("pathfinding");
+        const auto& segment = hierarchy.refineSegment(from.first, from.second, to.first, to.second);
+        if (segment.empty()) {
+            // Waypoints are connected by construction; give up and replan
+            path.clear();
+            return;
+        }
+        path.appendSteps(segment, 1);
+        path.popWaypoint();
+    }
+}
+
+bool SimulationManager::followFlowField(size_t ball, int& x, int& y) {
+    bool isRed = balls.isRedTeam(ball);
+    if (flowField.distance(isRed, x, y) == FlowField::UNREACHABLE) return false;
+
+    // The field was built from enemy positions at the start of the tick
+    flowField.stepDownhill(isRed, x, y);
+
+    // Same cooldown bookkeeping as moveToward
+    if (balls.getCooldown(ball) > 0) balls.setCooldown(ball, balls.getCooldown(ball) - 1);
+    return true;
+}
+
+void SimulationManager::wander(size_t ball, int& x, int& y) const {
+    // Simple wandering movement if no valid enemy found; random -1, 0, or 1
+    // per axis from this ball's stream for the tick
+    uint64_t bits = CounterRng::draw(seed, tickCount, balls.getID(ball), CounterRng::Purpose::Wander);
+    int dx = static_cast<int>(CounterRng::below(bits, 3)) - 1;
+    int dy = static_cast<int>(CounterRng::below(bits << 32, 3)) - 1;
+
+    int nextX = std::clamp(x + dx, 0, config.gridSize - 1);
+    int nextY = std::clamp(y + dy, 0, config.gridSize - 1);
 
-        if (bestTarget) {
+    // Bump into obstacles rather than walking through them
+    if (!canStep(x, y, nextX, nextY)) return;
+
+    x = nextX;
+    y = nextY;
+}
+
+bool SimulationManager::canStep(int x, int y, int nextX, int nextY) const {
+    if (obstacles.isBlocked(nextX, nextY)) return false;
+
+    // A diagonal step may not squeeze between two blocked corners
+    if (nextX != x && nextY != y) {
+        return obstacles.isOpen(nextX, y) || obstacles.isOpen(x, nextY);
+    }
+    return true;
+}
+
+void SimulationManager::handleCombat() {
+    TRACE_SCOPE("combat");
+    const int32_t* hps = balls.hpData();
+    const uint8_t* teams = balls.teamData();
+    size_t count = balls.size();
+
+    for (size_t attacker = 0; attacker < count; ++attacker) {
+        if (hps[attacker] <= 0) continue;
+
+        // Skip if attacker is on cooldown
+        if (balls.getCooldown(attacker) > 0) continue;
+
+        // Closest living enemy within reach, lowest slot on ties
+        int bestTarget = spatialGrid.findEnemyInRange(balls, attacker, BallStats::ATTACK_RANGE);
+
+        if (bestTarget != NO_BALL) {
             // Reset the attack cooldown when an attack is made
-            attacker->resetAttackCooldown();
+            balls.setCooldown(attacker, BallStats::ATTACK_RATE);
 
-            bool targetKilled = bestTarget->takeDamage(1);
-            std::string teamName = attacker->isRedTeam() ? "Red" : "Blue";
-            std::cout << "[Server] " << teamName << " Ball attacked! Target HP: " << bestTarget->getHp() << std::endl;
+            if (balls.takeDamage(static_cast<size_t>(bestTarget), 1)) {
+                spatialGrid.markDead(balls, static_cast<size_t>(bestTarget));
+            }
+            if (eventLogging) {
+                LOG_DEBUG("[Server] {} Ball attacked! Target HP: {}", teams[attacker] ? "Red" : "Blue", hps[bestTarget]);
+            }
         }
     }
 }
 
 void SimulationManager::removeDeadBalls() {
-    balls.erase(
-        std::remove_if(balls.begin(), balls.end(),
-            [](const std::shared_ptr<Ball>& b) { return b->isDead(); }
-        ),
-        balls.end()
-    );
+    TRACE_SCOPE("remove dead");
+    balls.removeDead(removedIds);
+    spatialGrid.rebuild(balls, config.gridSize);
 
     bool redExists = false, blueExists = false;
-    for (const auto& ball : balls) {
-        if (ball->isRedTeam()) redExists = true;
+    const uint8_t* teams = balls.teamData();
+    for (size_t i = 0; i < balls.size(); ++i) {
+        if (teams[i]) redExists = true;
         else blueExists = true;
     }
 
     if (!redExists || !blueExists) {
         winningTeam = redExists ? "Red Team Wins!" : "Blue Team Wins!";
-        std::cout << "[Server] Game Over! " << winningTeam << std::endl;
-
-        exitFlag = true;  // Stops simulation loop
-        dataUpdated = true;
-        dataReadyCV.notify_all();  // Notifies network threads to stop
+        if (eventLogging) LOG_INFO("[Server] Game Over! {}", winningTeam);
     }
 }
 
-std::vector<std::shared_ptr<Ball>> SimulationManager::getBalls() const {
-    std::lock_guard<std::mutex> lock(ballMutex);
-    return balls;
+static SnapshotProtocol::UnitRecord makeUnitRecord(const BallStore& balls, size_t i, uint8_t fieldMask) {
+    SnapshotProtocol::UnitRecord record;
+    record.id = balls.getID(i);
+    record.fieldMask = fieldMask;
+    record.x = static_cast<uint16_t>(balls.getX(i));
+    record.y = static_cast<uint16_t>(balls.getY(i));
+    record.hp = balls.getHp(i);
+    record.isRed = balls.isRedTeam(i);
+    return record;
+}
+
+void SimulationManager::publishState() {
+    TRACE_SCOPE("publish");
+    PublishedState& next = publishedStates.writeSlot();
+    next.sequence = ++publishCount;
+
+    next.state.clear();
+    next.state.tick = tickCount;
+    next.state.units.reserve(balls.size());
+    for (size_t i = 0; i < balls.size(); ++i) {
+        next.state.units.push_back(makeUnitRecord(balls, i, SnapshotProtocol::FIELD_ALL));
+    }
+
+    // Dirty bits accumulate until the next publication
+    next.changes.clear();
+    next.changes.tick = tickCount;
+    for (size_t i = 0; i < balls.size(); ++i) {
+        uint8_t mask = balls.getDirtyMask(i);
+        if (mask != 0) next.changes.units.push_back(makeUnitRecord(balls, i, mask));
+        balls.clearDirtyMask(i);
+    }
+    next.changes.removedIds.assign(removedIds.begin(), removedIds.end());
+    removedIds.clear();
+
+    next.winningTeam = winningTeam;
+    if (recorder) recorder->record(next.state, next.changes, next.winningTeam);
+    publishedStates.publish();
 }
 
 std::string SimulationManager::getWinningTeam() const {
@@ -205,11 +563,11 @@ bool SimulationManager::shouldExit() const {
     return exitFlag;
 }
 
-void SimulationManager::waitForUpdate() {
-    std::unique_lock<std::mutex> lock(ballMutex);
-    dataReadyCV.wait(lock, [this] { return dataUpdated || exitFlag; });
+void SimulationManager::setUpdateListener(std::function<void()> listener) {
+    std::lock_guard<std::mutex> lock(ballMutex);
+    updateListener = std::move(listener);
 }
 
-void SimulationManager::resetUpdateFlag() {
-    dataUpdated = false;
-}
\ No newline at end of file
+void SimulationManager::notifyUpdate() {
+    if (updateListener) updateListener();
+}
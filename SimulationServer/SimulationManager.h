@@ -1,41 +1,147 @@
 ﻿#pragma once
 
-#include "Ball.h"
+#include "BallStore.h"
+#include "SpatialGrid.h"
+#include "FlowField.h"
+#include "ObstacleMap.h"
+#include "JumpTable.h"
+#include "HierarchicalPathfinder.h"
+#include "GameConfig.h"
+#include "SnapshotProtocol.h"
+#include "ThreadPool.h"
+#include "TripleBuffer.h"
+#include "CounterRng.h"
+#include "ReplayRecorder.h"
+#include "Tracing.h"
 #include <vector>
-#include <random>
 #include <mutex>
-#include <condition_variable>
 #include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+
+// Immutable copy of one tick, handed from the simulation thread to the
+// network thread
+struct PublishedState {
+    uint64_t sequence = 0;                         // Increments with every publication
+    SnapshotProtocol::SimulationSnapshot state;    // Every living unit with all fields set
+    SnapshotProtocol::SimulationSnapshot changes;  // Units changed and IDs removed since the previous publication
+    std::string winningTeam;                       // Empty while the battle is running
+};
 
 class SimulationManager {
 public:
-    SimulationManager();
+    explicit SimulationManager(const GameConfig& config = GameConfig());
     ~SimulationManager();
 
-    void initialize(std::mt19937& rng);
+    const GameConfig& getConfig() const { return config; }
+
+    // Replaces the terrain; call before initialize. The map must match the grid size.
+    bool setObstacleMap(const ObstacleMap& map);
+    const ObstacleMap& getObstacleMap() const { return obstacles; }
+
+    // Spawns half red, half blue, the config's maxUnits in total unless unitCount
+    // is given. The seed alone determines the battle.
+    void initialize(uint64_t seed, int unitCount = 0);
     void updateSimulation();
-    std::shared_ptr<Ball> findNearestEnemy(const std::shared_ptr<Ball>& ball);
+    void stepSimulation();  // Advances one tick; caller must hold ballMutex or own the manager exclusively
+    int findNearestEnemy(size_t ball) const;  // Slot of the target, or NO_BALL
+    void setMovementMode(MovementMode mode) { movementMode = mode; }  // Takes effect on the next tick
+    // Threads for the targeting and movement phase. 0 updates balls one at a
+    // time in place; any other count plans every ball from the previous
+    // tick's positions, with results independent of the count.
+    void setWorkerThreads(size_t threads);
+    size_t getWorkerThreads() const;
+    MovementMode getMovementMode() const { return movementMode; }
+    // Plans with HPA* instead of flat JPS; on by default for very large grids
+    void setHierarchicalPathfinding(bool enabled);
+    bool isHierarchicalPathfinding() const { return hierarchical; }
+    // Console lines for spawns, attacks, map loads and the result; on by default
+    void setEventLogging(bool enabled) { eventLogging = enabled; }
+    // Every publication from now on is also appended to recorder, which
+    // must outlive the simulation; null stops recording
+    void setRecorder(ReplayRecorder* replayRecorder) { recorder = replayRecorder; }
+    // Writes the full state at the current tick (layout in Checkpoint.h).
+    // Prints the reason and returns false on failure.
+    bool saveCheckpoint(const std::string& path) const;
+    // Replaces initialize: resumes the battle saved in path, whose future
+    // ticks then match the original run's. Also adopts the checkpoint's grid
+    // size and movement settings. Unlike initialize it publishes nothing, so a
+    // recorder can be sized for the restored grid first; call publishState
+    // before starting the simulation. Prints the reason and returns false on failure.
+    bool restoreCheckpoint(const std::string& path);
     void handleCombat();
     void removeDeadBalls();
 
-    std::vector<std::shared_ptr<Ball>> getBalls() const;
+    // Read-only view of the live ball columns. Only safe to read from the
+    // simulation thread or while the simulation is not running.
+    const BallStore& getBalls() const { return balls; }
+
+    static const int NO_BALL = -1;
+
+    // Tick, winner and game-over state of the live simulation; simulation thread only
+    uint32_t getTick() const { return tickCount; }
     std::string getWinningTeam() const;
     bool isGameOver() const;
 
+    // Copies the current tick into the next published state. Called by the
+    // simulation loop after every tick; never blocks on readers.
+    void publishState();
+    // Reader side, for one thread at a time: switches to the newest published
+    // state and returns false if there was nothing new. The state returned by
+    // getPublishedState stays unchanged until the next acquire.
+    bool acquirePublishedState() { return publishedStates.acquire(); }
+    const PublishedState& getPublishedState() const { return publishedStates.readSlot(); }
+
     void signalClientConnected();
     void signalShouldExit();
     bool shouldExit() const;
 
-    void waitForUpdate();
-    void resetUpdateFlag();
+    // Invoked from the simulation thread after each publication. Set it
+    // before the simulation thread starts.
+    void setUpdateListener(std::function<void()> listener);
 
 private:
-    std::vector<std::shared_ptr<Ball>> balls;
+    GameConfig config;
+    BallStore balls;
+    SpatialGrid spatialGrid;  // Per-team buckets for targeting and combat range checks
+    FlowField flowField;      // Rebuilt each tick in MovementMode::FlowField
+    ObstacleMap obstacles;
+    JumpTable jumpTable;      // Precomputed from obstacles for flat pathfinding
+    HierarchicalPathfinder hierarchy;  // Built instead of jumpTable when hierarchical
+    bool hierarchical;
+    MovementMode movementMode;
+    std::unique_ptr<ThreadPool> workerPool;  // Null when moving sequentially
+    std::vector<int32_t> targets;    // Nearest enemy per slot, found before the parallel moves
+    std::vector<int32_t> nextXs;     // Positions planned by the parallel phase
+    std::vector<int32_t> nextYs;
+    std::vector<uint32_t> removedIds;  // Dead units not yet reported in a snapshot
+    TripleBuffer<PublishedState> publishedStates;
+    uint64_t publishCount;
+    uint32_t tickCount;
+    uint64_t seed;  // Keys every CounterRng draw of the battle
     mutable std::mutex ballMutex;
     std::atomic<bool> clientConnected;
     std::atomic<bool> exitFlag;
-    std::condition_variable dataReadyCV;
-    bool dataUpdated;
+    std::function<void()> updateListener;
     std::string winningTeam;
     bool simulationStarted;
+    bool eventLogging;
+    ReplayRecorder* recorder;
+
+    void notifyUpdate();
+    static const size_t PARALLEL_CHUNK_SIZE = 64;
+
+    // Plans one step for a living ball toward target (ignored with the flow
+    // field); (x, y) starts at its position and receives the next one
+    void planMove(size_t ball, bool useFlowField, int target, int& x, int& y);
+    void moveInParallel(bool useFlowField);
+    void moveToward(size_t ball, size_t target, int& x, int& y);
+    void rebuildPathfinder();
+    void refineRoute(BallPath& path, int x, int y);  // Turns pending waypoints into steps
+    bool followFlowField(size_t ball, int& x, int& y);  // False if no enemy is reachable
+    void wander(size_t ball, int& x, int& y) const;
+    bool canStep(int x, int y, int nextX, int nextY) const;  // Target open and no corner squeezing
+
+    friend class Checkpoint;
 };
\ No newline at end of file
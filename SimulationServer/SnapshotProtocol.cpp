@@ -0,0 +1,154 @@
+﻿#include "SnapshotProtocol.h"
+
+namespace SnapshotProtocol {
+
+namespace {
+
+void writeU8(std::string& out, uint8_t value) {
+    out.push_back(static_cast<char>(value));
+}
+
+void writeU16(std::string& out, uint16_t value) {
+    out.push_back(static_cast<char>(value & 0xFF));
+    out.push_back(static_cast<char>(value >> 8));
+}
+
+void writeU32(std::string& out, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+// HP is non-negative for every unit that is still alive and on the wire
+uint32_t wireHp(int32_t hp) {
+    return hp > 0 ? static_cast<uint32_t>(hp) : 0u;
+}
+
+// Reserves the length prefix and writes the message header; returns the prefix offset
+size_t beginFrame(std::string& out, MessageType type, uint32_t tick) {
+    size_t prefixOffset = out.size();
+    writeU32(out, 0);
+    writeU16(out, MAGIC);
+    writeU8(out, VERSION);
+    writeU8(out, static_cast<uint8_t>(type));
+    writeU32(out, tick);
+    return prefixOffset;
+}
+
+// Patches the length prefix now that the payload size is known
+void finishFrame(std::string& out, size_t prefixOffset) {
+    uint32_t length = static_cast<uint32_t>(out.size() - prefixOffset - FRAME_PREFIX_SIZE);
+    for (size_t i = 0; i < FRAME_PREFIX_SIZE; ++i) {
+        out[prefixOffset + i] = static_cast<char>((length >> (8 * i)) & 0xFF);
+    }
+}
+
+}  // namespace
+
+void writeVarint(std::string& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void encodeKeyframe(std::string& out, uint32_t tick, int gridSize, const std::vector<UnitRecord>& units) {
+    // Worst case per unit: 5 (id) + 4 (position) + 5 (hp) + 1 (team)
+    out.reserve(out.size() + FRAME_PREFIX_SIZE + HEADER_SIZE + 10 + units.size() * 15);
+
+    size_t frame = beginFrame(out, MessageType::Keyframe, tick);
+    writeVarint(out, static_cast<uint32_t>(gridSize));
+    writeVarint(out, static_cast<uint32_t>(units.size()));
+
+    for (const auto& unit : units) {
+        writeVarint(out, unit.id);
+        writeU16(out, unit.x);
+        writeU16(out, unit.y);
+        writeVarint(out, wireHp(unit.hp));
+        writeU8(out, unit.isRed ? 1 : 0);
+    }
+    finishFrame(out, frame);
+}
+
+namespace {
+
+void writeIds(std::string& out, const std::vector<uint32_t>& ids) {
+    writeVarint(out, static_cast<uint32_t>(ids.size()));
+    for (uint32_t id : ids) {
+        writeVarint(out, id);
+    }
+}
+
+void writeDeltaBody(std::string& out, const SimulationSnapshot& snapshot) {
+    writeVarint(out, static_cast<uint32_t>(snapshot.units.size()));
+
+    for (const auto& unit : snapshot.units) {
+        writeVarint(out, unit.id);
+        writeU8(out, unit.fieldMask);
+        if (unit.fieldMask & FIELD_POSITION) {
+            writeU16(out, unit.x);
+            writeU16(out, unit.y);
+        }
+        if (unit.fieldMask & FIELD_HP) writeVarint(out, wireHp(unit.hp));
+        if (unit.fieldMask & FIELD_TEAM) writeU8(out, unit.isRed ? 1 : 0);
+    }
+    writeIds(out, snapshot.removedIds);
+}
+
+}  // namespace
+
+void encodeDelta(std::string& out, const SimulationSnapshot& snapshot) {
+    out.reserve(out.size() + FRAME_PREFIX_SIZE + HEADER_SIZE + 10 + snapshot.units.size() * 16 + snapshot.removedIds.size() * 5);
+
+    size_t frame = beginFrame(out, MessageType::Delta, snapshot.tick);
+    writeDeltaBody(out, snapshot);
+    finishFrame(out, frame);
+}
+
+void encodeViewDelta(std::string& out, const SimulationSnapshot& snapshot, const std::vector<uint32_t>& leftIds) {
+    out.reserve(out.size() + FRAME_PREFIX_SIZE + HEADER_SIZE + 15 + snapshot.units.size() * 16 +
+        (snapshot.removedIds.size() + leftIds.size()) * 5);
+
+    size_t frame = beginFrame(out, MessageType::ViewDelta, snapshot.tick);
+    writeDeltaBody(out, snapshot);
+    writeIds(out, leftIds);
+    finishFrame(out, frame);
+}
+
+void encodeGameOver(std::string& out, uint32_t tick, const std::string& message) {
+    size_t frame = beginFrame(out, MessageType::GameOver, tick);
+    writeVarint(out, static_cast<uint32_t>(message.size()));
+    out.append(message);
+    finishFrame(out, frame);
+}
+
+void diffUnits(const std::vector<UnitRecord>& previous, const std::vector<UnitRecord>& current, uint32_t tick,
+    SimulationSnapshot& out, uint8_t newUnitMask) {
+    out.clear();
+    out.tick = tick;
+
+    // One merge pass over both lists
+    size_t p = 0, c = 0;
+    while (p < previous.size() || c < current.size()) {
+        if (c == current.size() || (p < previous.size() && previous[p].id < current[c].id)) {
+            out.removedIds.push_back(previous[p++].id);
+            continue;
+        }
+        UnitRecord unit = current[c++];
+        if (p < previous.size() && previous[p].id == unit.id) {
+            const UnitRecord& before = previous[p++];
+            unit.fieldMask = 0;
+            if (unit.x != before.x || unit.y != before.y) unit.fieldMask |= FIELD_POSITION;
+            if (unit.hp != before.hp) unit.fieldMask |= FIELD_HP;
+            if (unit.isRed != before.isRed) unit.fieldMask |= FIELD_TEAM;
+            if (unit.fieldMask == 0) continue;
+        }
+        else {
+            unit.fieldMask = newUnitMask;
+        }
+        out.units.push_back(unit);
+    }
+}
+
+}  // namespace SnapshotProtocol
@@ -0,0 +1,49 @@
+﻿#pragma once
+
+#include <SnapshotProtocol/WireFormat.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Server-side encoders for the snapshot wire format described in WireFormat.h.
+// Every encoder emits one complete length-prefixed frame.
+namespace SnapshotProtocol {
+
+struct UnitRecord {
+    uint32_t id;
+    uint8_t fieldMask;
+    uint16_t x;
+    uint16_t y;
+    int32_t hp;
+    bool isRed;
+};
+
+struct SimulationSnapshot {
+    uint32_t tick = 0;
+    std::vector<UnitRecord> units;
+    std::vector<uint32_t> removedIds;
+
+    void clear() {
+        tick = 0;
+        units.clear();
+        removedIds.clear();
+    }
+};
+
+void writeVarint(std::string& out, uint32_t value);
+
+// Encoders append to out so callers can reuse one buffer across frames
+void encodeKeyframe(std::string& out, uint32_t tick, int gridSize, const std::vector<UnitRecord>& units);
+void encodeDelta(std::string& out, const SimulationSnapshot& snapshot);
+void encodeGameOver(std::string& out, uint32_t tick, const std::string& message);
+// Delta for a viewport client; leftIds are living units that left its view
+void encodeViewDelta(std::string& out, const SimulationSnapshot& snapshot, const std::vector<uint32_t>& leftIds);
+
+// Fills out with what changed from previous to current, two full unit lists
+// in ascending ID order (the server's slot order): changed fields of units
+// in both, new units with newUnitMask and the IDs of units that are gone.
+// Lets a frame cover any number of ticks without falling back to a keyframe.
+void diffUnits(const std::vector<UnitRecord>& previous, const std::vector<UnitRecord>& current, uint32_t tick,
+    SimulationSnapshot& out, uint8_t newUnitMask = FIELD_ALL);
+
+}  // namespace SnapshotProtocol
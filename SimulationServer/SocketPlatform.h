@@ -0,0 +1,85 @@
+﻿#pragma once
+
+// Thin portability layer over Winsock and POSIX sockets so NetworkManager can
+// share one connection-handling code path on both platforms.
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#endif
+
+namespace SocketPlatform {
+
+#ifdef _WIN32
+using SocketHandle = SOCKET;
+const SocketHandle InvalidSocket = INVALID_SOCKET;
+using AddressLength = int;
+const int SendFlags = 0;
+#else
+using SocketHandle = int;
+const SocketHandle InvalidSocket = -1;
+using AddressLength = socklen_t;
+const int SendFlags = MSG_NOSIGNAL;  // Report EPIPE instead of raising SIGPIPE
+#endif
+
+inline bool startup() {
+#ifdef _WIN32
+    WSADATA wsa;
+    return WSAStartup(MAKEWORD(2, 2), &wsa) == 0;
+#else
+    return true;
+#endif
+}
+
+inline void cleanup() {
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+inline void closeSocket(SocketHandle socket) {
+#ifdef _WIN32
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
+
+inline bool setNonBlocking(SocketHandle socket) {
+#ifdef _WIN32
+    u_long mode = 1;
+    return ioctlsocket(socket, FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+inline void setNoDelay(SocketHandle socket) {
+    int opt = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&opt), sizeof(opt));
+}
+
+// True when the last socket call failed only because it would have blocked.
+inline bool lastErrorWouldBlock() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+}  // namespace SocketPlatform
@@ -0,0 +1,163 @@
+﻿#include "SpatialGrid.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+
+// Balls that die mid-tick are parked here so they never win a query
+static const int32_t DEAD_COORD = INT32_MAX / 4;
+
+// Average balls per team per cell the cell size is chosen for
+static const int TARGET_BALLS_PER_CELL = 4;
+
+SpatialGrid::SpatialGrid()
+    : worldSize(1), cellSize(1), cellsPerSide(1), nearestKernel(DistanceKernels::nearest()) {}
+
+void SpatialGrid::rebuild(const BallStore& balls, int newWorldSize) {
+    worldSize = std::max(1, newWorldSize);
+
+    // Small cells waste ring scans on empty buckets, large ones on far balls
+    double cellsNeeded = std::max(1.0, static_cast<double>(balls.size()) / (2 * TARGET_BALLS_PER_CELL));
+    int idealCellSize = static_cast<int>(std::ceil(worldSize / std::sqrt(cellsNeeded)));
+    cellSize = std::clamp(idealCellSize, 1, worldSize);
+    cellsPerSide = (worldSize + cellSize - 1) / cellSize;
+    size_t cellCount = static_cast<size_t>(cellsPerSide) * cellsPerSide;
+
+    const uint8_t* teamOf = balls.teamData();
+    const int32_t* xs = balls.xData();
+    const int32_t* ys = balls.yData();
+    size_t count = balls.size();
+
+    // Counting sort by cell; iterating slots in order keeps each cell ascending
+    for (auto& team : teams) {
+        team.cellStart.assign(cellCount + 1, 0);
+        team.living = 0;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        TeamBuckets& team = teams[teamOf[i]];
+        team.cellStart[cellCoord(ys[i]) * cellsPerSide + cellCoord(xs[i]) + 1]++;
+        if (!balls.isDead(i)) team.living++;
+    }
+    for (auto& team : teams) {
+        for (size_t c = 0; c < cellCount; ++c) team.cellStart[c + 1] += team.cellStart[c];
+        size_t total = team.cellStart[cellCount];
+        team.xs.resize(total);
+        team.ys.resize(total);
+        team.slots.resize(total);
+    }
+
+    entryOf.resize(count);
+    std::vector<uint32_t> cursor[2] = { teams[0].cellStart, teams[1].cellStart };
+    for (size_t i = 0; i < count; ++i) {
+        TeamBuckets& team = teams[teamOf[i]];
+        uint32_t entry = cursor[teamOf[i]][cellCoord(ys[i]) * cellsPerSide + cellCoord(xs[i])]++;
+        bool dead = balls.isDead(i);
+        team.xs[entry] = dead ? DEAD_COORD : xs[i];
+        team.ys[entry] = dead ? DEAD_COORD : ys[i];
+        team.slots[entry] = static_cast<int32_t>(i);
+        entryOf[i] = entry;
+    }
+}
+
+void SpatialGrid::moveBall(const BallStore& balls, size_t slot) {
+    TeamBuckets& team = teams[balls.isRedTeam(slot) ? 1 : 0];
+    uint32_t entry = entryOf[slot];
+    team.xs[entry] = balls.getX(slot);
+    team.ys[entry] = balls.getY(slot);
+}
+
+void SpatialGrid::markDead(const BallStore& balls, size_t slot) {
+    TeamBuckets& team = teams[balls.isRedTeam(slot) ? 1 : 0];
+    uint32_t entry = entryOf[slot];
+    if (team.xs[entry] == DEAD_COORD) return;
+    team.xs[entry] = DEAD_COORD;
+    team.ys[entry] = DEAD_COORD;
+    team.living--;
+}
+
+void SpatialGrid::scanCells(const TeamBuckets& team, int firstCell, int lastCell, int x, int y,
+    DistanceKernels::Nearest& best) const {
+    uint32_t begin = team.cellStart[firstCell];
+    uint32_t end = team.cellStart[lastCell + 1];
+    if (begin == end) return;
+
+    nearestKernel(team.xs.data() + begin, team.ys.data() + begin, team.slots.data() + begin,
+        end - begin, x, y, best);
+}
+
+int SpatialGrid::findNearestEnemy(const BallStore& balls, size_t ball) const {
+    const TeamBuckets& enemies = teams[balls.isRedTeam(ball) ? 0 : 1];
+    if (enemies.living == 0) return NONE;
+
+    // If only one enemy remains, force all to target it wherever it is
+    if (enemies.living == 1) {
+        for (size_t e = 0; e < enemies.slots.size(); ++e) {
+            if (enemies.xs[e] != DEAD_COORD) return enemies.slots[e];
+        }
+    }
+
+    int x = balls.getX(ball);
+    int y = balls.getY(ball);
+    int cx = cellCoord(x);
+    int cy = cellCoord(y);
+
+    // Anything farther than this is a parked dead ball
+    const int maxDistance = 4 * worldSize;
+
+    DistanceKernels::Nearest best;
+
+    for (int ring = 0; ; ++ring) {
+        if (ring > 0) {
+            // Closest any ball bucketed outside the rings searched so far can be.
+            // A side of the box already at the world edge has no cells beyond it.
+            int bound = INT_MAX;
+            int boxMinX = cx - ring + 1, boxMaxX = cx + ring - 1;
+            int boxMinY = cy - ring + 1, boxMaxY = cy + ring - 1;
+            if (boxMinX > 0) bound = std::min(bound, x - boxMinX * cellSize + 1);
+            if (boxMaxX < cellsPerSide - 1) bound = std::min(bound, (boxMaxX + 1) * cellSize - x);
+            if (boxMinY > 0) bound = std::min(bound, y - boxMinY * cellSize + 1);
+            if (boxMaxY < cellsPerSide - 1) bound = std::min(bound, (boxMaxY + 1) * cellSize - y);
+            if (bound == INT_MAX) break;
+
+            // Equal distances must still be scanned so the lowest slot wins ties
+            if (bound - MAX_STEP > best.distance) break;
+        }
+
+        int minX = std::max(cx - ring, 0), maxX = std::min(cx + ring, cellsPerSide - 1);
+        int minY = std::max(cy - ring, 0), maxY = std::min(cy + ring, cellsPerSide - 1);
+
+        for (int gy = minY; gy <= maxY; ++gy) {
+            int row = gy * cellsPerSide;
+            if (gy == cy - ring || gy == cy + ring) {
+                scanCells(enemies, row + minX, row + maxX, x, y, best);
+            }
+            else {
+                // Interior cells belong to earlier rings; only the side columns are new
+                if (cx - ring >= 0) scanCells(enemies, row + cx - ring, row + cx - ring, x, y, best);
+                if (cx + ring < cellsPerSide) scanCells(enemies, row + cx + ring, row + cx + ring, x, y, best);
+            }
+        }
+    }
+
+    return best.distance <= maxDistance ? best.slot : NONE;
+}
+
+int SpatialGrid::findEnemyInRange(const BallStore& balls, size_t ball, int range) const {
+    const TeamBuckets& enemies = teams[balls.isRedTeam(ball) ? 0 : 1];
+    if (enemies.living == 0) return NONE;
+
+    int x = balls.getX(ball);
+    int y = balls.getY(ball);
+
+    // Balls may have drifted out of their bucket since the rebuild
+    int reach = range + MAX_STEP;
+    int minX = cellCoord(std::max(x - reach, 0)), maxX = cellCoord(std::min(x + reach, worldSize - 1));
+    int minY = cellCoord(std::max(y - reach, 0)), maxY = cellCoord(std::min(y + reach, worldSize - 1));
+
+    // Filtering after the search is exact because the minimum is taken first
+    DistanceKernels::Nearest best;
+    for (int gy = minY; gy <= maxY; ++gy) {
+        scanCells(enemies, gy * cellsPerSide + minX, gy * cellsPerSide + maxX, x, y, best);
+    }
+    return best.distance <= range ? best.slot : NONE;
+}
@@ -0,0 +1,61 @@
+﻿#pragma once
+
+#include "BallStore.h"
+#include "DistanceKernels.h"
+#include <cstdint>
+#include <vector>
+
+// Per-team uniform bucket grid over the simulation world, stored as one
+// contiguous block of coordinates per team sorted by cell (CSR layout).
+//
+// The index is rebuilt once per tick. Balls that move afterwards have their
+// coordinates updated in place but stay in their original bucket; since a
+// ball moves at most MAX_STEP units per axis per tick, queries widen
+// their search bounds by that much and still return exact results. Ties on
+// distance go to the lowest slot, matching a linear scan over the store.
+class SpatialGrid {
+public:
+    static const int NONE = -1;
+    static const int MAX_STEP = 1;  // Largest per-axis move a ball makes between rebuilds
+
+    SpatialGrid();
+
+    // Re-buckets every ball; required whenever slots are added or compacted
+    void rebuild(const BallStore& balls, int worldSize);
+
+    // Keeps the index in sync after a ball's position changed
+    void moveBall(const BallStore& balls, size_t slot);
+    // Drops a ball that died since the last rebuild from every query
+    void markDead(const BallStore& balls, size_t slot);
+
+    // Nearest living enemy by Manhattan distance, or NONE
+    int findNearestEnemy(const BallStore& balls, size_t ball) const;
+
+    // Nearest living enemy within range, or NONE
+    int findEnemyInRange(const BallStore& balls, size_t ball, int range) const;
+
+    int getCellSize() const { return cellSize; }
+
+private:
+    struct TeamBuckets {
+        std::vector<uint32_t> cellStart;  // Entry range of cell c is [cellStart[c], cellStart[c + 1])
+        std::vector<int32_t> xs;          // Current coordinates, contiguous per cell
+        std::vector<int32_t> ys;
+        std::vector<int32_t> slots;       // Ascending within each cell
+        size_t living = 0;
+    };
+
+    int cellCoord(int worldCoord) const { return worldCoord / cellSize; }
+
+    // Scans cells [firstCell, lastCell] of one grid row, whose entries are
+    // contiguous, and folds them into the best (distance, slot) candidate
+    void scanCells(const TeamBuckets& team, int firstCell, int lastCell, int x, int y,
+        DistanceKernels::Nearest& best) const;
+
+    int worldSize;
+    int cellSize;
+    int cellsPerSide;
+    TeamBuckets teams[2];          // Indexed by team (0 = blue, 1 = red)
+    DistanceKernels::NearestFn nearestKernel;  // Widest SIMD kernel this CPU supports
+    std::vector<uint32_t> entryOf; // Per slot index into its team's entry arrays
+};
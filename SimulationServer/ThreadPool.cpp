@@ -0,0 +1,115 @@
+﻿#include "ThreadPool.h"
+#include "Tracing.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t requestedThreads)
+    : threadCount(requestedThreads ? requestedThreads : std::max(1u, std::thread::hardware_concurrency())),
+      queues(new ChunkQueue[threadCount]), jobGeneration(0), busyWorkers(0), stopping(false),
+      body(nullptr), itemCount(0), chunkSize(1) {
+    workers.reserve(threadCount - 1);
+    for (size_t i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeWorkers.notify_all();
+    for (std::thread& worker : workers) worker.join();
+}
+
+void ThreadPool::parallelFor(size_t count, size_t requestedChunkSize, const std::function<void(size_t, size_t)>& job) {
+    if (count == 0) return;
+    size_t size = std::max<size_t>(1, requestedChunkSize);
+    size_t chunks = (count + size - 1) / size;
+
+    // Nothing to share; skip waking the workers
+    if (workers.empty() || chunks == 1) {
+        for (size_t begin = 0; begin < count; begin += size) job(begin, std::min(begin + size, count));
+        return;
+    }
+
+    // Contiguous shares keep neighbouring items on one thread unless stolen
+    for (size_t t = 0; t < threadCount; ++t) {
+        uint32_t first = static_cast<uint32_t>(chunks * t / threadCount);
+        uint32_t last = static_cast<uint32_t>(chunks * (t + 1) / threadCount);
+        queues[t].range.store(pack(first, last), std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        body = &job;
+        itemCount = count;
+        chunkSize = size;
+        busyWorkers = workers.size();
+        ++jobGeneration;
+    }
+    wakeWorkers.notify_all();
+
+    runChunks(0);
+
+    // Workers may still be running chunks they claimed before the queues emptied
+    std::unique_lock<std::mutex> lock(mutex);
+    workersDone.wait(lock, [this] { return busyWorkers == 0; });
+    body = nullptr;
+}
+
+bool ThreadPool::takeOwn(size_t self, uint32_t& chunk) {
+    std::atomic<uint64_t>& range = queues[self].range;
+    uint64_t current = range.load(std::memory_order_acquire);
+    for (;;) {
+        uint32_t front = static_cast<uint32_t>(current);
+        uint32_t back = static_cast<uint32_t>(current >> 32);
+        if (front >= back) return false;
+        if (range.compare_exchange_weak(current, pack(front + 1, back), std::memory_order_acq_rel, std::memory_order_acquire)) {
+            chunk = front;
+            return true;
+        }
+    }
+}
+
+bool ThreadPool::steal(size_t self, uint32_t& chunk) {
+    for (size_t offset = 1; offset < threadCount; ++offset) {
+        std::atomic<uint64_t>& range = queues[(self + offset) % threadCount].range;
+        uint64_t current = range.load(std::memory_order_acquire);
+        for (;;) {
+            uint32_t front = static_cast<uint32_t>(current);
+            uint32_t back = static_cast<uint32_t>(current >> 32);
+            if (front >= back) break;
+            if (range.compare_exchange_weak(current, pack(front, back - 1), std::memory_order_acq_rel, std::memory_order_acquire)) {
+                chunk = back - 1;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::runChunks(size_t self) {
+    uint32_t chunk;
+    while (takeOwn(self, chunk) || steal(self, chunk)) {
+        size_t begin = static_cast<size_t>(chunk) * chunkSize;
+        (*body)(begin, std::min(begin + chunkSize, itemCount));
+    }
+}
+
+void ThreadPool::workerLoop(size_t self) {
+    Tracing::setThreadName("worker " + std::to_string(self));
+    uint64_t finishedGeneration = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeWorkers.wait(lock, [&] { return stopping || jobGeneration != finishedGeneration; });
+            if (stopping) return;
+            finishedGeneration = jobGeneration;
+        }
+
+        runChunks(self);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busyWorkers == 0) workersDone.notify_one();
+    }
+}
@@ -0,0 +1,66 @@
+﻿#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel loops. parallelFor cuts the
+// index range into chunks and deals each thread a contiguous share. A thread
+// works through its own share from the front, and once that runs dry it
+// steals chunks from the back of the others' shares, so a few expensive
+// chunks (long path searches) do not leave the rest of the pool idle. The
+// calling thread takes part as thread 0 and the call returns once every
+// chunk has run.
+class ThreadPool {
+public:
+    // Total threads including the caller; 0 picks one per hardware thread
+    explicit ThreadPool(size_t threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t getThreadCount() const { return threadCount; }
+
+    // Runs body(begin, end) over [0, count) in chunks of chunkSize items.
+    // Chunks run concurrently, so the body must only write per-item state.
+    // Call from one thread at a time.
+    void parallelFor(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)>& body);
+
+private:
+    // Chunk indices [front, back) still queued on one thread, packed into one
+    // word so the owner (taking the front) and thieves (taking the back)
+    // claim chunks with a single compare-and-swap
+    struct alignas(64) ChunkQueue {
+        std::atomic<uint64_t> range{ 0 };
+    };
+
+    static uint64_t pack(uint32_t front, uint32_t back) { return (uint64_t(back) << 32) | front; }
+
+    bool takeOwn(size_t self, uint32_t& chunk);
+    bool steal(size_t self, uint32_t& chunk);
+    void runChunks(size_t self);
+    void workerLoop(size_t self);
+
+    size_t threadCount;
+    std::unique_ptr<ChunkQueue[]> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wakeWorkers;
+    std::condition_variable workersDone;
+    uint64_t jobGeneration;  // Bumped per parallelFor; guarded by mutex
+    size_t busyWorkers;      // Workers still running the current job
+    bool stopping;
+
+    // Current job, published under mutex before workers wake
+    const std::function<void(size_t, size_t)>* body;
+    size_t itemCount;
+    size_t chunkSize;
+};
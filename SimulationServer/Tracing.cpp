@@ -0,0 +1,233 @@
+﻿#include "Tracing.h"
+#include "Log.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Tracing {
+
+namespace detail {
+std::atomic<bool> enabled(false);
+std::atomic<bool> detailed(false);  // Only ever set while enabled is
+}
+
+namespace {
+
+// Events kept per thread; a tick of a large battle records a few thousand
+const size_t BUFFER_EVENTS = 1 << 16;
+const size_t BUFFER_MASK = BUFFER_EVENTS - 1;
+
+struct Event {
+    const char* name;
+    uint64_t startNs;
+    uint64_t endNs;
+};
+
+// Single writer (the owning thread), any number of concurrent readers. The
+// writer announces a slot in `claimed` before overwriting it and in
+// `committed` once done, so a reader can tell which of the slots it copied
+// may have changed underneath it. Slot fields are relaxed atomics only to
+// make those racy reads well-defined; on x86 they are ordinary moves.
+struct ThreadBuffer {
+    struct Slot {
+        std::atomic<const char*> name{ nullptr };
+        std::atomic<uint64_t> startNs{ 0 };
+        std::atomic<uint64_t> endNs{ 0 };
+    };
+
+    std::unique_ptr<Slot[]> slots{ new Slot[BUFFER_EVENTS] };
+    std::atomic<uint64_t> claimed{ 0 };
+    std::atomic<uint64_t> committed{ 0 };
+    uint32_t threadId = 0;
+    std::string threadName;
+
+    void append(const char* name, uint64_t startNs, uint64_t endNs) {
+        uint64_t index = committed.load(std::memory_order_relaxed);
+        claimed.store(index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        Slot& slot = slots[index & BUFFER_MASK];
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.startNs.store(startNs, std::memory_order_relaxed);
+        slot.endNs.store(endNs, std::memory_order_relaxed);
+        committed.store(index + 1, std::memory_order_release);
+    }
+
+    // Copies out every event that is complete and was not overwritten mid-copy
+    void snapshot(std::vector<Event>& out) const {
+        uint64_t end = committed.load(std::memory_order_acquire);
+        uint64_t begin = end > BUFFER_EVENTS ? end - BUFFER_EVENTS : 0;
+        size_t first = out.size();
+        for (uint64_t i = begin; i < end; ++i) {
+            const Slot& slot = slots[i & BUFFER_MASK];
+            out.push_back({ slot.name.load(std::memory_order_relaxed), slot.startNs.load(std::memory_order_relaxed),
+                slot.endNs.load(std::memory_order_relaxed) });
+        }
+
+        // Slots the writer claimed meanwhile may hold a mix of old and new
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t reused = claimed.load(std::memory_order_relaxed);
+        uint64_t firstValid = reused > BUFFER_EVENTS ? reused - BUFFER_EVENTS : 0;
+        if (firstValid > begin) {
+            size_t stale = static_cast<size_t>(std::min(firstValid, end) - begin);
+            out.erase(out.begin() + first, out.begin() + first + stale);
+        }
+    }
+};
+
+// Buffers live until exit so a dump still sees threads that have finished.
+// A finished thread's buffer is handed to the next new thread, which keeps
+// appending to the same track, so short-lived threads (a thread pool per
+// battle) do not grow the registry.
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> registry;
+std::vector<ThreadBuffer*> retiredBuffers;
+uint64_t traceEpochNs = now();
+
+struct BufferLease {
+    ThreadBuffer* buffer = nullptr;
+    std::string threadName;  // Applied when the buffer is taken
+
+    ~BufferLease() {
+        if (!buffer) return;
+        std::lock_guard<std::mutex> lock(registryMutex);
+        retiredBuffers.push_back(buffer);
+    }
+};
+
+thread_local BufferLease lease;
+
+ThreadBuffer& bufferForThisThread() {
+    if (!lease.buffer) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        if (!retiredBuffers.empty()) {
+            lease.buffer = retiredBuffers.back();
+            retiredBuffers.pop_back();
+        }
+        else {
+            registry.emplace_back(new ThreadBuffer);
+            lease.buffer = registry.back().get();
+            lease.buffer->threadId = static_cast<uint32_t>(registry.size());
+        }
+        lease.buffer->threadName = lease.threadName.empty()
+            ? "thread " + std::to_string(lease.buffer->threadId) : lease.threadName;
+    }
+    return *lease.buffer;
+}
+
+std::atomic<bool> dumpRequested(false);
+std::mutex dumpPathMutex;
+std::string dumpPath;
+
+// Names are literals from TRACE_SCOPE, but escape them anyway
+void writeJsonString(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20) out << ' ';
+        else out << c;
+    }
+    out << '"';
+}
+
+}  // namespace
+
+void setEnabled(bool enabled) {
+    detail::enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool isEnabled() {
+    return detail::enabled.load(std::memory_order_relaxed);
+}
+
+void setDetailed(bool detailed) {
+    detail::detailed.store(detailed, std::memory_order_relaxed);
+}
+
+void setThreadName(const std::string& name) {
+    // The buffer is only taken once the thread records something
+    lease.threadName = name;
+    if (lease.buffer) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        lease.buffer->threadName = name;
+    }
+}
+
+void record(const char* name, uint64_t startNs, uint64_t endNs) {
+    bufferForThisThread().append(name, startNs, endNs);
+}
+
+bool writeChromeTrace(const std::string& path) {
+    std::ofstream file(path);
+    if (!file) {
+        LOG_ERROR("[Server] Cannot write trace file: {}", path);
+        return false;
+    }
+
+    // Copy the buffer list so threads can register while we format
+    std::vector<std::pair<const ThreadBuffer*, std::string>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const auto& buffer : registry) buffers.emplace_back(buffer.get(), buffer->threadName);
+    }
+
+    // Complete ("X") events with microsecond timestamps, plus one thread
+    // name record per track
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << std::fixed << std::setprecision(3);
+    bool first = true;
+    size_t eventCount = 0;
+    std::vector<Event> events;
+    for (const auto& entry : buffers) {
+        uint32_t tid = entry.first->threadId;
+        if (!first) file << ",\n";
+        first = false;
+        file << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << tid << ",\"args\":{\"name\":";
+        writeJsonString(file, entry.second);
+        file << "}}";
+
+        events.clear();
+        entry.first->snapshot(events);
+        for (const Event& event : events) {
+            file << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << tid << ",\"name\":";
+            writeJsonString(file, event.name ? event.name : "");
+            file << ",\"ts\":" << (event.startNs - traceEpochNs) / 1000.0
+                << ",\"dur\":" << (event.endNs - event.startNs) / 1000.0 << "}";
+        }
+        eventCount += events.size();
+    }
+    file << "\n]}\n";
+
+    if (!file) {
+        LOG_ERROR("[Server] Failed writing trace file: {}", path);
+        return false;
+    }
+    LOG_INFO("[Server] Wrote {} trace events from {} threads to {}", eventCount, buffers.size(), path);
+    return true;
+}
+
+void requestDump() {
+    dumpRequested.store(true, std::memory_order_relaxed);
+}
+
+void setDumpPath(const std::string& path) {
+    std::lock_guard<std::mutex> lock(dumpPathMutex);
+    dumpPath = path;
+}
+
+void dumpIfRequested() {
+    if (!dumpRequested.load(std::memory_order_relaxed)) return;
+    dumpRequested.store(false, std::memory_order_relaxed);
+
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(dumpPathMutex);
+        path = dumpPath;
+    }
+    if (!path.empty()) writeChromeTrace(path);
+}
+
+}  // namespace Tracing
@@ -0,0 +1,84 @@
+﻿#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Scoped timing events for profiling ticks. Each thread appends completed
+// events to its own fixed-size ring buffer with plain stores and no locks,
+// overwriting its oldest events once full, and a dump copies every thread's
+// buffer into a Chrome trace (JSON, opened in chrome://tracing or Perfetto)
+// while the threads keep running.
+//
+// Build with SIMULATION_TRACING=0 (CMake option SIMULATION_ENABLE_TRACING)
+// and the macros compile to nothing. When compiled in, recording is off
+// until setEnabled(true), and a disabled scope costs one relaxed load.
+//
+// TRACE_SCOPE marks phases that run a few times per tick. TRACE_DETAIL_SCOPE
+// marks finer work, such as one path search or one worker's chunk of balls,
+// which can be short enough that reading the clock twice shows up in the
+// tick time; those are only recorded once setDetailed(true) as well.
+namespace Tracing {
+
+void setEnabled(bool enabled);
+bool isEnabled();
+void setDetailed(bool detailed);
+
+// Label for the calling thread's track in the trace
+void setThreadName(const std::string& name);
+
+// Writes the buffered events of every thread that has recorded any. Safe to
+// call while other threads record; events overwritten during the copy are
+// left out. Prints the reason and returns false on failure.
+bool writeChromeTrace(const std::string& path);
+
+// Async-signal-safe: asks for a dump to the given path at the next
+// dumpIfRequested, which a long-running thread calls regularly
+void requestDump();
+void setDumpPath(const std::string& path);
+void dumpIfRequested();
+
+// Nanoseconds on the steady clock
+inline uint64_t now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Appends one completed event to the calling thread's buffer. name must
+// outlive the trace; string literals are expected.
+void record(const char* name, uint64_t startNs, uint64_t endNs);
+
+namespace detail {
+extern std::atomic<bool> enabled;
+extern std::atomic<bool> detailed;
+}
+
+// Records the time from construction to destruction as one event
+class Scope {
+public:
+    Scope(const char* eventName, const std::atomic<bool>& active = detail::enabled)
+        : name(eventName), start(active.load(std::memory_order_relaxed) ? now() : 0) {}
+    ~Scope() {
+        if (start != 0) record(name, start, now());
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char* name;
+    uint64_t start;  // 0 when tracing was off at construction
+};
+
+}  // namespace Tracing
+
+#if SIMULATION_TRACING
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) Tracing::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_DETAIL_SCOPE(name) Tracing::Scope TRACE_CONCAT(traceScope, __LINE__)(name, Tracing::detail::detailed)
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_DETAIL_SCOPE(name) ((void)0)
+#endif
@@ -0,0 +1,47 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Hands the newest value from one writer thread to one reader thread without
+// locks. The writer fills its private slot and publishes it; the reader picks
+// up the most recently published slot. A third slot sits between them, so
+// neither side ever waits for the other and the reader never sees a value
+// that is still being written. Values published while the reader is busy are
+// overwritten by later ones; only the newest is delivered.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : shared(1), writeIndex(0), readIndex(2) {}
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Writer side: the slot to fill, then publish it. The slot handed back
+    // afterwards holds an older value to be overwritten.
+    T& writeSlot() { return slots[writeIndex]; }
+    void publish() {
+        uint8_t previous = shared.exchange(static_cast<uint8_t>(writeIndex | FRESH), std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+    }
+
+    // Reader side: switches to the newest published value if there is one.
+    // Returns false if nothing was published since the last call.
+    bool acquire() {
+        if ((shared.load(std::memory_order_acquire) & FRESH) == 0) return false;
+        uint8_t previous = shared.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & INDEX_MASK;
+        return true;
+    }
+    // Stays valid and unchanged until the next acquire
+    const T& readSlot() const { return slots[readIndex]; }
+
+private:
+    static const uint8_t INDEX_MASK = 0x3;
+    static const uint8_t FRESH = 0x4;  // Set on the shared index until the reader takes it
+
+    T slots[3];
+    std::atomic<uint8_t> shared;  // Slot between the two sides, plus FRESH
+    uint8_t writeIndex;           // Owned by the writer
+    uint8_t readIndex;            // Owned by the reader
+};
@@ -0,0 +1,251 @@
+﻿#include "UdpTransport.h"
+#include "Log.h"
+#include <SnapshotProtocol/DatagramAssembler.h>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+uint64_t addressKey(const sockaddr_in& address) {
+    return (static_cast<uint64_t>(ntohl(address.sin_addr.s_addr)) << 16) | ntohs(address.sin_port);
+}
+
+void appendU16(std::string& out, uint16_t value) {
+    out.push_back(static_cast<char>(value & 0xFF));
+    out.push_back(static_cast<char>(value >> 8));
+}
+
+void appendU32(std::string& out, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) out.push_back(static_cast<char>((value >> shift) & 0xFF));
+}
+
+}  // namespace
+
+UdpTransport::UdpTransport(const GameConfig& gameConfig)
+    : config(gameConfig), socket(SocketPlatform::InvalidSocket), lastSequence(0), lossRandom(1) {}
+
+UdpTransport::~UdpTransport() {
+    close();
+}
+
+bool UdpTransport::open() {
+    socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (socket == SocketPlatform::InvalidSocket) {
+        LOG_ERROR("[Server] Failed to create UDP socket.");
+        return false;
+    }
+
+    // Room for a keyframe's worth of datagrams before the kernel starts dropping them
+    int bufferSize = 4 << 20;
+    setsockopt(socket, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&bufferSize), sizeof(bufferSize));
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(config.udpPort));
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (bind(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        !SocketPlatform::setNonBlocking(socket)) {
+        LOG_ERROR("[Server] UDP bind to port {} failed.", config.udpPort);
+        close();
+        return false;
+    }
+
+    LOG_INFO("[Server] Serving snapshots over UDP on port {}", config.udpPort);
+    if (config.udpLossPercent > 0 || config.udpLatencyMs > 0) {
+        LOG_INFO("[Server] Simulating {}% UDP loss and {} ms latency", config.udpLossPercent, config.udpLatencyMs);
+    }
+    return true;
+}
+
+void UdpTransport::close() {
+    if (socket == SocketPlatform::InvalidSocket) return;
+    SocketPlatform::closeSocket(socket);
+    socket = SocketPlatform::InvalidSocket;
+    clients.clear();
+}
+
+void UdpTransport::receive() {
+    uint8_t buffer[SnapshotProtocol::MAX_DATAGRAM_SIZE];
+    while (true) {
+        sockaddr_in from;
+        SocketPlatform::AddressLength fromLength = sizeof(from);
+        int received = recvfrom(socket, reinterpret_cast<char*>(buffer), sizeof(buffer), 0,
+            reinterpret_cast<sockaddr*>(&from), &fromLength);
+        if (received < 0) {
+            // Windows reports an ICMP port unreachable from a closed client here; carry on
+            if (SocketPlatform::lastErrorWouldBlock()) break;
+            continue;
+        }
+        if (simulateLoss()) continue;
+
+        if (config.udpLatencyMs > 0) {
+            delayedIn.push_back({ Clock::now() + std::chrono::milliseconds(config.udpLatencyMs), from,
+                std::string(reinterpret_cast<const char*>(buffer), static_cast<size_t>(received)) });
+            continue;
+        }
+        handleDatagram(from, buffer, static_cast<size_t>(received));
+    }
+}
+
+void UdpTransport::handleDatagram(const sockaddr_in& from, const uint8_t* data, size_t size) {
+    SnapshotProtocol::DatagramHeader header;
+    if (!SnapshotProtocol::parseDatagramHeader(data, size, header) || header.kind != SnapshotProtocol::DatagramKind::Ack) {
+        return;
+    }
+
+    auto found = clients.find(addressKey(from));
+    if (found == clients.end()) {
+        found = clients.emplace(addressKey(from), Client()).first;
+        found->second.address = from;
+        LOG_INFO("[Server] UDP client joined. ({} over UDP)", clients.size());
+    }
+
+    Client& client = found->second;
+    client.lastHeard = Clock::now();
+    // Acks can arrive out of order; only the newest matters. Never trust one
+    // for a snapshot that was not sent yet.
+    if (header.sequence > client.ackedSequence && header.sequence <= lastSequence) {
+        client.ackedSequence = header.sequence;
+    }
+}
+
+void UdpTransport::dropSilentClients() {
+    Clock::time_point cutoff = Clock::now() - std::chrono::milliseconds(CLIENT_TIMEOUT_MS);
+    for (auto it = clients.begin(); it != clients.end();) {
+        if (it->second.lastHeard < cutoff) {
+            it = clients.erase(it);
+            LOG_INFO("[Server] UDP client timed out. ({} over UDP)", clients.size());
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+const UdpTransport::Baseline* UdpTransport::findBaseline(uint32_t sequence) const {
+    if (sequence == 0 || history.empty() || sequence < history.front().sequence) return nullptr;
+    // Sequences in the history are consecutive
+    size_t index = sequence - history.front().sequence;
+    return index < history.size() ? &history[index] : nullptr;
+}
+
+void UdpTransport::sendSnapshot(const SnapshotProtocol::SimulationSnapshot& state, int gridSize) {
+    dropSilentClients();
+
+    // Every snapshot becomes a baseline, whether or not anyone is listening
+    Baseline next;
+    if (history.size() == HISTORY_SIZE) {
+        next = std::move(history.front());
+        history.pop_front();
+    }
+    next.sequence = ++lastSequence;
+    next.units.assign(state.units.begin(), state.units.end());
+    history.push_back(std::move(next));
+    if (clients.empty()) return;
+
+    // Clients that acked the same snapshot share one encoding
+    encoded.clear();
+    for (auto& entry : clients) {
+        Client& client = entry.second;
+        const Baseline* baseline = findBaseline(client.ackedSequence);
+        uint32_t baseSequence = baseline ? baseline->sequence : 0;
+
+        auto found = std::find_if(encoded.begin(), encoded.end(),
+            [baseSequence](const std::pair<uint32_t, std::string>& payload) { return payload.first == baseSequence; });
+        if (found == encoded.end()) {
+            encoded.emplace_back(baseSequence, std::string());
+            found = encoded.end() - 1;
+            if (baseline) {
+                SnapshotProtocol::diffUnits(baseline->units, state.units, state.tick, changes);
+                SnapshotProtocol::encodeDelta(found->second, changes);
+            }
+            else {
+                SnapshotProtocol::encodeKeyframe(found->second, state.tick, gridSize, state.units);
+            }
+        }
+
+        const std::string& frame = found->second;
+        sendPayload(client.address, lastSequence, baseSequence, frame.data() + SnapshotProtocol::FRAME_PREFIX_SIZE,
+            frame.size() - SnapshotProtocol::FRAME_PREFIX_SIZE);
+    }
+}
+
+void UdpTransport::sendGameOver(uint32_t tick, const std::string& message) {
+    std::string frame;
+    SnapshotProtocol::encodeGameOver(frame, tick, message);
+    uint32_t sequence = ++lastSequence;
+    for (int repeat = 0; repeat < GAME_OVER_REPEATS; ++repeat) {
+        for (const auto& entry : clients) {
+            sendPayload(entry.second.address, sequence, 0, frame.data() + SnapshotProtocol::FRAME_PREFIX_SIZE,
+                frame.size() - SnapshotProtocol::FRAME_PREFIX_SIZE);
+        }
+    }
+}
+
+void UdpTransport::sendPayload(const sockaddr_in& to, uint32_t sequence, uint32_t baseSequence, const char* payload,
+    size_t size) {
+    size_t count = (size + SnapshotProtocol::MAX_FRAGMENT_PAYLOAD - 1) / SnapshotProtocol::MAX_FRAGMENT_PAYLOAD;
+    if (count > 0xFFFF) {
+        LOG_WARNING("[Server] Snapshot {} is {} bytes, too big for UDP; not sent", sequence, size);
+        return;
+    }
+
+    for (size_t index = 0; index < count; ++index) {
+        size_t offset = index * SnapshotProtocol::MAX_FRAGMENT_PAYLOAD;
+        size_t slice = std::min(SnapshotProtocol::MAX_FRAGMENT_PAYLOAD, size - offset);
+
+        datagram.clear();
+        appendU16(datagram, SnapshotProtocol::MAGIC);
+        datagram.push_back(static_cast<char>(SnapshotProtocol::VERSION));
+        datagram.push_back(static_cast<char>(SnapshotProtocol::DatagramKind::Fragment));
+        appendU32(datagram, sequence);
+        appendU32(datagram, baseSequence);
+        appendU16(datagram, static_cast<uint16_t>(index));
+        appendU16(datagram, static_cast<uint16_t>(count));
+        datagram.append(payload + offset, slice);
+        sendDatagram(to, datagram.data(), datagram.size());
+    }
+}
+
+void UdpTransport::sendDatagram(const sockaddr_in& to, const char* data, size_t size) {
+    if (simulateLoss()) return;
+    if (config.udpLatencyMs > 0) {
+        delayedOut.push_back({ Clock::now() + std::chrono::milliseconds(config.udpLatencyMs), to, std::string(data, size) });
+        return;
+    }
+
+    // A full send buffer drops the datagram like the network would; the next snapshot supersedes it
+    sendto(socket, data, static_cast<int>(size), 0, reinterpret_cast<const sockaddr*>(&to), sizeof(to));
+}
+
+bool UdpTransport::simulateLoss() {
+    if (config.udpLossPercent <= 0) return false;
+    return static_cast<int>(lossRandom() % 100) < config.udpLossPercent;
+}
+
+void UdpTransport::flushDelayed() {
+    Clock::time_point now = Clock::now();
+    while (!delayedOut.empty() && delayedOut.front().due <= now) {
+        const DelayedDatagram& pending = delayedOut.front();
+        sendto(socket, pending.bytes.data(), static_cast<int>(pending.bytes.size()), 0,
+            reinterpret_cast<const sockaddr*>(&pending.address), sizeof(pending.address));
+        delayedOut.pop_front();
+    }
+    while (!delayedIn.empty() && delayedIn.front().due <= now) {
+        const DelayedDatagram& pending = delayedIn.front();
+        handleDatagram(pending.address, reinterpret_cast<const uint8_t*>(pending.bytes.data()), pending.bytes.size());
+        delayedIn.pop_front();
+    }
+}
+
+int UdpTransport::pollTimeout(int timeoutMs) const {
+    Clock::time_point now = Clock::now();
+    for (const auto* queue : { &delayedOut, &delayedIn }) {
+        if (queue->empty()) continue;
+        auto untilDue = std::chrono::ceil<std::chrono::milliseconds>(queue->front().due - now).count();
+        timeoutMs = std::min(timeoutMs, static_cast<int>(std::max<decltype(untilDue)>(untilDue, 0)));
+    }
+    return timeoutMs;
+}
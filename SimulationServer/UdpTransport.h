@@ -0,0 +1,96 @@
+﻿#pragma once
+
+#include "SocketPlatform.h"
+#include "GameConfig.h"
+#include "SnapshotProtocol.h"
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Serves snapshots over UDP next to the TCP stream, to clients that would
+// rather lose a frame than wait for it. Each snapshot gets a sequence number
+// and is a delta against the newest one the client acknowledged, or a
+// keyframe when that one is too old or there is none; nothing is resent.
+// Payloads are split into datagrams as WireFormat.h describes.
+//
+// Runs on the network thread. For testing over loopback it can drop a share
+// of datagrams and delay the rest, both ways (udp-loss-percent, udp-latency-ms).
+class UdpTransport {
+public:
+    explicit UdpTransport(const GameConfig& config);
+    ~UdpTransport();
+
+    // Binds udp-port; prints the reason and returns false on failure
+    bool open();
+    void close();
+    SocketPlatform::SocketHandle getSocket() const { return socket; }
+
+    // Reads every pending datagram: acks, and joins from new addresses
+    void receive();
+    // Sends state to every client, each against the snapshot it acknowledged
+    void sendSnapshot(const SnapshotProtocol::SimulationSnapshot& state, int gridSize);
+    // Sends the GameOver message a few times, since any datagram can be lost
+    void sendGameOver(uint32_t tick, const std::string& message);
+
+    // Passes on datagrams held back by simulated latency once they are due
+    void flushDelayed();
+    // timeoutMs, or less if a delayed datagram falls due sooner
+    int pollTimeout(int timeoutMs) const;
+    bool hasDelayed() const { return !delayedOut.empty() || !delayedIn.empty(); }
+
+    size_t getClientCount() const { return clients.size(); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Client {
+        sockaddr_in address;
+        uint32_t ackedSequence = 0;  // Newest snapshot it decoded; 0 for none
+        Clock::time_point lastHeard;
+    };
+
+    // A snapshot as sent, kept so later deltas can be taken against it
+    struct Baseline {
+        uint32_t sequence = 0;
+        std::vector<SnapshotProtocol::UnitRecord> units;
+    };
+
+    struct DelayedDatagram {
+        Clock::time_point due;
+        sockaddr_in address;
+        std::string bytes;
+    };
+
+    // Snapshots kept as baselines; clients acking anything older get keyframes
+    static constexpr size_t HISTORY_SIZE = 64;
+    static constexpr int CLIENT_TIMEOUT_MS = 5000;
+    static constexpr int GAME_OVER_REPEATS = 3;
+
+    void handleDatagram(const sockaddr_in& from, const uint8_t* data, size_t size);
+    void dropSilentClients();
+    const Baseline* findBaseline(uint32_t sequence) const;
+    // Splits payload (a frame without its length prefix) into datagrams
+    void sendPayload(const sockaddr_in& to, uint32_t sequence, uint32_t baseSequence, const char* payload,
+        size_t size);
+    void sendDatagram(const sockaddr_in& to, const char* data, size_t size);
+    bool simulateLoss();
+
+    GameConfig config;
+    SocketPlatform::SocketHandle socket;
+    std::unordered_map<uint64_t, Client> clients;  // By IPv4 address and port
+    std::deque<Baseline> history;                  // Oldest first
+    uint32_t lastSequence;
+
+    // Scratch, reused across snapshots
+    SnapshotProtocol::SimulationSnapshot changes;
+    std::vector<std::pair<uint32_t, std::string>> encoded;  // Payload per base sequence this snapshot
+    std::string datagram;
+
+    std::minstd_rand lossRandom;
+    std::deque<DelayedDatagram> delayedOut;  // Due in order, since every one gets the same delay
+    std::deque<DelayedDatagram> delayedIn;
+};
@@ -0,0 +1,52 @@
+﻿#include "ViewportIndex.h"
+#include <algorithm>
+
+ViewportIndex::ViewportIndex() : indexed(nullptr), cellShift(MIN_CELL_SHIFT), bucketsPerRow(1) {}
+
+void ViewportIndex::rebuild(const std::vector<SnapshotProtocol::UnitRecord>& units, int worldSize) {
+    indexed = &units;
+    cellShift = MIN_CELL_SHIFT;
+    while (((worldSize - 1) >> cellShift) + 1 > MAX_BUCKETS_PER_ROW) ++cellShift;
+    bucketsPerRow = ((worldSize - 1) >> cellShift) + 1;
+
+    // Counting sort by bucket; walking units in order keeps each bucket in list order
+    const size_t bucketCount = static_cast<size_t>(bucketsPerRow) * bucketsPerRow;
+    bucketStarts.assign(bucketCount + 1, 0);
+    for (const SnapshotProtocol::UnitRecord& unit : units) {
+        ++bucketStarts[static_cast<size_t>(unit.y >> cellShift) * bucketsPerRow + (unit.x >> cellShift) + 1];
+    }
+    for (size_t b = 0; b < bucketCount; ++b) bucketStarts[b + 1] += bucketStarts[b];
+
+    entries.resize(units.size());
+    std::vector<uint32_t>& next = matches;
+    next.assign(bucketStarts.begin(), bucketStarts.end() - 1);
+    for (size_t i = 0; i < units.size(); ++i) {
+        size_t bucket = static_cast<size_t>(units[i].y >> cellShift) * bucketsPerRow + (units[i].x >> cellShift);
+        entries[next[bucket]++] = static_cast<uint32_t>(i);
+    }
+}
+
+void ViewportIndex::query(int minX, int minY, int maxX, int maxY, std::vector<SnapshotProtocol::UnitRecord>& out) {
+    out.clear();
+    matches.clear();
+    if (!indexed || maxX < 0 || maxY < 0 || minX > maxX || minY > maxY) return;
+
+    const int lastBucket = bucketsPerRow - 1;
+    int bx0 = std::max(minX, 0) >> cellShift, by0 = std::max(minY, 0) >> cellShift;
+    int bx1 = std::min(maxX >> cellShift, lastBucket), by1 = std::min(maxY >> cellShift, lastBucket);
+    for (int by = by0; by <= by1; ++by) {
+        for (int bx = bx0; bx <= bx1; ++bx) {
+            size_t bucket = static_cast<size_t>(by) * bucketsPerRow + bx;
+            for (uint32_t e = bucketStarts[bucket]; e < bucketStarts[bucket + 1]; ++e) {
+                const SnapshotProtocol::UnitRecord& unit = (*indexed)[entries[e]];
+                // Edge buckets stick out of the rectangle
+                if (unit.x >= minX && unit.x <= maxX && unit.y >= minY && unit.y <= maxY) matches.push_back(entries[e]);
+            }
+        }
+    }
+
+    // Buckets are each in order; merging them back costs a sort of the matches only
+    std::sort(matches.begin(), matches.end());
+    out.reserve(matches.size());
+    for (uint32_t index : matches) out.push_back((*indexed)[index]);
+}
@@ -0,0 +1,36 @@
+﻿#pragma once
+
+#include "SnapshotProtocol.h"
+#include <cstdint>
+#include <vector>
+
+// Bucket grid over one published state, for answering many rectangle
+// queries per frame. Unit indices are stored sorted by bucket in one array
+// (CSR layout), so a query touches only the buckets it overlaps and the
+// units inside them: O(visible) per viewport after an O(units) rebuild.
+class ViewportIndex {
+public:
+    ViewportIndex();
+
+    // Re-buckets units, which must stay alive and unchanged until the next rebuild
+    void rebuild(const std::vector<SnapshotProtocol::UnitRecord>& units, int worldSize);
+
+    // Replaces out with the units inside the inclusive rectangle, in the
+    // order they appear in the indexed list
+    void query(int minX, int minY, int maxX, int maxY, std::vector<SnapshotProtocol::UnitRecord>& out);
+
+    int getCellSize() const { return 1 << cellShift; }
+
+private:
+    // Buckets are at least this many cells wide, and the grid has at most
+    // MAX_BUCKETS_PER_ROW of them per row so the table stays small on huge maps
+    static const int MIN_CELL_SHIFT = 3;
+    static const int MAX_BUCKETS_PER_ROW = 256;
+
+    const std::vector<SnapshotProtocol::UnitRecord>* indexed;
+    int cellShift;
+    int bucketsPerRow;
+    std::vector<uint32_t> bucketStarts;  // bucketsPerRow^2 + 1 offsets into entries
+    std::vector<uint32_t> entries;       // Unit indices, bucket by bucket
+    std::vector<uint32_t> matches;       // Query scratch
+};
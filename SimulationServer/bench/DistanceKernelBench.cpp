@@ -0,0 +1,101 @@
+﻿#include "DistanceKernels.h"
+#include <algorithm>
+#include <chrono>
+#include <initializer_list>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Times every distance kernel the CPU supports on blocks of random coordinates
+// and checks that each one agrees with the scalar kernel on every query.
+
+using DistanceKernels::Isa;
+
+namespace {
+
+struct Block {
+    std::vector<int32_t> xs;
+    std::vector<int32_t> ys;
+    std::vector<int32_t> slots;
+};
+
+Block makeBlock(size_t count, int worldSize, std::mt19937& rng) {
+    std::uniform_int_distribution<int32_t> coord(0, worldSize - 1);
+    Block block;
+    for (size_t i = 0; i < count; ++i) {
+        block.xs.push_back(coord(rng));
+        block.ys.push_back(coord(rng));
+        block.slots.push_back(static_cast<int32_t>(i));
+    }
+    // Shuffle slots so lane order and slot order disagree, exercising tie-breaks
+    std::shuffle(block.slots.begin(), block.slots.end(), rng);
+    return block;
+}
+
+}  // namespace
+
+int main() {
+    const int worldSize = 100;  // Small world so equal distances are common
+    const size_t blockSizes[] = { 7, 16, 64, 256, 4096 };
+    const size_t queriesPerBlock = 256;
+    const size_t targetEntries = 200000000;
+
+    std::printf("Selected kernel: %s\n", DistanceKernels::isaName(DistanceKernels::detectIsa()));
+    std::printf("%-8s %-8s %12s %10s\n", "block", "isa", "ns/entry", "speedup");
+
+    std::mt19937 rng(42);
+    bool mismatch = false;
+
+    for (size_t blockSize : blockSizes) {
+        Block block = makeBlock(blockSize, worldSize, rng);
+        std::vector<std::pair<int32_t, int32_t>> queries;
+        std::uniform_int_distribution<int32_t> coord(0, worldSize - 1);
+        for (size_t q = 0; q < queriesPerBlock; ++q) queries.emplace_back(coord(rng), coord(rng));
+
+        std::vector<DistanceKernels::Nearest> expected(queriesPerBlock);
+        for (size_t q = 0; q < queriesPerBlock; ++q) {
+            DistanceKernels::nearestScalar(block.xs.data(), block.ys.data(), block.slots.data(), blockSize,
+                queries[q].first, queries[q].second, expected[q]);
+        }
+
+        size_t rounds = std::max<size_t>(1, targetEntries / (blockSize * queriesPerBlock));
+        double scalarNs = 0.0;
+
+        for (Isa isa : { Isa::Scalar, Isa::SSE2, Isa::AVX2, Isa::AVX512 }) {
+            DistanceKernels::NearestFn kernel = DistanceKernels::kernelFor(isa);
+            if (!kernel) {
+                std::printf("%-8zu %-8s %12s %10s\n", blockSize, DistanceKernels::isaName(isa), "n/a", "-");
+                continue;
+            }
+
+            for (size_t q = 0; q < queriesPerBlock; ++q) {
+                DistanceKernels::Nearest result;
+                kernel(block.xs.data(), block.ys.data(), block.slots.data(), blockSize,
+                    queries[q].first, queries[q].second, result);
+                if (result.distance != expected[q].distance || result.slot != expected[q].slot) {
+                    std::printf("MISMATCH: %s block %zu query %zu\n", DistanceKernels::isaName(isa), blockSize, q);
+                    mismatch = true;
+                }
+            }
+
+            int64_t checksum = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (size_t r = 0; r < rounds; ++r) {
+                for (const auto& query : queries) {
+                    DistanceKernels::Nearest result;
+                    kernel(block.xs.data(), block.ys.data(), block.slots.data(), blockSize,
+                        query.first, query.second, result);
+                    checksum += result.slot;
+                }
+            }
+            auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+            double nsPerEntry = elapsed / (static_cast<double>(rounds) * queriesPerBlock * blockSize);
+            if (isa == Isa::Scalar) scalarNs = nsPerEntry;
+            std::printf("%-8zu %-8s %12.3f %9.2fx   (checksum %lld)\n", blockSize, DistanceKernels::isaName(isa),
+                nsPerEntry, scalarNs / nsPerEntry, static_cast<long long>(checksum));
+        }
+    }
+
+    return mismatch ? 1 : 0;
+}
@@ -0,0 +1,135 @@
+﻿#include "JumpTable.h"
+#include "ObstacleMap.h"
+#include "Pathfinding.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Runs the same queries through the path searches twice per grid size: once
+// with the power-of-two kernels GridIndex.h dispatches to, once forced onto
+// the runtime-width kernels. Whole-map searches on the 100 grid take the
+// runtime path either way and serve as a control. Windowed A* on 32- and
+// 64-wide windows is what HPA* refinement runs, and is specialized on every
+// grid. Fails if the two kernels ever return different paths.
+
+namespace {
+
+const int BLOCKED_PERCENT = 20;
+const int QUERIES = 1000;
+const int QUERY_RADIUS = 48;  // Keeps query cost comparable across grid sizes
+
+ObstacleMap randomMap(int size, std::mt19937& rng) {
+    ObstacleMap map(size, size);
+    std::uniform_int_distribution<int> percent(0, 99);
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            if (percent(rng) < BLOCKED_PERCENT) map.setBlocked(x, y, true);
+        }
+    }
+    return map;
+}
+
+struct Query {
+    int fromX, fromY, toX, toY;
+    int windowX, windowY;  // Origin of the search window; 0 for whole-map searches
+};
+
+// Endpoints within QUERY_RADIUS of each other anywhere on the map
+std::vector<Query> pointQueries(const ObstacleMap& map, std::mt19937& rng) {
+    int size = map.getWidth();
+    std::uniform_int_distribution<int> coord(0, size - 1);
+    std::uniform_int_distribution<int> offset(-QUERY_RADIUS, QUERY_RADIUS);
+    std::vector<Query> queries;
+    while (queries.size() < static_cast<size_t>(QUERIES)) {
+        Query q;
+        q.fromX = coord(rng);
+        q.fromY = coord(rng);
+        q.toX = std::clamp(q.fromX + offset(rng), 0, size - 1);
+        q.toY = std::clamp(q.fromY + offset(rng), 0, size - 1);
+        q.windowX = q.windowY = 0;
+        if (map.isOpen(q.fromX, q.fromY) && map.isOpen(q.toX, q.toY)) queries.push_back(q);
+    }
+    return queries;
+}
+
+// Both endpoints inside a randomly placed window, like an HPA* refinement
+std::vector<Query> windowQueries(const ObstacleMap& map, int windowSize, std::mt19937& rng) {
+    std::uniform_int_distribution<int> windowCoord(0, map.getWidth() - windowSize);
+    std::uniform_int_distribution<int> inWindow(0, windowSize - 1);
+    std::vector<Query> queries;
+    while (queries.size() < static_cast<size_t>(QUERIES)) {
+        Query q;
+        q.windowX = windowCoord(rng);
+        q.windowY = windowCoord(rng);
+        q.fromX = q.windowX + inWindow(rng);
+        q.fromY = q.windowY + inWindow(rng);
+        q.toX = q.windowX + inWindow(rng);
+        q.toY = q.windowY + inWindow(rng);
+        if (map.isOpen(q.fromX, q.fromY) && map.isOpen(q.toX, q.toY)) queries.push_back(q);
+    }
+    return queries;
+}
+
+enum Search { AStar, JumpPoint, Window32, Window64, SEARCH_COUNT };
+const char* SEARCH_NAMES[SEARCH_COUNT] = { "A*", "JPS", "window 32", "window 64" };
+
+}  // namespace
+
+int main() {
+    std::mt19937 rng(15);
+    const int sizes[] = { 100, 128, 256, 512, 1024 };
+
+    std::printf("%-6s %-10s %14s %14s %8s\n", "grid", "search", "runtime us/q", "pow2 us/q", "speedup");
+    bool mismatch = false;
+
+    for (int size : sizes) {
+        ObstacleMap map = randomMap(size, rng);
+        JumpTable jumps;
+        jumps.build(map);
+
+        std::vector<Query> points = pointQueries(map, rng);
+        std::vector<Query> windows32 = windowQueries(map, 32, rng);
+        std::vector<Query> windows64 = windowQueries(map, 64, rng);
+
+        PathWorkspace workspace;
+        for (int search = 0; search < SEARCH_COUNT; ++search) {
+            int windowSize = search == Window32 ? 32 : 64;
+            const std::vector<Query>& batch = search == Window32 ? windows32 : search == Window64 ? windows64 : points;
+
+            std::vector<std::vector<std::pair<int, int>>> paths[2];
+            // Two warm-up rounds, then each kernel twice in ABBA order so
+            // drift over the run does not favour either
+            const int order[] = { 0, 1, 1, 0, 0, 1 };
+            double micros[2] = { 0, 0 };
+            for (int round = 0; round < 6; ++round) {
+                int specialized = order[round];
+                workspace.setSpecializedKernels(specialized == 1);
+                paths[specialized].clear();
+                paths[specialized].reserve(batch.size());
+                auto start = std::chrono::steady_clock::now();
+                for (const Query& q : batch) {
+                    if (search == AStar) {
+                        paths[specialized].push_back(workspace.findPath(map, q.fromX, q.fromY, q.toX, q.toY));
+                    }
+                    else if (search == JumpPoint) {
+                        paths[specialized].push_back(workspace.findJumpPointPath(jumps, q.fromX, q.fromY, q.toX, q.toY));
+                    }
+                    else {
+                        paths[specialized].push_back(workspace.findPathInWindow(map, q.windowX, q.windowY,
+                            windowSize, windowSize, q.fromX, q.fromY, q.toX, q.toY));
+                    }
+                }
+                double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+                if (round >= 2) micros[specialized] += elapsed / (2 * batch.size());
+            }
+            if (paths[0] != paths[1]) mismatch = true;
+
+            std::printf("%-6d %-10s %14.2f %14.2f %7.2fx\n", size, SEARCH_NAMES[search], micros[0], micros[1], micros[0] / micros[1]);
+        }
+    }
+
+    if (mismatch) std::printf("MISMATCH: specialized and runtime kernels returned different paths\n");
+    return mismatch ? 1 : 0;
+}
@@ -0,0 +1,144 @@
+﻿#include "HierarchicalPathfinder.h"
+#include "JumpTable.h"
+#include "ObstacleMap.h"
+#include "Pathfinding.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// HPA* on maps far beyond the default grid: build time, memory, the latency
+// a unit sees before its first step (abstract route plus one refined
+// segment) and the cost of refining the whole route, against flat JPS where
+// its tables still fit in memory. Ends with the cost of a single-cell edit,
+// which only rebuilds the clusters around it.
+
+namespace {
+
+const int QUERIES = 200;
+const int EDITS = 2000;
+const size_t FLAT_LIMIT_CELLS = size_t(4096) * 4096;
+
+using Clock = std::chrono::steady_clock;
+
+double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Scattered rectangular buildings covering roughly a fifth of the map
+ObstacleMap buildingsMap(int size, std::mt19937& rng) {
+    ObstacleMap map(size, size);
+    std::uniform_int_distribution<int> coord(0, size - 1);
+    std::uniform_int_distribution<int> extent(2, 24);
+    size_t buildings = static_cast<size_t>(size) * size / 900;
+    for (size_t b = 0; b < buildings; ++b) {
+        int x0 = coord(rng);
+        int y0 = coord(rng);
+        int w = extent(rng);
+        int h = extent(rng);
+        for (int y = y0; y < y0 + h && y < size; ++y) {
+            for (int x = x0; x < x0 + w && x < size; ++x) map.setBlocked(x, y, true);
+        }
+    }
+    return map;
+}
+
+// Flat JPS keeps the map twice (caller and table copy), eight int32 tables
+// and a 16-byte-per-cell search workspace
+size_t flatMemoryBytes(const ObstacleMap& map) {
+    size_t cells = static_cast<size_t>(map.getWidth()) * map.getHeight();
+    return 2 * map.getMemoryBytes() + cells * (8 * sizeof(int32_t) + 16);
+}
+
+// Refinement searches at most two clusters side by side
+size_t windowWorkspaceBytes(int clusterSize) {
+    return size_t(2) * clusterSize * clusterSize * 16;
+}
+
+double megabytes(size_t bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+}  // namespace
+
+int main() {
+    std::mt19937 rng(17);
+    std::printf("%-7s %-5s %9s %10s %12s %12s %10s\n",
+        "map", "plan", "build ms", "memory MB", "first us", "full us", "path len");
+
+    for (int size : { 1024, 4096, 16384 }) {
+        ObstacleMap map = buildingsMap(size, rng);
+
+        std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> queries;
+        std::uniform_int_distribution<int> coord(0, size - 1);
+        while (queries.size() < static_cast<size_t>(QUERIES)) {
+            std::pair<int, int> from(coord(rng), coord(rng));
+            std::pair<int, int> to(coord(rng), coord(rng));
+            if (map.isOpen(from.first, from.second) && map.isOpen(to.first, to.second)) queries.push_back({ from, to });
+        }
+
+        auto start = Clock::now();
+        HierarchicalPathfinder hierarchy;
+        hierarchy.build(map);
+        double buildMillis = millisSince(start);
+
+        // Latency to the first step, then the remaining segments
+        std::vector<std::pair<int, int>> route;
+        double firstMicros = 0;
+        double fullMicros = 0;
+        size_t found = 0;
+        size_t totalLength = 0;
+        for (const auto& query : queries) {
+            start = Clock::now();
+            bool ok = hierarchy.findRoute(query.first.first, query.first.second, query.second.first, query.second.second, route);
+            if (ok && route.size() > 1) hierarchy.refineSegment(route[0].first, route[0].second, route[1].first, route[1].second);
+            firstMicros += millisSince(start) * 1000.0;
+            if (!ok) continue;
+
+            size_t length = route.size() > 1 ? hierarchy.refineSegment(route[0].first, route[0].second, route[1].first, route[1].second).size() - 1 : 0;
+            for (size_t i = 2; i < route.size(); ++i) {
+                length += hierarchy.refineSegment(route[i - 1].first, route[i - 1].second, route[i].first, route[i].second).size() - 1;
+            }
+            fullMicros += millisSince(start) * 1000.0;
+            totalLength += length;
+            ++found;
+        }
+        std::printf("%-7d %-5s %9.1f %10.1f %12.1f %12.1f %10.1f\n", size, "HPA*", buildMillis,
+            megabytes(hierarchy.getMemoryBytes() + windowWorkspaceBytes(hierarchy.getClusterSize())),
+            firstMicros / queries.size(), found ? fullMicros / found : 0.0, found ? static_cast<double>(totalLength) / found : 0.0);
+
+        if (static_cast<size_t>(size) * size <= FLAT_LIMIT_CELLS) {
+            start = Clock::now();
+            JumpTable jumps;
+            jumps.build(map);
+            buildMillis = millisSince(start);
+
+            PathWorkspace workspace;
+            double micros = 0;
+            totalLength = 0;
+            found = 0;
+            for (const auto& query : queries) {
+                start = Clock::now();
+                const auto& path = workspace.findJumpPointPath(jumps, query.first.first, query.first.second, query.second.first, query.second.second);
+                micros += millisSince(start) * 1000.0;
+                if (path.empty()) continue;
+                totalLength += path.size() - 1;
+                ++found;
+            }
+            std::printf("%-7d %-5s %9.1f %10.1f %12.1f %12.1f %10.1f\n", size, "JPS", buildMillis, megabytes(flatMemoryBytes(map)),
+                micros / queries.size(), micros / queries.size(), found ? static_cast<double>(totalLength) / found : 0.0);
+        }
+        else {
+            std::printf("%-7d %-5s %9s %10.1f %12s %12s %10s\n", size, "JPS", "-", megabytes(flatMemoryBytes(map)), "n/a", "n/a", "n/a");
+        }
+
+        start = Clock::now();
+        for (int e = 0; e < EDITS; ++e) {
+            int x = coord(rng);
+            int y = coord(rng);
+            hierarchy.setBlocked(x, y, !hierarchy.getMap().isBlocked(x, y));
+        }
+        std::printf("%-7d %-5s %9.1f us per cell edit\n", size, "edit", millisSince(start) * 1000.0 / EDITS);
+    }
+    return 0;
+}
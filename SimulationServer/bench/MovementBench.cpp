@@ -0,0 +1,98 @@
+﻿#include "BallStore.h"
+#include "FlowField.h"
+#include "JumpTable.h"
+#include "ObstacleMap.h"
+#include "Pathfinding.h"
+#include "SpatialGrid.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+// Compares the movement phase of a tick under both movement modes on an open
+// map. Per-unit pathing finds each ball's nearest enemy and runs JPS to it, which is what
+// moveToward does on every replan; flow fields build one distance field per
+// team and step each ball downhill. Balls really move, so later ticks see
+// the clustering that happens as the armies converge.
+
+namespace {
+
+const int CELLS_PER_UNIT = 25;  // Keeps density close to the default 10 balls on 100x100 scaled up
+const int TICKS = 5;
+
+BallStore spawn(size_t units, int worldSize, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> coord(0, worldSize - 1);
+    BallStore balls;
+    balls.reserve(units);
+    for (size_t i = 0; i < units; ++i) {
+        int x = coord(rng);
+        int y = coord(rng);
+        balls.add(x, y, BallStats::MAX_HP, i % 2 == 0);
+    }
+    return balls;
+}
+
+double runPathPerUnit(BallStore& balls, int worldSize) {
+    SpatialGrid grid;
+    PathWorkspace workspace;
+    JumpTable jumps;
+    jumps.build(ObstacleMap(worldSize, worldSize));
+    double total = 0.0;
+
+    for (int tick = 0; tick < TICKS; ++tick) {
+        auto start = std::chrono::steady_clock::now();
+        grid.rebuild(balls, worldSize);
+        for (size_t i = 0; i < balls.size(); ++i) {
+            int target = grid.findNearestEnemy(balls, i);
+            if (target == SpatialGrid::NONE) continue;
+            const auto& path = workspace.findJumpPointPath(jumps, balls.getX(i), balls.getY(i),
+                balls.getX(target), balls.getY(target));
+            if (path.size() > 1) {
+                balls.setPosition(i, path[1].first, path[1].second);
+                grid.moveBall(balls, i);
+            }
+        }
+        total += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    return total / TICKS;
+}
+
+double runFlowField(BallStore& balls, int worldSize) {
+    FlowField field;
+    ObstacleMap open(worldSize, worldSize);
+    double total = 0.0;
+
+    for (int tick = 0; tick < TICKS; ++tick) {
+        auto start = std::chrono::steady_clock::now();
+        field.build(balls, open);
+        for (size_t i = 0; i < balls.size(); ++i) {
+            int x = balls.getX(i);
+            int y = balls.getY(i);
+            field.stepDownhill(balls.isRedTeam(i), x, y);
+            balls.setPosition(i, x, y);
+        }
+        total += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    return total / TICKS;
+}
+
+}  // namespace
+
+int main() {
+    const size_t unitCounts[] = { 1000, 10000, 100000 };
+
+    std::printf("%-8s %-7s %16s %14s %9s\n", "units", "world", "per-unit JPS ms", "flow field ms", "speedup");
+
+    for (size_t units : unitCounts) {
+        int worldSize = static_cast<int>(std::sqrt(static_cast<double>(units) * CELLS_PER_UNIT));
+
+        BallStore pathBalls = spawn(units, worldSize, 7);
+        BallStore fieldBalls = spawn(units, worldSize, 7);
+        double pathMs = runPathPerUnit(pathBalls, worldSize);
+        double fieldMs = runFlowField(fieldBalls, worldSize);
+
+        std::printf("%-8zu %-7d %16.2f %14.2f %8.1fx\n", units, worldSize, pathMs, fieldMs, pathMs / fieldMs);
+    }
+    return 0;
+}
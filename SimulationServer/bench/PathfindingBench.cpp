@@ -0,0 +1,104 @@
+﻿#include "JumpTable.h"
+#include "ObstacleMap.h"
+#include "Pathfinding.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+// Runs the same random queries through plain A* and Jump Point Search on
+// maps of increasing clutter, reporting time and nodes expanded per query.
+// Fails if the two ever disagree on a path length.
+
+namespace {
+
+const int MAP_SIZE = 256;
+const int QUERIES = 2000;
+
+ObstacleMap randomMap(int blockedPercent, std::mt19937& rng) {
+    ObstacleMap map(MAP_SIZE, MAP_SIZE);
+    std::uniform_int_distribution<int> percent(0, 99);
+    for (int y = 0; y < MAP_SIZE; ++y) {
+        for (int x = 0; x < MAP_SIZE; ++x) {
+            if (percent(rng) < blockedPercent) map.setBlocked(x, y, true);
+        }
+    }
+    return map;
+}
+
+// Long walls with a few gaps, the kind of terrain JPS jumps across cheaply
+ObstacleMap wallsMap(std::mt19937& rng) {
+    ObstacleMap map(MAP_SIZE, MAP_SIZE);
+    std::uniform_int_distribution<int> gap(0, MAP_SIZE - 1);
+    for (int x = 16; x < MAP_SIZE; x += 16) {
+        for (int y = 0; y < MAP_SIZE; ++y) map.setBlocked(x, y, true);
+        for (int g = 0; g < 3; ++g) map.setBlocked(x, gap(rng), false);
+    }
+    return map;
+}
+
+struct Result {
+    double microsPerQuery;
+    double expandedPerQuery;
+};
+
+}  // namespace
+
+int main() {
+    std::mt19937 rng(11);
+    struct Scenario {
+        std::string name;
+        ObstacleMap map;
+    };
+    std::vector<Scenario> scenarios;
+    scenarios.push_back({ "open", ObstacleMap(MAP_SIZE, MAP_SIZE) });
+    scenarios.push_back({ "random 10%", randomMap(10, rng) });
+    scenarios.push_back({ "random 30%", randomMap(30, rng) });
+    scenarios.push_back({ "walls", wallsMap(rng) });
+
+    std::printf("%-12s %-6s %12s %14s\n", "map", "search", "us/query", "expanded/query");
+    bool mismatch = false;
+
+    for (const auto& scenario : scenarios) {
+        const ObstacleMap& map = scenario.map;
+        JumpTable jumps;
+        jumps.build(map);
+
+        std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> queries;
+        std::uniform_int_distribution<int> coord(0, MAP_SIZE - 1);
+        while (queries.size() < static_cast<size_t>(QUERIES)) {
+            std::pair<int, int> from(coord(rng), coord(rng));
+            std::pair<int, int> to(coord(rng), coord(rng));
+            if (map.isOpen(from.first, from.second) && map.isOpen(to.first, to.second)) queries.push_back({ from, to });
+        }
+
+        PathWorkspace workspace;
+        std::vector<size_t> lengths;
+        Result results[2];
+
+        for (int search = 0; search < 2; ++search) {
+            size_t expanded = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (size_t q = 0; q < queries.size(); ++q) {
+                const auto& from = queries[q].first;
+                const auto& to = queries[q].second;
+                const auto& path = search == 0
+                    ? workspace.findPath(map, from.first, from.second, to.first, to.second)
+                    : workspace.findJumpPointPath(jumps, from.first, from.second, to.first, to.second);
+                expanded += workspace.getExpandedNodes();
+
+                if (search == 0) lengths.push_back(path.size());
+                else if (lengths[q] != path.size()) mismatch = true;
+            }
+            double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            results[search] = { micros / queries.size(), static_cast<double>(expanded) / queries.size() };
+        }
+
+        std::printf("%-12s %-6s %12.2f %14.1f\n", scenario.name.c_str(), "A*", results[0].microsPerQuery, results[0].expandedPerQuery);
+        std::printf("%-12s %-6s %12.2f %14.1f\n", scenario.name.c_str(), "JPS", results[1].microsPerQuery, results[1].expandedPerQuery);
+    }
+
+    if (mismatch) std::printf("MISMATCH: JPS and A* path lengths differ\n");
+    return mismatch ? 1 : 0;
+}
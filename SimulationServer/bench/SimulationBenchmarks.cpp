@@ -0,0 +1,277 @@
+﻿#include "GameConfig.h"
+#include "JumpTable.h"
+#include "ObstacleMap.h"
+#include "Pathfinding.h"
+#include "SimulationManager.h"
+#include "SnapshotProtocol.h"
+#include <SnapshotProtocol/StreamDecoder.h>
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Google Benchmark suite for the simulation hot paths, meant for tracking
+// regressions between releases:
+//
+//   SimulationBenchmarks --benchmark_out=results.json --benchmark_out_format=json
+//
+// Unit benchmarks take (units, grid size). Phases that change the battle
+// (combat, dead ball removal, ticks) respawn it outside the timed region and
+// report manual time, so only the phase itself is measured.
+
+namespace {
+
+const uint64_t SEED = 16;
+const int QUERY_COUNT = 256;
+
+// Building the manager precomputes the pathfinder for the grid, so
+// benchmarks make one and respawn battles in it with initialize
+std::unique_ptr<SimulationManager> makeBattle(int units, int gridSize, uint64_t seed) {
+    GameConfig config;
+    config.gridSize = gridSize;
+    std::unique_ptr<SimulationManager> sim(new SimulationManager(config));
+    sim->setEventLogging(false);
+    sim->initialize(seed, units);
+    return sim;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void unitArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({ "units", "grid" });
+    bench->ArgsProduct({ { 10, 100, 1000, 10000, 100000, 1000000 }, { 100, 256, 1024 } });
+}
+
+void serializationArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgName("units");
+    for (int units = 10; units <= 1000000; units *= 10) bench->Arg(units);
+}
+
+// ---- Pathfinding ----
+
+struct PathScenario {
+    ObstacleMap map;
+    JumpTable jumps;
+    std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> queries;
+};
+
+// 10% random obstacles and open endpoints, built once per grid size
+const PathScenario& pathScenario(int gridSize) {
+    static std::vector<std::pair<int, std::unique_ptr<PathScenario>>> cache;
+    for (const auto& entry : cache) {
+        if (entry.first == gridSize) return *entry.second;
+    }
+
+    std::unique_ptr<PathScenario> scenario(new PathScenario);
+    std::mt19937 rng(static_cast<uint32_t>(SEED + gridSize));
+    std::uniform_int_distribution<int> percent(0, 99);
+    scenario->map = ObstacleMap(gridSize, gridSize);
+    for (int y = 0; y < gridSize; ++y) {
+        for (int x = 0; x < gridSize; ++x) {
+            if (percent(rng) < 10) scenario->map.setBlocked(x, y, true);
+        }
+    }
+    scenario->jumps.build(scenario->map);
+
+    std::uniform_int_distribution<int> coord(0, gridSize - 1);
+    while (scenario->queries.size() < static_cast<size_t>(QUERY_COUNT)) {
+        std::pair<int, int> from(coord(rng), coord(rng));
+        std::pair<int, int> to(coord(rng), coord(rng));
+        if (scenario->map.isOpen(from.first, from.second) && scenario->map.isOpen(to.first, to.second)) {
+            scenario->queries.push_back({ from, to });
+        }
+    }
+
+    cache.emplace_back(gridSize, std::move(scenario));
+    return *cache.back().second;
+}
+
+void BM_FindPathAStar(benchmark::State& state) {
+    const PathScenario& scenario = pathScenario(static_cast<int>(state.range(0)));
+    PathWorkspace workspace;
+    size_t query = 0, expanded = 0;
+    for (auto _ : state) {
+        const auto& q = scenario.queries[query++ % scenario.queries.size()];
+        benchmark::DoNotOptimize(workspace.findPath(scenario.map, q.first.first, q.first.second, q.second.first, q.second.second).data());
+        expanded += workspace.getExpandedNodes();
+    }
+    state.counters["expanded"] = benchmark::Counter(static_cast<double>(expanded), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_FindPathAStar)->ArgName("grid")->Arg(64)->Arg(100)->Arg(256)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+void BM_FindPathJumpPoint(benchmark::State& state) {
+    const PathScenario& scenario = pathScenario(static_cast<int>(state.range(0)));
+    PathWorkspace workspace;
+    size_t query = 0, expanded = 0;
+    for (auto _ : state) {
+        const auto& q = scenario.queries[query++ % scenario.queries.size()];
+        benchmark::DoNotOptimize(workspace.findJumpPointPath(scenario.jumps, q.first.first, q.first.second, q.second.first, q.second.second).data());
+        expanded += workspace.getExpandedNodes();
+    }
+    state.counters["expanded"] = benchmark::Counter(static_cast<double>(expanded), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_FindPathJumpPoint)->ArgName("grid")->Arg(64)->Arg(100)->Arg(256)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+// ---- Simulation phases ----
+
+// One query per iteration, cycling through every ball
+void BM_FindNearestEnemy(benchmark::State& state) {
+    auto sim = makeBattle(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)), SEED);
+    size_t count = sim->getBalls().size();
+    size_t ball = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sim->findNearestEnemy(ball));
+        if (++ball == count) ball = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FindNearestEnemy)->Apply(unitArgs);
+
+// Every ball freshly spawned and off cooldown, so each one looks for a target
+void BM_HandleCombat(benchmark::State& state) {
+    int units = static_cast<int>(state.range(0));
+    int gridSize = static_cast<int>(state.range(1));
+    uint64_t seed = SEED;
+    auto sim = makeBattle(units, gridSize, seed);
+    for (auto _ : state) {
+        sim->initialize(seed++, units);
+        auto start = std::chrono::steady_clock::now();
+        sim->handleCombat();
+        state.SetIterationTime(secondsSince(start));
+    }
+    state.SetItemsProcessed(state.iterations() * units);
+}
+BENCHMARK(BM_HandleCombat)->Apply(unitArgs)->UseManualTime()->MinTime(0.1)->Unit(benchmark::kMicrosecond);
+
+// Compaction and spatial index rebuild after one round of combat
+void BM_RemoveDeadBalls(benchmark::State& state) {
+    int units = static_cast<int>(state.range(0));
+    int gridSize = static_cast<int>(state.range(1));
+    uint64_t seed = SEED;
+    size_t removed = 0;
+    auto sim = makeBattle(units, gridSize, seed);
+    for (auto _ : state) {
+        sim->initialize(seed++, units);
+        sim->handleCombat();
+        size_t before = sim->getBalls().size();
+        auto start = std::chrono::steady_clock::now();
+        sim->removeDeadBalls();
+        state.SetIterationTime(secondsSince(start));
+        removed += before - sim->getBalls().size();
+    }
+    state.SetItemsProcessed(state.iterations() * units);
+    state.counters["removed"] = benchmark::Counter(static_cast<double>(removed), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_RemoveDeadBalls)->Apply(unitArgs)->UseManualTime()->MinTime(0.1)->Unit(benchmark::kMicrosecond);
+
+// What the simulation loop does per tick: step, then publish for the network
+// thread. Battles that end are restarted with the next seed, untimed.
+void BM_Tick(benchmark::State& state) {
+    int units = static_cast<int>(state.range(0));
+    int gridSize = static_cast<int>(state.range(1));
+    uint64_t seed = SEED;
+    auto sim = makeBattle(units, gridSize, seed++);
+    for (auto _ : state) {
+        if (sim->isGameOver()) sim->initialize(seed++, units);
+        auto start = std::chrono::steady_clock::now();
+        sim->stepSimulation();
+        sim->publishState();
+        state.SetIterationTime(secondsSince(start));
+    }
+    state.SetItemsProcessed(state.iterations() * units);
+}
+BENCHMARK(BM_Tick)->Apply(unitArgs)->UseManualTime()->MinTime(0.1)->Unit(benchmark::kMillisecond);
+
+// ---- Frame serialization, as in NetworkManager::sendSimulationData ----
+
+const int SERIALIZATION_GRID = 1024;
+
+// Published state after one tick, so it carries both a full state and a delta
+std::unique_ptr<SimulationManager> publishedBattle(int units) {
+    auto sim = makeBattle(units, SERIALIZATION_GRID, SEED);
+    sim->stepSimulation();
+    sim->publishState();
+    sim->acquirePublishedState();
+    return sim;
+}
+
+void BM_PublishState(benchmark::State& state) {
+    auto sim = makeBattle(static_cast<int>(state.range(0)), SERIALIZATION_GRID, SEED);
+    for (auto _ : state) sim->publishState();
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PublishState)->Apply(serializationArgs)->Unit(benchmark::kMicrosecond);
+
+void BM_EncodeKeyframe(benchmark::State& state) {
+    auto sim = publishedBattle(static_cast<int>(state.range(0)));
+    const SnapshotProtocol::SimulationSnapshot& snapshot = sim->getPublishedState().state;
+    std::string frame;
+    for (auto _ : state) {
+        frame.clear();
+        SnapshotProtocol::encodeKeyframe(frame, snapshot.tick, SERIALIZATION_GRID, snapshot.units);
+        benchmark::DoNotOptimize(frame.data());
+    }
+    state.SetBytesProcessed(state.iterations() * frame.size());
+    state.SetItemsProcessed(state.iterations() * snapshot.units.size());
+}
+BENCHMARK(BM_EncodeKeyframe)->Apply(serializationArgs)->Unit(benchmark::kMicrosecond);
+
+void BM_EncodeDelta(benchmark::State& state) {
+    auto sim = publishedBattle(static_cast<int>(state.range(0)));
+    const SnapshotProtocol::SimulationSnapshot& changes = sim->getPublishedState().changes;
+    std::string frame;
+    for (auto _ : state) {
+        frame.clear();
+        SnapshotProtocol::encodeDelta(frame, changes);
+        benchmark::DoNotOptimize(frame.data());
+    }
+    state.SetBytesProcessed(state.iterations() * frame.size());
+    state.SetItemsProcessed(state.iterations() * changes.units.size());
+}
+BENCHMARK(BM_EncodeDelta)->Apply(serializationArgs)->Unit(benchmark::kMicrosecond);
+
+// Client side: feed one frame through the stream decoder and walk its units
+void decodeFrames(benchmark::State& state, const std::string& frame, size_t units) {
+    SnapshotProtocol::StreamDecoder decoder(frame.size());
+    SnapshotProtocol::FrameView view;
+    SnapshotProtocol::UnitView unit;
+    for (auto _ : state) {
+        decoder.append(reinterpret_cast<const uint8_t*>(frame.data()), frame.size());
+        if (decoder.next(view) != SnapshotProtocol::DecodeStatus::Frame) {
+            state.SkipWithError("frame did not decode");
+            break;
+        }
+        uint32_t hpSum = 0;
+        for (SnapshotProtocol::UnitCursor cursor = view.units(); cursor.next(unit);) hpSum += unit.hp;
+        benchmark::DoNotOptimize(hpSum);
+    }
+    state.SetBytesProcessed(state.iterations() * frame.size());
+    state.SetItemsProcessed(state.iterations() * units);
+}
+
+void BM_DecodeKeyframe(benchmark::State& state) {
+    auto sim = publishedBattle(static_cast<int>(state.range(0)));
+    const SnapshotProtocol::SimulationSnapshot& snapshot = sim->getPublishedState().state;
+    std::string frame;
+    SnapshotProtocol::encodeKeyframe(frame, snapshot.tick, SERIALIZATION_GRID, snapshot.units);
+    decodeFrames(state, frame, snapshot.units.size());
+}
+BENCHMARK(BM_DecodeKeyframe)->Apply(serializationArgs)->Unit(benchmark::kMicrosecond);
+
+void BM_DecodeDelta(benchmark::State& state) {
+    auto sim = publishedBattle(static_cast<int>(state.range(0)));
+    const SnapshotProtocol::SimulationSnapshot& changes = sim->getPublishedState().changes;
+    std::string frame;
+    SnapshotProtocol::encodeDelta(frame, changes);
+    decodeFrames(state, frame, changes.units.size());
+}
+BENCHMARK(BM_DecodeDelta)->Apply(serializationArgs)->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,114 @@
+﻿#include "SimulationManager.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// Times full ticks with the targeting and movement phase on 1, 2, 4, ...
+// worker threads, up to the machine's hardware threads. Every parallel run
+// must end in exactly the same state as the single-threaded one; the
+// in-place sequential update is shown for reference. Battles are then played
+// to the end on each thread count: parallel moves may play out differently
+// from in-place ones, but must not take much longer to finish.
+
+namespace {
+
+const int TICKS = 20;
+const uint32_t SEED = 7;
+const int LENGTH_UNITS = 200;
+const uint32_t LENGTH_BATTLES = 20;
+const uint32_t MAX_TICKS = 10000;
+
+struct Run {
+    double millisPerTick;
+    uint64_t stateHash;
+};
+
+Run runBattle(int units, size_t threads) {
+    SimulationManager sim;
+    sim.setEventLogging(false);  // Measure the simulation, not the logger
+    sim.setWorkerThreads(threads);
+    sim.initialize(SEED, units);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < TICKS && !sim.isGameOver(); ++tick) sim.stepSimulation();
+    double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t hash = 1469598103934665603ull;
+    const BallStore& balls = sim.getBalls();
+    for (size_t i = 0; i < balls.size(); ++i) {
+        uint64_t values[4] = { balls.getID(i), uint64_t(balls.getX(i)), uint64_t(balls.getY(i)), uint64_t(balls.getHp(i)) };
+        for (uint64_t value : values) hash = (hash ^ value) * 1099511628211ull;
+    }
+    return { millis / TICKS, hash };
+}
+
+// Ticks until game over, or MAX_TICKS if the battle never ends
+uint32_t battleLength(uint32_t battle, size_t threads) {
+    SimulationManager sim;
+    sim.setEventLogging(false);
+    sim.setWorkerThreads(threads);
+    sim.initialize((uint64_t(SEED) << 32) | battle, LENGTH_UNITS);
+    while (!sim.isGameOver() && sim.getTick() < MAX_TICKS) sim.stepSimulation();
+    return sim.getTick();
+}
+
+// Longest a parallel battle may take, given the in-place one's length
+uint32_t lengthBound(uint32_t inPlaceTicks) {
+    return inPlaceTicks * 2 + 50;
+}
+
+}  // namespace
+
+int main() {
+    size_t hardwareThreads = std::max(4u, std::thread::hardware_concurrency());
+    std::vector<size_t> threadCounts;
+    for (size_t threads = 1; threads <= hardwareThreads; threads *= 2) threadCounts.push_back(threads);
+
+    std::printf("%8s %8s %12s %9s\n", "units", "threads", "ms/tick", "speedup");
+    bool mismatch = false;
+
+    for (int units : { 1000, 10000, 100000 }) {
+        Run sequential = runBattle(units, 0);
+        std::printf("%8d %8s %12.3f %9s\n", units, "in place", sequential.millisPerTick, "-");
+
+        Run single = runBattle(units, 1);
+        for (size_t threads : threadCounts) {
+            Run run = threads == 1 ? single : runBattle(units, threads);
+            if (run.stateHash != single.stateHash) mismatch = true;
+            std::printf("%8d %8zu %12.3f %8.2fx%s\n", units, threads, run.millisPerTick,
+                single.millisPerTick / run.millisPerTick, run.stateHash == single.stateHash ? "" : "  MISMATCH");
+        }
+    }
+
+    std::printf("\n%8s %8s %12s %9s\n", "battles", "threads", "mean ticks", "longest");
+    std::vector<uint32_t> inPlace;
+    uint32_t total = 0;
+    for (uint32_t battle = 0; battle < LENGTH_BATTLES; ++battle) {
+        inPlace.push_back(battleLength(battle, 0));
+        total += inPlace.back();
+    }
+    std::printf("%8u %8s %12.1f %9u\n", LENGTH_BATTLES, "in place", double(total) / LENGTH_BATTLES,
+        *std::max_element(inPlace.begin(), inPlace.end()));
+
+    bool stalled = false;
+    for (size_t threads : threadCounts) {
+        uint32_t longest = 0;
+        bool tooLong = false;
+        total = 0;
+        for (uint32_t battle = 0; battle < LENGTH_BATTLES; ++battle) {
+            uint32_t ticks = battleLength(battle, threads);
+            total += ticks;
+            longest = std::max(longest, ticks);
+            if (ticks > lengthBound(inPlace[battle])) tooLong = true;
+        }
+        stalled = stalled || tooLong;
+        std::printf("%8u %8zu %12.1f %9u%s\n", LENGTH_BATTLES, threads, double(total) / LENGTH_BATTLES, longest,
+            tooLong ? "  STALLED" : "");
+    }
+
+    if (mismatch) std::printf("MISMATCH: results depend on the thread count\n");
+    if (stalled) std::printf("STALLED: parallel battles take far longer than in place\n");
+    return mismatch || stalled ? 1 : 0;
+}
@@ -0,0 +1,154 @@
+﻿#include "TestCheck.h"
+#include "BallStore.h"
+#include "GameConfig.h"
+#include "SimulationManager.h"
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+const char* CHECKPOINT_PATH = "BallStoreTest.checkpoint";
+
+// Ball i at (i, i) with hp 3, alternating teams
+void addBalls(BallStore& balls, int count) {
+    for (int i = 0; i < count; ++i) balls.add(i, i, 3, i % 2 == 0);
+}
+
+std::vector<BallHandle> handlesOf(const BallStore& balls) {
+    std::vector<BallHandle> handles;
+    for (size_t i = 0; i < balls.size(); ++i) handles.push_back(balls.getHandle(i));
+    return handles;
+}
+
+void kill(BallStore& balls, size_t slot) {
+    balls.takeDamage(slot, balls.getHp(slot));
+}
+
+void testDeadBallHandles() {
+    BallStore balls;
+    addBalls(balls, 10);
+    std::vector<BallHandle> handles = handlesOf(balls);
+    for (BallHandle handle : handles) CHECK(!handle.isNull());
+
+    kill(balls, 2);
+    kill(balls, 7);
+    std::vector<uint32_t> removedIds;
+    balls.removeDead(removedIds);
+    CHECK(balls.size() == 8);
+
+    // Survivors moved down a slot or two; their handles follow them
+    for (int i = 0; i < 10; ++i) {
+        size_t slot = 0;
+        bool resolved = balls.resolve(handles[i], slot);
+        if (i == 2 || i == 7) {
+            CHECK(!resolved);
+        }
+        else {
+            CHECK(resolved && balls.getX(slot) == i);
+        }
+    }
+
+    // A new ball takes a freed entry under a new generation; the old handle stays dead
+    size_t slot = balls.add(50, 50, 3, true);
+    BallHandle reused = balls.getHandle(slot);
+    CHECK(reused.index() == handles[7].index() || reused.index() == handles[2].index());
+    CHECK(reused != handles[7] && reused != handles[2]);
+    size_t resolvedSlot = 0;
+    CHECK(!balls.resolve(handles[7], resolvedSlot) && !balls.resolve(handles[2], resolvedSlot));
+    CHECK(balls.resolve(reused, resolvedSlot) && resolvedSlot == slot);
+}
+
+void testClearRejectsOldHandles() {
+    BallStore balls;
+    addBalls(balls, 10);
+    std::vector<BallHandle> handles = handlesOf(balls);
+
+    balls.clear();
+    size_t slot = 0;
+    for (BallHandle handle : handles) CHECK(!balls.resolve(handle, slot));
+
+    // The next battle reuses every entry, never under an old handle's generation
+    addBalls(balls, 10);
+    for (BallHandle handle : handles) CHECK(!balls.resolve(handle, slot));
+    for (size_t i = 0; i < balls.size(); ++i) {
+        CHECK(balls.resolve(balls.getHandle(i), slot) && slot == i);
+    }
+}
+
+void testRestoreRejectsOldHandles() {
+    GameConfig config;
+    config.gridSize = 32;
+    SimulationManager simulation(config);
+    simulation.setEventLogging(false);
+    simulation.initialize(11, 40);
+    for (int tick = 0; tick < 5; ++tick) simulation.stepSimulation();
+
+    std::vector<BallHandle> handles = handlesOf(simulation.getBalls());
+    std::vector<uint32_t> ids;
+    for (size_t i = 0; i < simulation.getBalls().size(); ++i) ids.push_back(simulation.getBalls().getID(i));
+
+    CHECK(simulation.saveCheckpoint(CHECKPOINT_PATH));
+    CHECK(simulation.restoreCheckpoint(CHECKPOINT_PATH));
+    std::remove(CHECKPOINT_PATH);
+
+    // Same balls in the same slots, but handles from before the restore are stale
+    const BallStore& balls = simulation.getBalls();
+    CHECK(balls.size() == ids.size());
+    size_t slot = 0;
+    for (BallHandle handle : handles) CHECK(!balls.resolve(handle, slot));
+    for (size_t i = 0; i < balls.size(); ++i) {
+        CHECK(balls.getID(i) == ids[i]);
+        CHECK(balls.resolve(balls.getHandle(i), slot) && slot == i);
+    }
+}
+
+void testFreedEntriesRecycled() {
+    // Many battles' worth of deaths and spawns, never more than 100 alive
+    BallStore balls;
+    addBalls(balls, 100);
+    std::vector<uint32_t> removedIds;
+    for (int round = 0; round < 200; ++round) {
+        for (size_t i = round % 3; i < balls.size(); i += 3) kill(balls, i);
+        balls.removeDead(removedIds);
+        addBalls(balls, static_cast<int>(100 - balls.size()));
+    }
+
+    // The table never grew past the most balls alive at once
+    CHECK(balls.size() == 100);
+    std::vector<bool> seen(100, false);
+    for (size_t i = 0; i < balls.size(); ++i) {
+        uint32_t index = balls.getHandle(i).index();
+        CHECK(index < 100 && !seen[index]);
+        if (index < 100) seen[index] = true;
+    }
+}
+
+void testGenerationWraps() {
+    // The documented limit: after 4095 reuses of one entry a stale handle matches again
+    BallStore balls;
+    balls.add(1, 1, 3, true);
+    BallHandle stale = balls.getHandle(0);
+    std::vector<uint32_t> removedIds;
+    size_t slot = 0;
+    const uint32_t reuses = BallHandle::GENERATION_MASK;
+    for (uint32_t reuse = 1; reuse <= reuses; ++reuse) {
+        kill(balls, 0);
+        balls.removeDead(removedIds);
+        balls.add(1, 1, 3, true);
+        CHECK(balls.getHandle(0).index() == stale.index());
+        if (reuse < reuses) CHECK(!balls.resolve(stale, slot));
+    }
+    CHECK(balls.getHandle(0) == stale);
+    CHECK(balls.resolve(stale, slot) && slot == 0);
+}
+
+}  // namespace
+
+int main() {
+    testDeadBallHandles();
+    testClearRejectsOldHandles();
+    testRestoreRejectsOldHandles();
+    testFreedEntriesRecycled();
+    testGenerationWraps();
+    return TestCheck::testResult("BallStoreTest");
+}
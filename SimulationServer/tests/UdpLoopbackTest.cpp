@@ -0,0 +1,275 @@
+﻿#include "TestCheck.h"
+#include "GameConfig.h"
+#include "NetworkManager.h"
+#include "SimulationManager.h"
+#include "SocketPlatform.h"
+#include <SnapshotProtocol/DatagramAssembler.h>
+#include <SnapshotProtocol/StreamDecoder.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <sys/select.h>
+#endif
+
+// Serves a live battle over UDP on loopback, with a share of datagrams
+// dropped and the rest delayed both ways, to a client that acks what it
+// decodes and applies each delta to the snapshot it was taken against. Every
+// snapshot the client rebuilds must match the battle at that tick, replayed
+// separately from the same seed, and the client must end close to the last
+// tick the server sent.
+
+namespace {
+
+const uint64_t SEED = 7;
+const int TCP_PORT = 47810;
+const int UDP_PORT = 47811;
+const int ACK_RESEND_MS = 20;  // Until the first snapshot arrives
+const size_t BASELINES_KEPT = 128;
+const uint32_t MAX_TICKS_BEHIND = 10;
+
+struct ClientUnit {
+    uint16_t x;
+    uint16_t y;
+    uint32_t hp;
+    bool isRed;
+};
+
+typedef std::map<uint32_t, ClientUnit> ClientState;  // By unit ID
+
+struct ClientResult {
+    std::map<uint32_t, ClientState> snapshots;  // Every snapshot rebuilt, by tick
+    int keyframes = 0;
+    int deltas = 0;
+    int missingBaselines = 0;  // Deltas against a snapshot the client never acked
+    int partialNewUnits = 0;   // Units first seen without every field
+    int malformed = 0;
+    bool gameOver = false;
+};
+
+GameConfig testConfig() {
+    GameConfig config;
+    config.gridSize = 96;
+    config.maxUnits = 400;  // A keyframe takes several datagrams
+    config.updateIntervalMs = 5;
+    config.startDelayMs = 0;
+    config.serverPort = TCP_PORT;
+    config.udpPort = UDP_PORT;
+    config.udpLossPercent = 20;
+    config.udpLatencyMs = 10;
+    return config;
+}
+
+class LoopbackClient {
+public:
+    LoopbackClient() : socket(SocketPlatform::InvalidSocket) {}
+    ~LoopbackClient() {
+        if (socket != SocketPlatform::InvalidSocket) SocketPlatform::closeSocket(socket);
+    }
+
+    bool open() {
+        socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (socket == SocketPlatform::InvalidSocket || !SocketPlatform::setNonBlocking(socket)) return false;
+        std::memset(&server, 0, sizeof(server));
+        server.sin_family = AF_INET;
+        server.sin_port = htons(static_cast<uint16_t>(UDP_PORT));
+        server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return true;
+    }
+
+    // Acks and decodes until the server is done, then takes what is still in flight
+    void run(const std::atomic<bool>& serverDone, ClientResult& result) {
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point lastAck;
+        Clock::time_point doneAt;
+        bool draining = false;
+
+        while (true) {
+            if (!draining && serverDone) {
+                draining = true;
+                doneAt = Clock::now();
+            }
+            if (draining && Clock::now() - doneAt > std::chrono::milliseconds(200)) break;
+
+            // The server only learns of the client from its acks
+            if (assembler.newestSequence() == 0 && Clock::now() - lastAck > std::chrono::milliseconds(ACK_RESEND_MS)) {
+                sendAck(0);
+                lastAck = Clock::now();
+            }
+
+            if (!waitReadable(ACK_RESEND_MS)) continue;
+            uint8_t buffer[SnapshotProtocol::MAX_DATAGRAM_SIZE];
+            int received;
+            while ((received = recv(socket, reinterpret_cast<char*>(buffer), sizeof(buffer), 0)) > 0) {
+                if (!assembler.add(buffer, static_cast<size_t>(received))) continue;
+                handleSnapshot(result);
+            }
+        }
+    }
+
+private:
+    bool waitReadable(int timeoutMs) {
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(socket, &readable);
+        timeval timeout;
+        timeout.tv_sec = 0;
+        timeout.tv_usec = timeoutMs * 1000;
+        return select(static_cast<int>(socket) + 1, &readable, nullptr, nullptr, &timeout) > 0;
+    }
+
+    void sendAck(uint32_t sequence) {
+        uint8_t ack[SnapshotProtocol::DATAGRAM_HEADER_SIZE] = {};
+        ack[0] = static_cast<uint8_t>(SnapshotProtocol::MAGIC & 0xFF);
+        ack[1] = static_cast<uint8_t>(SnapshotProtocol::MAGIC >> 8);
+        ack[2] = SnapshotProtocol::VERSION;
+        ack[3] = static_cast<uint8_t>(SnapshotProtocol::DatagramKind::Ack);
+        for (int i = 0; i < 4; ++i) ack[4 + i] = static_cast<uint8_t>(sequence >> (8 * i));
+        sendto(socket, reinterpret_cast<const char*>(ack), sizeof(ack), 0, reinterpret_cast<const sockaddr*>(&server),
+            sizeof(server));
+    }
+
+    void handleSnapshot(ClientResult& result) {
+        SnapshotProtocol::FrameView view;
+        if (SnapshotProtocol::decodePayload(assembler.payload(), assembler.payloadSize(), view) !=
+            SnapshotProtocol::DecodeStatus::Frame) {
+            ++result.malformed;
+            return;
+        }
+        if (view.type == SnapshotProtocol::MessageType::GameOver) {
+            result.gameOver = true;
+            return;
+        }
+
+        ClientState state;
+        if (view.type == SnapshotProtocol::MessageType::Keyframe) {
+            ++result.keyframes;
+        }
+        else {
+            auto baseline = baselines.find(assembler.baseSequence());
+            if (baseline == baselines.end()) {
+                ++result.missingBaselines;
+                return;
+            }
+            state = baseline->second;
+            ++result.deltas;
+        }
+
+        SnapshotProtocol::UnitCursor units = view.units();
+        SnapshotProtocol::UnitView unit;
+        while (units.next(unit)) {
+            auto found = state.find(unit.id);
+            if (found == state.end()) {
+                if (unit.fieldMask != SnapshotProtocol::FIELD_ALL) ++result.partialNewUnits;
+                found = state.emplace(unit.id, ClientUnit()).first;
+            }
+            ClientUnit& known = found->second;
+            if (unit.fieldMask & SnapshotProtocol::FIELD_POSITION) {
+                known.x = unit.x;
+                known.y = unit.y;
+            }
+            if (unit.fieldMask & SnapshotProtocol::FIELD_HP) known.hp = unit.hp;
+            if (unit.fieldMask & SnapshotProtocol::FIELD_TEAM) known.isRed = unit.isRed;
+        }
+        SnapshotProtocol::IdCursor removed = view.removedIds();
+        uint32_t id = 0;
+        while (removed.next(id)) state.erase(id);
+
+        result.snapshots[view.tick] = state;
+        baselines[assembler.sequence()] = std::move(state);
+        if (baselines.size() > BASELINES_KEPT) baselines.erase(baselines.begin());
+        sendAck(assembler.sequence());
+    }
+
+    SocketPlatform::SocketHandle socket;
+    sockaddr_in server;
+    SnapshotProtocol::DatagramAssembler assembler;
+    std::map<uint32_t, ClientState> baselines;  // Snapshots acked, by sequence
+};
+
+bool matches(const SimulationManager& reference, const ClientState& state) {
+    const BallStore& balls = reference.getBalls();
+    if (balls.size() != state.size()) return false;
+    for (size_t i = 0; i < balls.size(); ++i) {
+        auto found = state.find(balls.getID(i));
+        if (found == state.end()) return false;
+        const ClientUnit& unit = found->second;
+        if (unit.x != balls.getX(i) || unit.y != balls.getY(i) || static_cast<int>(unit.hp) != balls.getHp(i) ||
+            unit.isRed != balls.isRedTeam(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main() {
+    GameConfig config = testConfig();
+    SimulationManager simulationManager(config);
+    simulationManager.setEventLogging(false);
+    simulationManager.initialize(SEED);
+
+    NetworkManager networkManager(simulationManager);
+    if (!networkManager.initialize()) {
+        std::fprintf(stderr, "UdpLoopbackTest: could not bind ports %d and %d\n", TCP_PORT, UDP_PORT);
+        return 1;
+    }
+
+    LoopbackClient client;
+    CHECK(client.open());
+    ClientResult result;
+    std::atomic<bool> serverDone(false);
+    std::thread clientThread(&LoopbackClient::run, &client, std::cref(serverDone), std::ref(result));
+
+    std::thread simThread(&SimulationManager::updateSimulation, &simulationManager);
+    bool connected = networkManager.waitForClient();
+    CHECK(connected);
+    if (connected) {
+        std::thread sendThread(&NetworkManager::sendSimulationData, &networkManager);
+        sendThread.join();
+    }
+    simulationManager.signalShouldExit();
+    simThread.join();
+    serverDone = true;
+    clientThread.join();
+    networkManager.closeConnection();
+
+    // Every manager closes its own sockets, so the ports can be served again and again
+    for (int reopen = 0; reopen < 2; ++reopen) {
+        NetworkManager again(simulationManager);
+        CHECK(again.initialize());
+        again.closeConnection();
+    }
+
+    // The final tick goes out as the GameOver message rather than a snapshot
+    uint32_t finalTick = simulationManager.getTick();
+    std::printf("UdpLoopbackTest: %zu snapshots rebuilt (%d keyframes, %d deltas) over %u ticks%s\n",
+        result.snapshots.size(), result.keyframes, result.deltas, finalTick, result.gameOver ? ", game over seen" : "");
+
+    CHECK(result.malformed == 0);
+    CHECK(result.missingBaselines == 0);
+    CHECK(result.partialNewUnits == 0);
+    CHECK(result.keyframes > 0);
+    CHECK(result.deltas > 0);
+    CHECK(!result.snapshots.empty());
+    CHECK(!result.snapshots.empty() && result.snapshots.rbegin()->first + MAX_TICKS_BEHIND >= finalTick);
+
+    // Same seed, same battle: step a second simulation through every tick the client saw
+    SimulationManager reference(config);
+    reference.setEventLogging(false);
+    reference.initialize(SEED);
+    for (const auto& snapshot : result.snapshots) {
+        while (reference.getTick() < snapshot.first) reference.stepSimulation();
+        if (!matches(reference, snapshot.second)) {
+            std::fprintf(stderr, "UdpLoopbackTest: client state differs from the battle at tick %u\n", snapshot.first);
+            CHECK(false);
+        }
+    }
+
+    return TestCheck::testResult("UdpLoopbackTest");
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace SnapshotProtocol {
+
+// Growable byte ring buffer for stream reassembly. Writers fill space handed
+// out by prepareWrite() directly (e.g. straight from recv), and readers get
+// pointers into the storage instead of copies. Data is only moved when a
+// read would straddle the wrap point or the buffer has to grow.
+class ByteRingBuffer {
+public:
+    explicit ByteRingBuffer(size_t initialCapacity = 16384);
+
+    size_t size() const { return count; }
+    size_t capacity() const { return storage.size(); }
+    bool empty() const { return count == 0; }
+
+    // Returns a contiguous writable region of at least minBytes, growing or
+    // compacting the buffer when needed. writable receives the region size.
+    uint8_t* prepareWrite(size_t minBytes, size_t& writable);
+    void commitWrite(size_t bytes);
+    void write(const uint8_t* data, size_t bytes);
+
+    // Copies bytes starting offset bytes into the readable region
+    void peek(size_t offset, uint8_t* out, size_t bytes) const;
+
+    // Returns the first bytes readable bytes as one contiguous block
+    const uint8_t* contiguous(size_t bytes);
+
+    void consume(size_t bytes);
+    void clear();
+
+private:
+    void linearize();
+    void grow(size_t minCapacity);
+
+    std::vector<uint8_t> storage;  // Capacity is always a power of two
+    size_t head;                   // Index of the first readable byte
+    size_t count;                  // Readable bytes
+};
+
+}  // namespace SnapshotProtocol
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "SnapshotProtocol/WireFormat.h"
+#include <cstddef>
+#include <cstdint>
+
+// Encoder for the messages a client sends to the server, header-only so
+// clients need nothing beyond this file and WireFormat.h.
+namespace SnapshotProtocol {
+
+const size_t VIEWPORT_FRAME_SIZE = FRAME_PREFIX_SIZE + HEADER_SIZE + VIEWPORT_BODY_SIZE;
+
+// Writes a complete Viewport frame asking for units inside the inclusive
+// cell rectangle. Sending another one moves the viewport.
+inline void encodeViewport(uint8_t (&out)[VIEWPORT_FRAME_SIZE], uint16_t minX, uint16_t minY, uint16_t maxX,
+    uint16_t maxY) {
+    const uint32_t length = static_cast<uint32_t>(HEADER_SIZE + VIEWPORT_BODY_SIZE);
+    const uint16_t fields[4] = { minX, minY, maxX, maxY };
+    size_t i = 0;
+    for (int shift = 0; shift < 32; shift += 8) out[i++] = static_cast<uint8_t>(length >> shift);
+    out[i++] = static_cast<uint8_t>(MAGIC);
+    out[i++] = static_cast<uint8_t>(MAGIC >> 8);
+    out[i++] = VERSION;
+    out[i++] = static_cast<uint8_t>(MessageType::Viewport);
+    for (int b = 0; b < 4; ++b) out[i++] = 0;  // Tick, unused
+    for (uint16_t field : fields) {
+        out[i++] = static_cast<uint8_t>(field);
+        out[i++] = static_cast<uint8_t>(field >> 8);
+    }
+}
+
+// Writes an Ack datagram for the UDP transport: sequence is the newest
+// snapshot the client decoded, or 0 to join. Send one for every snapshot
+// decoded, and resend the last one every second or so while nothing
+// arrives: the server drops clients it has not heard from in five seconds.
+inline void encodeAck(uint8_t (&out)[DATAGRAM_HEADER_SIZE], uint32_t sequence) {
+    size_t i = 0;
+    out[i++] = static_cast<uint8_t>(MAGIC);
+    out[i++] = static_cast<uint8_t>(MAGIC >> 8);
+    out[i++] = VERSION;
+    out[i++] = static_cast<uint8_t>(DatagramKind::Ack);
+    for (int shift = 0; shift < 32; shift += 8) out[i++] = static_cast<uint8_t>(sequence >> shift);
+    while (i < DATAGRAM_HEADER_SIZE) out[i++] = 0;  // Base sequence and fragment fields, unused
+}
+
+}  // namespace SnapshotProtocol
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "SnapshotProtocol/WireFormat.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace SnapshotProtocol {
+
+struct DatagramHeader {
+    DatagramKind kind = DatagramKind::Fragment;
+    uint32_t sequence = 0;
+    uint32_t baseSequence = 0;
+    uint16_t fragmentIndex = 0;
+    uint16_t fragmentCount = 0;
+};
+
+// Reads and validates the header of one datagram; false if it is too short,
+// not ours or of an unknown kind
+bool parseDatagramHeader(const uint8_t* data, size_t size, DatagramHeader& header);
+
+// Rebuilds snapshot payloads from Fragment datagrams arriving in any order.
+// Only the newest snapshot matters, so fragments of one older than the
+// newest completed are dropped and a newer snapshot abandons a partial one.
+class DatagramAssembler {
+public:
+    DatagramAssembler();
+
+    // Takes one datagram; true when it completes a snapshot, whose payload
+    // (ready for decodePayload) stays valid until the next call
+    bool add(const uint8_t* data, size_t size);
+
+    uint32_t sequence() const { return current.sequence; }
+    uint32_t baseSequence() const { return current.baseSequence; }
+    const uint8_t* payload() const { return buffer.data(); }
+    size_t payloadSize() const { return payloadLength; }
+
+    // Newest snapshot completed so far, 0 before the first
+    uint32_t newestSequence() const { return newestCompleted; }
+    void reset();
+
+private:
+    DatagramHeader current;       // Snapshot being assembled
+    std::vector<uint8_t> buffer;  // Fragments at index * MAX_FRAGMENT_PAYLOAD
+    std::vector<bool> received;
+    uint32_t receivedCount;
+    size_t payloadLength;         // Known once the last fragment is in
+    uint32_t newestCompleted;
+};
+
+}  // namespace SnapshotProtocol
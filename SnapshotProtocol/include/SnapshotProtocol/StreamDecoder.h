@@ -0,0 +1,113 @@
+#pragma once
+
+#include "SnapshotProtocol/WireFormat.h"
+#include "SnapshotProtocol/ByteRingBuffer.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace SnapshotProtocol {
+
+enum class DecodeStatus {
+    Frame,         // A complete frame was decoded
+    NeedMoreData,  // The buffered bytes end inside a frame
+    Malformed,     // The stream is corrupt and cannot be resynchronized
+};
+
+// One unit entry of a keyframe or delta. Keyframe entries have every field set.
+struct UnitView {
+    uint32_t id;
+    uint8_t fieldMask;
+    uint16_t x;
+    uint16_t y;
+    uint32_t hp;
+    bool isRed;
+};
+
+// Walks the unit entries of an already validated frame without copying them
+class UnitCursor {
+public:
+    UnitCursor() : data(nullptr), end(nullptr), remaining(0), keyframe(false) {}
+    UnitCursor(const uint8_t* data, const uint8_t* end, uint32_t count, bool keyframe)
+        : data(data), end(end), remaining(count), keyframe(keyframe) {}
+
+    bool next(UnitView& out);
+
+private:
+    const uint8_t* data;
+    const uint8_t* end;
+    uint32_t remaining;
+    bool keyframe;
+};
+
+// Walks the removed-ID or left-ID list of an already validated delta
+class IdCursor {
+public:
+    IdCursor() : data(nullptr), end(nullptr), remaining(0) {}
+    IdCursor(const uint8_t* data, const uint8_t* end, uint32_t count)
+        : data(data), end(end), remaining(count) {}
+
+    bool next(uint32_t& id);
+
+private:
+    const uint8_t* data;
+    const uint8_t* end;
+    uint32_t remaining;
+};
+
+// A decoded message pointing into the decoder's buffer. It stays valid until
+// the next call that writes to or advances the decoder.
+struct FrameView {
+    MessageType type = MessageType::Keyframe;
+    uint32_t tick = 0;
+    uint32_t gridSize = 0;      // Keyframes only
+    uint32_t unitCount = 0;     // Keyframes and deltas
+    uint32_t removedCount = 0;  // Deltas only
+    uint32_t leftCount = 0;     // ViewDeltas only
+    const char* text = nullptr; // GameOver message, not null-terminated
+    uint32_t textLength = 0;
+    uint16_t viewMinX = 0;      // Viewport only, inclusive bounds
+    uint16_t viewMinY = 0;
+    uint16_t viewMaxX = 0;
+    uint16_t viewMaxY = 0;
+
+    UnitCursor units() const { return UnitCursor(unitData, unitEnd, unitCount, type == MessageType::Keyframe); }
+    IdCursor removedIds() const { return IdCursor(removedData, removedEnd, removedCount); }
+    IdCursor leftIds() const { return IdCursor(leftData, leftEnd, leftCount); }
+
+    const uint8_t* unitData = nullptr;
+    const uint8_t* unitEnd = nullptr;
+    const uint8_t* removedData = nullptr;
+    const uint8_t* removedEnd = nullptr;
+    const uint8_t* leftData = nullptr;
+    const uint8_t* leftEnd = nullptr;
+};
+
+// Validates one message payload (without the length prefix) and fills frame
+// with views into payload. Useful wherever framing is handled elsewhere.
+DecodeStatus decodePayload(const uint8_t* payload, size_t length, FrameView& frame);
+
+// Incremental decoder for the length-prefixed TCP stream. Bytes are written
+// straight into its ring buffer and frames are parsed in place.
+class StreamDecoder {
+public:
+    explicit StreamDecoder(size_t initialCapacity = 16384);
+
+    // Receive directly into the decoder: fill up to writable bytes, then commit
+    uint8_t* prepareWrite(size_t minBytes, size_t& writable);
+    void commitWrite(size_t bytes);
+    void append(const uint8_t* data, size_t bytes);
+
+    // Decodes the next complete frame, releasing the one returned previously
+    DecodeStatus next(FrameView& frame);
+
+    size_t bufferedBytes() const { return buffer.size(); }
+    void reset();
+
+private:
+    void releaseCurrentFrame();
+
+    ByteRingBuffer buffer;
+    size_t currentFrameSize;  // Bytes still owned by the last returned frame
+};
+
+}  // namespace SnapshotProtocol
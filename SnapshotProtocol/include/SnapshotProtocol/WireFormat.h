@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Wire constants shared by the simulation server and every client.
+// This header has no Unreal or platform dependencies.
+//
+// The TCP stream is a sequence of frames: a u32 little-endian payload length
+// followed by that many payload bytes. Every payload starts with a fixed
+// 8-byte little-endian header:
+//   u16 magic | u8 version | u8 type | u32 tick
+//
+// Keyframe body: varint gridSize, varint unitCount, then per unit
+//   varint id | u16 x | u16 y | varint hp | u8 team (1 = red)
+// Delta body: varint changedCount, then per unit
+//   varint id | u8 fieldMask | [u16 x | u16 y] | [varint hp] | [u8 team]
+// followed by varint removedCount and that many varint ids.
+// GameOver body: varint length and the winning team message bytes.
+// ViewDelta body: a delta body followed by varint leftCount and that many
+// varint ids of living units that moved out of the client's viewport. Units
+// that came into view are entries with FIELD_ENTERED and every field set.
+//
+// Clients may send one message type back, framed the same way:
+// Viewport body: u16 minX | u16 minY | u16 maxX | u16 maxY, the inclusive
+// cell rectangle the client shows (the tick is ignored). From then on the
+// client gets keyframes and ViewDeltas covering only that area.
+//
+// The optional UDP transport carries the same payloads without the length
+// prefix, split across datagrams of at most MAX_DATAGRAM_SIZE bytes. Every
+// datagram starts with a 16-byte little-endian header:
+//   u16 magic | u8 version | u8 kind | u32 sequence | u32 baseSequence |
+//   u16 fragmentIndex | u16 fragmentCount
+// Fragment datagrams are followed by their slice of the payload. A payload
+// with baseSequence 0 is a Keyframe (or GameOver); otherwise it is a Delta
+// against snapshot baseSequence, one the client acknowledged. Lost snapshots
+// are never resent, since the next one supersedes them.
+// Clients send Ack datagrams, the header alone, with sequence set to the
+// newest snapshot they decoded (0 to join) and the other fields 0.
+namespace SnapshotProtocol {
+
+const uint16_t MAGIC = 0x5342;  // "BS"
+const uint8_t VERSION = 2;
+const size_t FRAME_PREFIX_SIZE = 4;
+const size_t HEADER_SIZE = 8;
+const uint32_t MAX_FRAME_SIZE = 64u << 20;  // Larger length prefixes are treated as corruption
+
+enum class MessageType : uint8_t {
+    Keyframe = 1,
+    Delta = 2,
+    GameOver = 3,
+    Viewport = 4,   // Client to server
+    ViewDelta = 5,  // Server to clients that sent a Viewport
+};
+
+// Per-unit dirty bits; a delta entry only carries the fields whose bit is set
+enum FieldMask : uint8_t {
+    FIELD_POSITION = 1 << 0,
+    FIELD_HP = 1 << 1,
+    FIELD_TEAM = 1 << 2,
+    FIELD_ALL = FIELD_POSITION | FIELD_HP | FIELD_TEAM,
+    FIELD_ENTERED = 1 << 3,  // ViewDelta only: the unit just came into view
+};
+
+const size_t VIEWPORT_BODY_SIZE = 8;
+
+enum class DatagramKind : uint8_t {
+    Fragment = 1,  // Server to client
+    Ack = 2,       // Client to server
+};
+
+const size_t DATAGRAM_HEADER_SIZE = 16;
+const size_t MAX_DATAGRAM_SIZE = 1200;  // Below common path MTUs after IP and UDP headers
+const size_t MAX_FRAGMENT_PAYLOAD = MAX_DATAGRAM_SIZE - DATAGRAM_HEADER_SIZE;
+
+}  // namespace SnapshotProtocol
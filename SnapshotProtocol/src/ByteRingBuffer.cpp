@@ -0,0 +1,93 @@
+#include "SnapshotProtocol/ByteRingBuffer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace SnapshotProtocol {
+
+static size_t roundUpPowerOfTwo(size_t value) {
+    size_t result = 64;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+ByteRingBuffer::ByteRingBuffer(size_t initialCapacity)
+    : storage(roundUpPowerOfTwo(initialCapacity)), head(0), count(0) {}
+
+uint8_t* ByteRingBuffer::prepareWrite(size_t minBytes, size_t& writable) {
+    if (minBytes == 0) minBytes = 1;
+
+    size_t mask = storage.size() - 1;
+    size_t tail = (head + count) & mask;
+    // Free space is contiguous up to the end of storage, or up to head once wrapped
+    writable = (tail >= head && count < storage.size()) ? storage.size() - tail : head - tail;
+    if (count == 0) {
+        head = tail = 0;
+        writable = storage.size();
+    }
+
+    if (writable < minBytes) {
+        if (storage.size() - count >= minBytes) {
+            linearize();
+        }
+        else {
+            grow(count + minBytes);
+        }
+        tail = count;
+        writable = storage.size() - count;
+    }
+
+    return storage.data() + tail;
+}
+
+void ByteRingBuffer::commitWrite(size_t bytes) {
+    count += bytes;
+}
+
+void ByteRingBuffer::write(const uint8_t* data, size_t bytes) {
+    while (bytes > 0) {
+        size_t writable = 0;
+        uint8_t* dest = prepareWrite(bytes, writable);
+        size_t chunk = std::min(bytes, writable);
+        std::memcpy(dest, data, chunk);
+        commitWrite(chunk);
+        data += chunk;
+        bytes -= chunk;
+    }
+}
+
+void ByteRingBuffer::peek(size_t offset, uint8_t* out, size_t bytes) const {
+    size_t mask = storage.size() - 1;
+    for (size_t i = 0; i < bytes; ++i) {
+        out[i] = storage[(head + offset + i) & mask];
+    }
+}
+
+const uint8_t* ByteRingBuffer::contiguous(size_t bytes) {
+    if (head + bytes > storage.size()) linearize();
+    return storage.data() + head;
+}
+
+void ByteRingBuffer::consume(size_t bytes) {
+    bytes = std::min(bytes, count);
+    head = (head + bytes) & (storage.size() - 1);
+    count -= bytes;
+    if (count == 0) head = 0;
+}
+
+void ByteRingBuffer::clear() {
+    head = 0;
+    count = 0;
+}
+
+void ByteRingBuffer::linearize() {
+    // Rotating moves [head, end) to the front followed by the wrapped part
+    std::rotate(storage.begin(), storage.begin() + head, storage.end());
+    head = 0;
+}
+
+void ByteRingBuffer::grow(size_t minCapacity) {
+    linearize();
+    storage.resize(roundUpPowerOfTwo(minCapacity));
+}
+
+}  // namespace SnapshotProtocol
@@ -0,0 +1,80 @@
+#include "SnapshotProtocol/DatagramAssembler.h"
+#include <cstring>
+
+namespace SnapshotProtocol {
+
+namespace {
+
+uint16_t loadU16(const uint8_t* bytes) {
+    return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+uint32_t loadU32(const uint8_t* bytes) {
+    return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+        (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+}  // namespace
+
+bool parseDatagramHeader(const uint8_t* data, size_t size, DatagramHeader& header) {
+    if (size < DATAGRAM_HEADER_SIZE || size > MAX_DATAGRAM_SIZE) return false;
+    if (loadU16(data) != MAGIC || data[2] != VERSION) return false;
+    if (data[3] != static_cast<uint8_t>(DatagramKind::Fragment) && data[3] != static_cast<uint8_t>(DatagramKind::Ack)) {
+        return false;
+    }
+
+    header.kind = static_cast<DatagramKind>(data[3]);
+    header.sequence = loadU32(data + 4);
+    header.baseSequence = loadU32(data + 8);
+    header.fragmentIndex = loadU16(data + 12);
+    header.fragmentCount = loadU16(data + 14);
+    return true;
+}
+
+DatagramAssembler::DatagramAssembler() : receivedCount(0), payloadLength(0), newestCompleted(0) {}
+
+void DatagramAssembler::reset() {
+    current = DatagramHeader();
+    buffer.clear();
+    received.clear();
+    receivedCount = 0;
+    payloadLength = 0;
+    newestCompleted = 0;
+}
+
+bool DatagramAssembler::add(const uint8_t* data, size_t size) {
+    DatagramHeader header;
+    if (!parseDatagramHeader(data, size, header) || header.kind != DatagramKind::Fragment) return false;
+    if (header.sequence == 0 || header.fragmentCount == 0 || header.fragmentIndex >= header.fragmentCount) return false;
+    if (header.sequence <= newestCompleted) return false;  // Superseded or a duplicate
+
+    // Every fragment but the last is full, so each one's place is known up front
+    size_t sliceSize = size - DATAGRAM_HEADER_SIZE;
+    bool isLast = header.fragmentIndex + 1 == header.fragmentCount;
+    if (sliceSize == 0 || (!isLast && sliceSize != MAX_FRAGMENT_PAYLOAD)) return false;
+
+    if (header.sequence != current.sequence || receivedCount == 0) {
+        if (header.sequence < current.sequence && receivedCount > 0) return false;  // Older than the partial one
+        current = header;
+        buffer.resize(static_cast<size_t>(header.fragmentCount) * MAX_FRAGMENT_PAYLOAD);
+        received.assign(header.fragmentCount, false);
+        receivedCount = 0;
+        payloadLength = 0;
+    }
+    else if (header.fragmentCount != current.fragmentCount || header.baseSequence != current.baseSequence) {
+        return false;
+    }
+    if (received[header.fragmentIndex]) return false;
+
+    size_t offset = static_cast<size_t>(header.fragmentIndex) * MAX_FRAGMENT_PAYLOAD;
+    std::memcpy(buffer.data() + offset, data + DATAGRAM_HEADER_SIZE, sliceSize);
+    received[header.fragmentIndex] = true;
+    if (isLast) payloadLength = offset + sliceSize;
+    if (++receivedCount < current.fragmentCount) return false;
+
+    newestCompleted = current.sequence;
+    receivedCount = 0;  // The next fragment starts a new snapshot; the payload stays readable until then
+    return true;
+}
+
+}  // namespace SnapshotProtocol
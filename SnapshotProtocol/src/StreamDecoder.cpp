@@ -0,0 +1,205 @@
+#include "SnapshotProtocol/StreamDecoder.h"
+
+namespace SnapshotProtocol {
+
+namespace {
+
+// Bounds-checked little-endian reader used for validation and iteration
+struct Reader {
+    const uint8_t* cursor;
+    const uint8_t* end;
+
+    bool readU8(uint8_t& out) {
+        if (cursor >= end) return false;
+        out = *cursor++;
+        return true;
+    }
+
+    bool readU16(uint16_t& out) {
+        if (end - cursor < 2) return false;
+        out = static_cast<uint16_t>(cursor[0] | (cursor[1] << 8));
+        cursor += 2;
+        return true;
+    }
+
+    bool readU32(uint32_t& out) {
+        if (end - cursor < 4) return false;
+        out = static_cast<uint32_t>(cursor[0]) | (static_cast<uint32_t>(cursor[1]) << 8) |
+            (static_cast<uint32_t>(cursor[2]) << 16) | (static_cast<uint32_t>(cursor[3]) << 24);
+        cursor += 4;
+        return true;
+    }
+
+    bool readVarint(uint32_t& out) {
+        out = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            uint8_t byte;
+            if (!readU8(byte)) return false;
+            out |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) return true;
+        }
+        return false;
+    }
+
+    // Validates a varint ID list and returns where it starts and ends
+    bool readIds(uint32_t& count, const uint8_t*& first, const uint8_t*& last) {
+        if (!readVarint(count)) return false;
+        first = cursor;
+        uint32_t id;
+        for (uint32_t i = 0; i < count; ++i) {
+            if (!readVarint(id)) return false;
+        }
+        last = cursor;
+        return true;
+    }
+
+    bool readUnit(bool keyframe, UnitView& out) {
+        if (!readVarint(out.id)) return false;
+
+        out.fieldMask = FIELD_ALL;
+        if (!keyframe && !readU8(out.fieldMask)) return false;
+
+        out.x = out.y = 0;
+        out.hp = 0;
+        out.isRed = false;
+        if ((out.fieldMask & FIELD_POSITION) && !(readU16(out.x) && readU16(out.y))) return false;
+        if ((out.fieldMask & FIELD_HP) && !readVarint(out.hp)) return false;
+        if (out.fieldMask & FIELD_TEAM) {
+            uint8_t team;
+            if (!readU8(team)) return false;
+            out.isRed = team == 1;
+        }
+        return true;
+    }
+};
+
+}  // namespace
+
+bool UnitCursor::next(UnitView& out) {
+    if (remaining == 0) return false;
+    Reader reader{ data, end };
+    if (!reader.readUnit(keyframe, out)) return false;
+    data = reader.cursor;
+    --remaining;
+    return true;
+}
+
+bool IdCursor::next(uint32_t& id) {
+    if (remaining == 0) return false;
+    Reader reader{ data, end };
+    if (!reader.readVarint(id)) return false;
+    data = reader.cursor;
+    --remaining;
+    return true;
+}
+
+DecodeStatus decodePayload(const uint8_t* payload, size_t length, FrameView& frame) {
+    Reader reader{ payload, payload + length };
+
+    uint16_t magic;
+    uint8_t version, type;
+    if (!reader.readU16(magic) || !reader.readU8(version) || !reader.readU8(type) || !reader.readU32(frame.tick)) {
+        return DecodeStatus::Malformed;
+    }
+    if (magic != MAGIC || version != VERSION) return DecodeStatus::Malformed;
+
+    frame.type = static_cast<MessageType>(type);
+    frame.gridSize = frame.unitCount = frame.removedCount = frame.leftCount = frame.textLength = 0;
+    frame.text = nullptr;
+    frame.unitData = frame.unitEnd = frame.removedData = frame.removedEnd = frame.leftData = frame.leftEnd = nullptr;
+    frame.viewMinX = frame.viewMinY = frame.viewMaxX = frame.viewMaxY = 0;
+
+    switch (frame.type) {
+    case MessageType::Keyframe:
+    case MessageType::Delta:
+    case MessageType::ViewDelta: {
+        bool keyframe = frame.type == MessageType::Keyframe;
+        if (keyframe && !reader.readVarint(frame.gridSize)) return DecodeStatus::Malformed;
+        if (!reader.readVarint(frame.unitCount)) return DecodeStatus::Malformed;
+
+        // Validate every entry once so cursors handed to callers cannot fail midway
+        frame.unitData = reader.cursor;
+        UnitView unit;
+        for (uint32_t i = 0; i < frame.unitCount; ++i) {
+            if (!reader.readUnit(keyframe, unit)) return DecodeStatus::Malformed;
+        }
+        frame.unitEnd = reader.cursor;
+
+        if (!keyframe && !reader.readIds(frame.removedCount, frame.removedData, frame.removedEnd)) {
+            return DecodeStatus::Malformed;
+        }
+        if (frame.type == MessageType::ViewDelta && !reader.readIds(frame.leftCount, frame.leftData, frame.leftEnd)) {
+            return DecodeStatus::Malformed;
+        }
+        break;
+    }
+    case MessageType::Viewport: {
+        if (!reader.readU16(frame.viewMinX) || !reader.readU16(frame.viewMinY) || !reader.readU16(frame.viewMaxX) ||
+            !reader.readU16(frame.viewMaxY) || frame.viewMinX > frame.viewMaxX || frame.viewMinY > frame.viewMaxY) {
+            return DecodeStatus::Malformed;
+        }
+        break;
+    }
+    case MessageType::GameOver: {
+        if (!reader.readVarint(frame.textLength)) return DecodeStatus::Malformed;
+        if (static_cast<size_t>(reader.end - reader.cursor) < frame.textLength) return DecodeStatus::Malformed;
+        frame.text = reinterpret_cast<const char*>(reader.cursor);
+        reader.cursor += frame.textLength;
+        break;
+    }
+    default:
+        return DecodeStatus::Malformed;
+    }
+
+    // Trailing bytes mean the encoder and decoder disagree about the layout
+    return reader.cursor == reader.end ? DecodeStatus::Frame : DecodeStatus::Malformed;
+}
+
+StreamDecoder::StreamDecoder(size_t initialCapacity)
+    : buffer(initialCapacity), currentFrameSize(0) {}
+
+uint8_t* StreamDecoder::prepareWrite(size_t minBytes, size_t& writable) {
+    releaseCurrentFrame();
+    return buffer.prepareWrite(minBytes, writable);
+}
+
+void StreamDecoder::commitWrite(size_t bytes) {
+    buffer.commitWrite(bytes);
+}
+
+void StreamDecoder::append(const uint8_t* data, size_t bytes) {
+    releaseCurrentFrame();
+    buffer.write(data, bytes);
+}
+
+DecodeStatus StreamDecoder::next(FrameView& frame) {
+    releaseCurrentFrame();
+
+    if (buffer.size() < FRAME_PREFIX_SIZE) return DecodeStatus::NeedMoreData;
+
+    uint8_t prefix[FRAME_PREFIX_SIZE];
+    buffer.peek(0, prefix, FRAME_PREFIX_SIZE);
+    uint32_t length = static_cast<uint32_t>(prefix[0]) | (static_cast<uint32_t>(prefix[1]) << 8) |
+        (static_cast<uint32_t>(prefix[2]) << 16) | (static_cast<uint32_t>(prefix[3]) << 24);
+
+    if (length < HEADER_SIZE || length > MAX_FRAME_SIZE) return DecodeStatus::Malformed;
+    if (buffer.size() < FRAME_PREFIX_SIZE + length) return DecodeStatus::NeedMoreData;
+
+    const uint8_t* data = buffer.contiguous(FRAME_PREFIX_SIZE + length);
+    DecodeStatus status = decodePayload(data + FRAME_PREFIX_SIZE, length, frame);
+    if (status == DecodeStatus::Frame) currentFrameSize = FRAME_PREFIX_SIZE + length;
+    return status;
+}
+
+void StreamDecoder::reset() {
+    buffer.clear();
+    currentFrameSize = 0;
+}
+
+void StreamDecoder::releaseCurrentFrame() {
+    if (currentFrameSize == 0) return;
+    buffer.consume(currentFrameSize);
+    currentFrameSize = 0;
+}
+
+}  // namespace SnapshotProtocol
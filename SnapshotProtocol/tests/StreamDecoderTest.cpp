@@ -0,0 +1,288 @@
+#include "TestCheck.h"
+#include <SnapshotProtocol/ByteRingBuffer.h>
+#include <SnapshotProtocol/StreamDecoder.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace SnapshotProtocol;
+
+namespace {
+
+typedef std::vector<uint8_t> Bytes;
+
+void putU16(Bytes& out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void putU32(Bytes& out, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) out.push_back(static_cast<uint8_t>(value >> shift));
+}
+
+void putVarint(Bytes& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+Bytes header(MessageType type, uint32_t tick) {
+    Bytes out;
+    putU16(out, MAGIC);
+    out.push_back(VERSION);
+    out.push_back(static_cast<uint8_t>(type));
+    putU32(out, tick);
+    return out;
+}
+
+// Keyframe payload with units id, id + 1, ... at (id, 2 * id), hp 3, alternating teams
+Bytes keyframePayload(uint32_t tick, uint32_t firstId, uint32_t count) {
+    Bytes out = header(MessageType::Keyframe, tick);
+    putVarint(out, 64);
+    putVarint(out, count);
+    for (uint32_t id = firstId; id < firstId + count; ++id) {
+        putVarint(out, id);
+        putU16(out, static_cast<uint16_t>(id));
+        putU16(out, static_cast<uint16_t>(2 * id));
+        putVarint(out, 3);
+        out.push_back(id % 2 == 0 ? 1 : 0);
+    }
+    return out;
+}
+
+Bytes frame(const Bytes& payload) {
+    Bytes out;
+    out.reserve(FRAME_PREFIX_SIZE + payload.size());
+    putU32(out, static_cast<uint32_t>(payload.size()));
+    out.insert(out.end(), payload.begin(), payload.end());
+    return out;
+}
+
+void checkKeyframe(const FrameView& view, uint32_t tick, uint32_t firstId, uint32_t count) {
+    CHECK(view.type == MessageType::Keyframe);
+    CHECK(view.tick == tick);
+    CHECK(view.gridSize == 64);
+    CHECK(view.unitCount == count);
+
+    UnitCursor units = view.units();
+    UnitView unit;
+    uint32_t expected = firstId;
+    while (units.next(unit)) {
+        CHECK(unit.id == expected);
+        CHECK(unit.fieldMask == FIELD_ALL);
+        CHECK(unit.x == expected && unit.y == 2 * expected && unit.hp == 3);
+        CHECK(unit.isRed == (expected % 2 == 0));
+        ++expected;
+    }
+    CHECK(expected == firstId + count);
+}
+
+void testSplitFrame() {
+    // One byte at a time: nothing comes out until the last byte is in
+    Bytes bytes = frame(keyframePayload(7, 1, 3));
+    StreamDecoder decoder(64);
+    FrameView view;
+    for (size_t i = 0; i + 1 < bytes.size(); ++i) {
+        decoder.append(&bytes[i], 1);
+        CHECK(decoder.next(view) == DecodeStatus::NeedMoreData);
+    }
+    decoder.append(&bytes.back(), 1);
+    CHECK(decoder.next(view) == DecodeStatus::Frame);
+    checkKeyframe(view, 7, 1, 3);
+    CHECK(decoder.next(view) == DecodeStatus::NeedMoreData);
+    CHECK(decoder.bufferedBytes() == 0);
+}
+
+void testCoalescedFrames() {
+    Bytes bytes;
+    for (uint32_t tick = 1; tick <= 3; ++tick) {
+        Bytes one = frame(keyframePayload(tick, tick * 10, tick));
+        bytes.insert(bytes.end(), one.begin(), one.end());
+    }
+    // Half of a fourth frame stays buffered
+    Bytes partial = frame(keyframePayload(4, 1, 2));
+    bytes.insert(bytes.end(), partial.begin(), partial.begin() + partial.size() / 2);
+
+    StreamDecoder decoder(64);
+    decoder.append(bytes.data(), bytes.size());
+    FrameView view;
+    for (uint32_t tick = 1; tick <= 3; ++tick) {
+        CHECK(decoder.next(view) == DecodeStatus::Frame);
+        checkKeyframe(view, tick, tick * 10, tick);
+    }
+    CHECK(decoder.next(view) == DecodeStatus::NeedMoreData);
+    CHECK(decoder.bufferedBytes() == partial.size() / 2);
+}
+
+void testFrameAcrossRingWrap() {
+    // 64-byte ring: a 42-byte frame plus 10 bytes of the next, then the rest
+    // of the next, which runs past the end of storage
+    Bytes first = frame(keyframePayload(1, 1, 4));
+    Bytes second = frame(keyframePayload(2, 5, 4));
+    CHECK(first.size() == 42 && second.size() == 42);
+
+    StreamDecoder decoder(64);
+    FrameView view;
+    decoder.append(first.data(), first.size());
+    decoder.append(second.data(), 10);
+    CHECK(decoder.next(view) == DecodeStatus::Frame);
+    checkKeyframe(view, 1, 1, 4);
+
+    // Filled like a recv loop: as much as each writable region takes, which
+    // ends at the end of storage and then continues at the front
+    size_t offset = 10;
+    size_t writes = 0;
+    while (offset < second.size()) {
+        size_t writable = 0;
+        uint8_t* dest = decoder.prepareWrite(1, writable);
+        size_t chunk = std::min(writable, second.size() - offset);
+        std::memcpy(dest, second.data() + offset, chunk);
+        decoder.commitWrite(chunk);
+        offset += chunk;
+        ++writes;
+    }
+    CHECK(writes == 2);
+    CHECK(decoder.next(view) == DecodeStatus::Frame);
+    checkKeyframe(view, 2, 5, 4);
+}
+
+void testRingBufferWrapAndGrowth() {
+    ByteRingBuffer ring(64);
+    uint8_t bytes[100];
+    for (int i = 0; i < 100; ++i) bytes[i] = static_cast<uint8_t>(i);
+
+    ring.write(bytes, 50);
+    ring.consume(40);
+    // 10 readable at 40..49; these 30 wrap around the end of storage
+    size_t writable = 0;
+    uint8_t* dest = ring.prepareWrite(14, writable);
+    CHECK(writable == 14);
+    std::memcpy(dest, bytes + 50, 14);
+    ring.commitWrite(14);
+    dest = ring.prepareWrite(16, writable);
+    CHECK(writable == 40);  // Up to head, at the front of storage
+    std::memcpy(dest, bytes + 64, 16);
+    ring.commitWrite(16);
+    CHECK(ring.size() == 40 && ring.capacity() == 64);
+
+    uint8_t peeked[40];
+    ring.peek(0, peeked, 40);
+    CHECK(std::memcmp(peeked, bytes + 40, 40) == 0);
+    const uint8_t* block = ring.contiguous(40);
+    CHECK(std::memcmp(block, bytes + 40, 40) == 0);
+
+    // More than the free space: grows to the next power of two, keeping the data
+    ring.write(bytes, 100);
+    CHECK(ring.size() == 140 && ring.capacity() == 256);
+    block = ring.contiguous(140);
+    CHECK(std::memcmp(block, bytes + 40, 40) == 0);
+    CHECK(std::memcmp(block + 40, bytes, 100) == 0);
+
+    ring.consume(140);
+    CHECK(ring.empty());
+}
+
+void testLengthOutOfRange() {
+    FrameView view;
+
+    StreamDecoder shortFrame(64);
+    Bytes tooShort;
+    putU32(tooShort, HEADER_SIZE - 1);
+    tooShort.resize(tooShort.size() + HEADER_SIZE - 1, 0);
+    shortFrame.append(tooShort.data(), tooShort.size());
+    CHECK(shortFrame.next(view) == DecodeStatus::Malformed);
+
+    // Rejected from the prefix alone, without waiting for the body
+    StreamDecoder longFrame(64);
+    Bytes tooLong;
+    putU32(tooLong, MAX_FRAME_SIZE + 1);
+    longFrame.append(tooLong.data(), tooLong.size());
+    CHECK(longFrame.next(view) == DecodeStatus::Malformed);
+}
+
+void testTrailingBytes() {
+    Bytes payload = keyframePayload(3, 1, 1);
+    payload.push_back(0);
+    FrameView view;
+    CHECK(decodePayload(payload.data(), payload.size(), view) == DecodeStatus::Malformed);
+
+    StreamDecoder decoder(64);
+    Bytes bytes = frame(payload);
+    decoder.append(bytes.data(), bytes.size());
+    CHECK(decoder.next(view) == DecodeStatus::Malformed);
+}
+
+void testTruncatedVarints() {
+    FrameView view;
+
+    // Unit count whose continuation bit runs into the end of the payload
+    Bytes cutShort = header(MessageType::Delta, 1);
+    cutShort.push_back(0x80);
+    CHECK(decodePayload(cutShort.data(), cutShort.size(), view) == DecodeStatus::Malformed);
+
+    // Removed ID list cut off inside its last ID
+    Bytes cutId = header(MessageType::Delta, 1);
+    putVarint(cutId, 0);
+    putVarint(cutId, 2);
+    putVarint(cutId, 300);
+    cutId.push_back(0xFF);
+    CHECK(decodePayload(cutId.data(), cutId.size(), view) == DecodeStatus::Malformed);
+
+    // Six bytes is longer than any 32-bit varint
+    Bytes tooLong = header(MessageType::Delta, 1);
+    for (int i = 0; i < 5; ++i) tooLong.push_back(0x80);
+    tooLong.push_back(0x01);
+    putVarint(tooLong, 0);
+    CHECK(decodePayload(tooLong.data(), tooLong.size(), view) == DecodeStatus::Malformed);
+
+    // The same delta, well formed, decodes
+    Bytes valid = header(MessageType::Delta, 1);
+    putVarint(valid, 0);
+    putVarint(valid, 2);
+    putVarint(valid, 300);
+    putVarint(valid, 5);
+    CHECK(decodePayload(valid.data(), valid.size(), view) == DecodeStatus::Frame);
+    IdCursor removed = view.removedIds();
+    uint32_t id = 0;
+    CHECK(removed.next(id) && id == 300);
+    CHECK(removed.next(id) && id == 5);
+    CHECK(!removed.next(id));
+}
+
+void testPreviousFrameReleasedOnNext() {
+    Bytes first = frame(keyframePayload(1, 1, 2));
+    Bytes second = frame(keyframePayload(2, 3, 2));
+    Bytes bytes = first;
+    bytes.insert(bytes.end(), second.begin(), second.end());
+
+    StreamDecoder decoder(64);
+    decoder.append(bytes.data(), bytes.size());
+    FrameView view;
+    CHECK(decoder.next(view) == DecodeStatus::Frame);
+    // The returned frame stays in the buffer while the caller reads it
+    CHECK(decoder.bufferedBytes() == bytes.size());
+    checkKeyframe(view, 1, 1, 2);
+
+    CHECK(decoder.next(view) == DecodeStatus::Frame);
+    CHECK(decoder.bufferedBytes() == second.size());
+    checkKeyframe(view, 2, 3, 2);
+
+    CHECK(decoder.next(view) == DecodeStatus::NeedMoreData);
+    CHECK(decoder.bufferedBytes() == 0);
+}
+
+}  // namespace
+
+int main() {
+    testSplitFrame();
+    testCoalescedFrames();
+    testFrameAcrossRingWrap();
+    testRingBufferWrapAndGrowth();
+    testLengthOutOfRange();
+    testTrailingBytes();
+    testTruncatedVarints();
+    testPreviousFrameReleasedOnNext();
+    return TestCheck::testResult("StreamDecoderTest");
+}
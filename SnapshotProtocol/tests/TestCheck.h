@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal assertions for the test executables: a failed CHECK prints where
+// it failed and the test keeps going, then main returns testResult().
+namespace TestCheck {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline int testResult(const char* name) {
+    if (failures() == 0) std::printf("%s: all checks passed\n", name);
+    else std::printf("%s: %d check(s) failed\n", name, failures());
+    return failures() == 0 ? 0 : 1;
+}
+
+}  // namespace TestCheck
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++TestCheck::failures(); \
+        } \
+    } while (0)
@@ -7,6 +7,7 @@
 #include "Async/Async.h"
 #include "Blueprint/UserWidget.h"
 #include "Components/LineBatchComponent.h"
+#include "SnapshotProtocol/ClientMessages.h"
 
 // Sets default values
 ABallSimulationActor::ABallSimulationActor()
@@ -20,7 +21,6 @@ ABallSimulationActor::ABallSimulationActor()
     bIsInitialized = false;
     
     Socket = nullptr;
-    RecvBuffer.SetNumUninitialized(16384);
 }
 
 // Called when the game starts
@@ -68,6 +68,7 @@ void ABallSimulationActor::ConnectToServer()
         SocketSub->DestroySocket(Socket);
         Socket = nullptr;
     }
+    Decoder.reset();
 
     Socket = SocketSub->CreateSocket(NAME_Stream, TEXT("BallSimulation"), false);
     Socket->SetNonBlocking(true);
@@ -86,116 +87,149 @@ void ABallSimulationActor::ConnectToServer()
     }
 }
 
-// Receive data from the server
-void ABallSimulationActor::ReceiveData()
+// Send the visible cell rectangle; the server then streams only the units inside it
+void ABallSimulationActor::SendViewport(int32 MinX, int32 MinY, int32 MaxX, int32 MaxY)
 {
     if (!Socket || Socket->GetConnectionState() != SCS_Connected)
         return;
 
-    uint8 Buffer[1024];
-    int32 BytesRead = 0;
+    uint8 Message[SnapshotProtocol::VIEWPORT_FRAME_SIZE];
+    SnapshotProtocol::encodeViewport(Message, uint16(FMath::Clamp(MinX, 0, 65535)), uint16(FMath::Clamp(MinY, 0, 65535)),
+        uint16(FMath::Clamp(MaxX, MinX, 65535)), uint16(FMath::Clamp(MaxY, MinY, 65535)));
 
-    if (!Socket->Recv(Buffer, sizeof(Buffer), BytesRead))
+    int32 BytesSent = 0;
+    if (!Socket->Send(Message, int32(sizeof(Message)), BytesSent) || BytesSent != int32(sizeof(Message)))
     {
-        UE_LOG(LogTemp, Warning, TEXT("Lost connection to server."));
-        StopSocketThread();
-        return;
+        UE_LOG(LogTemp, Warning, TEXT("Failed to send viewport to server."));
     }
+}
 
-    FString ReceivedString = FString(ANSI_TO_TCHAR(reinterpret_cast<const char*>(Buffer)));
+// Receive data from the server
+void ABallSimulationActor::ReceiveData()
+{
+    if (!Socket || Socket->GetConnectionState() != SCS_Connected)
+        return;
 
-    // Handle initialization first, then handle updates
-    if (!bIsInitialized)
+    // Drain everything the socket has buffered; frames may span several reads
+    constexpr size_t MinRecvSize = 16384;
+    int32 BytesRead = 0;
+    size_t Writable = 0;
+    do
     {
-        InitializeClient(ReceivedString);
-    }
-    else
+        uint8* Dest = Decoder.prepareWrite(MinRecvSize, Writable);
+        const int32 RecvSize = int32(FMath::Min<size_t>(Writable, MAX_int32));
+        if (!Socket->Recv(Dest, RecvSize, BytesRead))
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Lost connection to server."));
+            StopSocketThread();
+            return;
+        }
+        if (BytesRead > 0)
+        {
+            Decoder.commitWrite(BytesRead);
+        }
+    } while (BytesRead > 0 && size_t(BytesRead) == Writable);
+
+    SnapshotProtocol::FrameView Frame;
+    SnapshotProtocol::DecodeStatus Status;
+    while ((Status = Decoder.next(Frame)) == SnapshotProtocol::DecodeStatus::Frame)
     {
-        if(!ReceivedString.IsEmpty())
+        switch (Frame.type)
+        {
+        case SnapshotProtocol::MessageType::Keyframe:
+            ApplyKeyframe(Frame);
+            break;
+        case SnapshotProtocol::MessageType::Delta:
+        case SnapshotProtocol::MessageType::ViewDelta:
+            ApplyDelta(Frame);
+            break;
+        case SnapshotProtocol::MessageType::GameOver:
         {
-            ParseSimulationData(ReceivedString);
+            FUTF8ToTCHAR Converted(Frame.text, int32(Frame.textLength));
+            HandleGameOver(FString(Converted.Length(), Converted.Get()));
+            break;
+        }
+        default:
+            break;
         }
-       
+    }
+
+    if (Status == SnapshotProtocol::DecodeStatus::Malformed)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Malformed snapshot frame received; dropping connection."));
+        Decoder.reset();
+        StopSocketThread();
     }
 }
 
-// Step 1: Initialize client with grid size and ball data
-void ABallSimulationActor::InitializeClient(const FString& Data)
+// Full state: sets up the grid on first receipt and replaces every ball
+void ABallSimulationActor::ApplyKeyframe(const SnapshotProtocol::FrameView& Frame)
 {
     FScopeLock Lock(&DataMutex);
 
-    TArray<FString> Params;
-    Data.ParseIntoArray(Params, TEXT(";"), true);
+    const int32 NewGridSize = int32(Frame.gridSize);
+    const bool bGridChanged = NewGridSize != GridSize;
+    GridSize = NewGridSize;
 
-    if (Params.Num() < 2)
-    {
-        UE_LOG(LogTemp, Error, TEXT("Invalid initialization data received: %s"), *Data);
-        return;
+    TSet<int> ExistingBallIDs;
+    for (const auto& BallPair : Balls) {
+        ExistingBallIDs.Add(BallPair.Key);
     }
 
-    for (const FString& Entry : Params)
+    SnapshotProtocol::UnitCursor Units = Frame.units();
+    SnapshotProtocol::UnitView Unit;
+    while (Units.next(Unit))
     {
-        TArray<FString> KeyValue;
-        Entry.ParseIntoArray(KeyValue, TEXT("="), true);
+        const int32 BallID = int32(Unit.id);
+        FVector NewPosition = FVector(
+            FMath::Clamp(int32(Unit.x), 0, GridSize - 1) * 100,
+            FMath::Clamp(int32(Unit.y), 0, GridSize - 1) * 100,
+            0
+        );
 
-        if (KeyValue.Num() == 2)
+        if (FBallState* Ball = Balls.Find(BallID))
         {
-            FString Key = KeyValue[0];
-            FString Value = KeyValue[1];
-
-            if (Key == "GridSize")
+            //  Update existing Ball data
+            if (Ball->Position != NewPosition)
             {
-                GridSize = FCString::Atoi(*Value);
-                continue; //  Skip to next iteration
+                Ball->PrevPosition = Ball->Position;
+                Ball->Position = NewPosition;
             }
+            Ball->HP = int32(Unit.hp);
+            Ball->bIsRed = Unit.isRed;
         }
         else
         {
-            //  Process Ball Data (Assuming: "ID,X,Y,HP,Team")
-            TArray<FString> BallParams;
-            Entry.ParseIntoArray(BallParams, TEXT(","), true);
-
-            if (BallParams.Num() < 5) continue;
-
-            int BallID = FCString::Atoi(*BallParams[0]); //  Get unique Ball ID
-
-            FVector NewPosition = FVector(
-                FMath::Clamp(FCString::Atoi(*BallParams[1]), 0, GridSize - 1) * 100,
-                FMath::Clamp(FCString::Atoi(*BallParams[2]), 0, GridSize - 1) * 100,
-                0
-            );
+            //  Create new Ball and add to map
+            FBallState NewBall;
+            NewBall.PrevPosition = NewPosition;
+            NewBall.Position = NewPosition;
+            NewBall.HP = int32(Unit.hp);
+            NewBall.bIsRed = Unit.isRed;
 
-            if (Balls.Contains(BallID))
-            {
-                //  Update existing Ball data
-                FBallState& Ball = Balls[BallID];
-                Ball.PrevPosition = Ball.Position;
-                Ball.Position = NewPosition;
-                Ball.HP = FCString::Atoi(*BallParams[3]);
-                Ball.bIsRed = FCString::Atoi(*BallParams[4]) == 1;
-            }
-            else
-            {
-                //  Create new Ball and add to map
-                FBallState NewBall;
-                NewBall.PrevPosition = NewPosition;
-                NewBall.Position = NewPosition;
-                NewBall.HP = FCString::Atoi(*BallParams[3]);
-                NewBall.bIsRed = FCString::Atoi(*BallParams[4]) == 1;
-
-                Balls.Add(BallID, NewBall);
-            }
+            Balls.Add(BallID, NewBall);
         }
+        ExistingBallIDs.Remove(BallID);
     }
 
-    if (GridSize > 0)
+    //  A keyframe is authoritative: anything it does not mention is gone
+    for (int RemovedID : ExistingBallIDs) {
+        Balls.Remove(RemovedID);
+    }
+
+    if (GridSize > 0 && (bGridChanged || !bIsInitialized))
     {
         PreallocateGridLines();
         DrawGrid();
     }
 
-    UE_LOG(LogTemp, Log, TEXT("Client Initialized - GridSize: %d, BallCount: %d"), GridSize, Balls.Num());
-    bIsInitialized = true;
+    if (!bIsInitialized)
+    {
+        UE_LOG(LogTemp, Log, TEXT("Client Initialized - GridSize: %d, BallCount: %d"), GridSize, Balls.Num());
+        bIsInitialized = true;
+    }
+
+    bNewDataAvailable = true;
 }
 
 
@@ -223,94 +257,71 @@ void ABallSimulationActor::ShowGameOverWidget(const FString& WinningTeamMessage)
     }
 }
 
-// Step 2: Parse simulation updates & remove dead balls
-void ABallSimulationActor::ParseSimulationData(const FString& Data) {
+void ABallSimulationActor::HandleGameOver(const FString& WinningTeamMessage)
+{
     FScopeLock Lock(&DataMutex);
 
-    if (Data.Contains("GameOver:")) {
-        int32 GameOverIndex = Data.Find("GameOver:");
-        FString WinningTeamMessage = Data.RightChop(GameOverIndex + 9);  // Extract only the team name
-
-        // Remove any extra data after the team name
-        int32 EndIndex;
-        if (WinningTeamMessage.FindChar(';', EndIndex)) {
-            WinningTeamMessage = WinningTeamMessage.Left(EndIndex);
-        }
-
-        // Clear all balls since the game is over
-        Balls.Empty();
-
-        // Log the cleaned-up game over message
-        UE_LOG(LogTemp, Warning, TEXT("[Client] GAME OVER! %s"), *WinningTeamMessage);
-
-        // Show Game Over UI
-        ShowGameOverWidget(WinningTeamMessage);
-        // Log game over event
-        UE_LOG(LogTemp, Warning, TEXT("[Client] GAME OVER! %s"), *WinningTeamMessage);
-
-        //  Show Game Over Widget
-        ShowGameOverWidget(WinningTeamMessage);
-    
-        return;
-    }
+    // Clear all balls since the game is over
+    Balls.Empty();
 
-    TArray<FString> Updates;
-    Data.ParseIntoArray(Updates, TEXT(";"), true);
+    UE_LOG(LogTemp, Warning, TEXT("[Client] GAME OVER! %s"), *WinningTeamMessage);
 
-    //  Track existing balls before processing new data
-    TSet<int> ExistingBallIDs;
-    for (const auto& BallPair : Balls) {
-        ExistingBallIDs.Add(BallPair.Key);
-    }
+    //  Show Game Over Widget
+    ShowGameOverWidget(WinningTeamMessage);
+}
 
-    for (const FString& Entry : Updates) {
-        TArray<FString> BallParams;
-        Entry.ParseIntoArray(BallParams, TEXT(","), true);
-        if (BallParams.Num() < 5) continue;
+// Only the fields flagged in each entry's mask changed since the previous frame
+void ABallSimulationActor::ApplyDelta(const SnapshotProtocol::FrameView& Frame)
+{
+    FScopeLock Lock(&DataMutex);
 
-        int BallID = FCString::Atoi(*BallParams[0]);
-        FVector NewPosition(
-            FCString::Atoi(*BallParams[1]) * 100,
-            FCString::Atoi(*BallParams[2]) * 100,
-            0
-        );
-        int NewHP = FCString::Atoi(*BallParams[3]);
+    SnapshotProtocol::UnitCursor Units = Frame.units();
+    SnapshotProtocol::UnitView Unit;
+    while (Units.next(Unit))
+    {
+        const int32 BallID = int32(Unit.id);
+        const FVector NewPosition(int32(Unit.x) * 100, int32(Unit.y) * 100, 0);
 
-        //  If HP is zero, remove the ball
-        if (NewHP <= 0) {
-            if (Balls.Contains(BallID)) {
-                UE_LOG(LogTemp, Warning, TEXT("[Client] Ball ID %d removed (HP 0)."), BallID);
-                Balls.Remove(BallID);
-            }
-            continue; // Skip further processing for this ball
+        FBallState* Ball = Balls.Find(BallID);
+        if (!Ball)
+        {
+            //  Add new ball if it doesn't exist
+            Ball = &Balls.Add(BallID, FBallState());
+            Ball->PrevPosition = NewPosition;
+            Ball->Position = NewPosition;
         }
 
-        if (Balls.Contains(BallID)) {
-            FBallState& Ball = Balls[BallID];
-
-            if (Ball.Position != NewPosition) {
-                Ball.PrevPosition = Ball.Position; //  Keep for interpolation
-                Ball.Position = NewPosition;
-            }
-            Ball.HP = NewHP;
-        } else {
-            //  Add new ball if it doesn’t exist
-            FBallState NewBall;
-            NewBall.PrevPosition = NewPosition;
-            NewBall.Position = NewPosition;
-            NewBall.HP = NewHP;
-            NewBall.bIsRed = FCString::Atoi(*BallParams[4]) == 1;
-            Balls.Add(BallID, NewBall);
+        if ((Unit.fieldMask & SnapshotProtocol::FIELD_POSITION) && Ball->Position != NewPosition)
+        {
+            Ball->PrevPosition = Ball->Position; //  Keep for interpolation
+            Ball->Position = NewPosition;
         }
+        if (Unit.fieldMask & SnapshotProtocol::FIELD_HP)
+        {
+            Ball->HP = int32(Unit.hp);
+        }
+        if (Unit.fieldMask & SnapshotProtocol::FIELD_TEAM)
+        {
+            Ball->bIsRed = Unit.isRed;
+        }
+    }
 
-        //  Mark BallID as still existing
-        ExistingBallIDs.Remove(BallID);
+    SnapshotProtocol::IdCursor RemovedIds = Frame.removedIds();
+    uint32 RemovedID;
+    while (RemovedIds.next(RemovedID))
+    {
+        if (Balls.Remove(int32(RemovedID)) > 0)
+        {
+            UE_LOG(LogTemp, Log, TEXT("[Client] Ball ID %d removed."), int32(RemovedID));
+        }
     }
 
-    //  Remove balls that no longer exist in server updates
-    for (int RemovedID : ExistingBallIDs) {
-        UE_LOG(LogTemp, Warning, TEXT("[Client] Ball ID %d removed (Not in server data)."), RemovedID);
-        Balls.Remove(RemovedID);
+    //  Still alive, just outside the viewport
+    SnapshotProtocol::IdCursor LeftIds = Frame.leftIds();
+    uint32 LeftID;
+    while (LeftIds.next(LeftID))
+    {
+        Balls.Remove(int32(LeftID));
     }
 
     bNewDataAvailable = true; //  Trigger Tick update
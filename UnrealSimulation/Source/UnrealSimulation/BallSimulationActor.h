@@ -5,6 +5,7 @@
 #include "GameFramework/Actor.h"
 #include "HAL/Runnable.h"
 #include "Json.h"
+#include "SnapshotProtocol/StreamDecoder.h"
 #include "BallSimulationActor.generated.h"
 
 class UUGameOverWidget;
@@ -48,14 +49,16 @@ public:
 	void StopSocketThread();
 	void ConnectToServer();
 	void ReceiveData();
+	// Asks the server for only the units inside this inclusive cell rectangle
+	// (plus its margin); call again whenever the view moves
+	void SendViewport(int32 MinX, int32 MinY, int32 MaxX, int32 MaxY);
     
-	// Handling Initialization
-	void InitializeClient(const FString& Data);
+	// Handling snapshot frames (binary protocol, see SnapshotProtocol/WireFormat.h)
+	void ApplyKeyframe(const SnapshotProtocol::FrameView& Frame);
+	void ApplyDelta(const SnapshotProtocol::FrameView& Frame);  // Also ViewDelta frames
+	void HandleGameOver(const FString& WinningTeamMessage);
 	void ShowGameOverWidget(const FString& WinningTeamMessage);
 
-	// Handling Simulation Updates
-	void ParseSimulationData(const FString& Data);
-
 	// Visualization
 	void DrawBalls();
 	void DrawGrid();
@@ -73,7 +76,9 @@ private:
 	TSubclassOf<UUGameOverWidget> GameOverWidgetClass;
 	
 	FSocket* Socket;
-	TArray<uint8> RecvBuffer;
+
+	// Reassembles length-prefixed frames; Recv writes straight into its buffer
+	SnapshotProtocol::StreamDecoder Decoder;
     
 	// Mutex for thread safety
 	FCriticalSection DataMutex;
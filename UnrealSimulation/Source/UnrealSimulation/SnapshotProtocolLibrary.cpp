@@ -0,0 +1,10 @@
+// Compiles the portable SnapshotProtocol library (repository root) into this module.
+// The library has no engine dependencies, so its sources are included verbatim.
+
+#include "CoreMinimal.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "../../../SnapshotProtocol/src/ByteRingBuffer.cpp"
+#include "../../../SnapshotProtocol/src/DatagramAssembler.cpp"
+#include "../../../SnapshotProtocol/src/StreamDecoder.cpp"
+THIRD_PARTY_INCLUDES_END
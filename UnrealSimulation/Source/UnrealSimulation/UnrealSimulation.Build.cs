@@ -1,5 +1,6 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
+using System.IO;
 using UnrealBuildTool;
 
 public class UnrealSimulation : ModuleRules
@@ -13,6 +14,10 @@ public class UnrealSimulation : ModuleRules
 		
 		PrivateDependencyModuleNames.AddRange(new string[] {
 		});
+
+		// Engine-independent snapshot decoder shared with the simulation server;
+		// its sources are compiled into this module by SnapshotProtocolLibrary.cpp
+		PublicIncludePaths.Add(Path.Combine(ModuleDirectory, "../../../SnapshotProtocol/include"));
 		
 		
 		// Uncomment if you are using Slate UI